@@ -0,0 +1,221 @@
+/*
+ * Logging cost on a decode loop
+ *
+ * Runs a decode-like loop (one matrix-vector product per token) that logs
+ * every token, the way the translation worker used to, three ways: logging
+ * off, through the asynchronous logger, and with a synchronous flushed
+ * fprintf per message (what std::endl did). Then times producer-side calls
+ * from several threads at once. With a translation model, also translates a
+ * set of sentences with the engine's logs at debug vs off (debug messages
+ * are compiled out of NDEBUG builds, so build this benchmark in Debug for
+ * that comparison).
+ *
+ * Log output goes to stderr; point it at a pipe or file for numbers that
+ * resemble running under Electron:
+ *   bench_logger [TRANSLATION_MODEL.gguf] 2>/tmp/bench_logger.log
+ */
+#include "logger.h"
+#include "translation_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define DECODE_DIM 128
+#define DECODE_TOKENS 100000
+#define PRODUCER_THREADS 4
+#define PRODUCER_CALLS 100000
+#define PRODUCER_BURST 32      /* Calls per millisecond per thread, well under what the writer drains */
+
+static const char *sentences[] = {
+    "Hello, how are you?",
+    "The meeting has been moved to Thursday afternoon.",
+    "Could you send me the slides after the call?",
+    "We should have the results by the end of the week.",
+    "I think the second option is cheaper in the long run.",
+    "Please speak a little louder, the sound is breaking up.",
+};
+#define N_SENTENCES (sizeof(sentences) / sizeof(sentences[0]))
+#define SENTENCE_ROUNDS 5
+
+typedef enum { MODE_OFF, MODE_ASYNC, MODE_SYNC } log_mode_t;
+static const char *mode_names[] = { "off", "async", "sync fprintf+flush" };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* One "decode step": y = W x, then pick the argmax as the next token */
+static int decode_step(const float *w, float *x, float *y) {
+    int best = 0;
+    for (int i = 0; i < DECODE_DIM; i++) {
+        float acc = 0.0f;
+        const float *row = w + (size_t)i * DECODE_DIM;
+        for (int j = 0; j < DECODE_DIM; j++) {
+            acc += row[j] * x[j];
+        }
+        y[i] = acc;
+        if (acc > y[best]) best = i;
+    }
+    for (int i = 0; i < DECODE_DIM; i++) {
+        x[i] = y[i] * 0.001f + (i == best ? 1.0f : 0.0f);
+    }
+    return best;
+}
+
+static void bench_decode(log_mode_t mode) {
+    float *w = malloc((size_t)DECODE_DIM * DECODE_DIM * sizeof(float));
+    float *x = malloc(DECODE_DIM * sizeof(float));
+    float *y = malloc(DECODE_DIM * sizeof(float));
+    if (!w || !x || !y) {
+        free(w);
+        free(x);
+        free(y);
+        return;
+    }
+    for (size_t i = 0; i < (size_t)DECODE_DIM * DECODE_DIM; i++) {
+        w[i] = (float)((i * 2654435761u) >> 20) / 4096.0f - 0.5f;
+    }
+    for (int i = 0; i < DECODE_DIM; i++) x[i] = 1.0f / DECODE_DIM;
+
+    logger_set_level(mode == MODE_ASYNC ? LOG_LEVEL_DEBUG : LOG_LEVEL_OFF);
+
+    double t0 = now_sec();
+    int checksum = 0;
+    for (int t = 0; t < DECODE_TOKENS; t++) {
+        const int token = decode_step(w, x, y);
+        checksum += token;
+        if (mode == MODE_ASYNC) {
+            LOG_INFO("[Bench] token %d: %d (%d generated)\n", t, token, t + 1);
+        } else if (mode == MODE_SYNC) {
+            fprintf(stderr, "[Bench] token %d: %d (%d generated)\n", t, token, t + 1);
+            fflush(stderr);
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    printf("decode  log %-20s %9.0f tokens/s  (checksum %d)\n", mode_names[mode],
+           DECODE_TOKENS / elapsed, checksum);
+
+    free(w);
+    free(x);
+    free(y);
+}
+
+static void* producer(void *arg) {
+    double *ns_per_call = (double *)arg;
+    double busy = 0.0;
+    for (int i = 0; i < PRODUCER_CALLS; i += PRODUCER_BURST) {
+        double t0 = now_sec();
+        for (int j = i; j < i + PRODUCER_BURST; j++) {
+            LOG_INFO("[Bench] producer message %d with a float %.3f\n", j, j * 0.5);
+        }
+        busy += now_sec() - t0;
+
+        struct timespec pause = { 0, 1000000 };
+        nanosleep(&pause, NULL);
+    }
+    *ns_per_call = busy * 1e9 / PRODUCER_CALLS;
+    return NULL;
+}
+
+static void bench_producers(void) {
+    logger_set_level(LOG_LEVEL_DEBUG);
+    const unsigned long dropped_before = logger_dropped();
+
+    pthread_t threads[PRODUCER_THREADS];
+    double ns[PRODUCER_THREADS] = {0};
+    for (int i = 0; i < PRODUCER_THREADS; i++) {
+        pthread_create(&threads[i], NULL, producer, &ns[i]);
+    }
+    double sum = 0.0;
+    for (int i = 0; i < PRODUCER_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        sum += ns[i];
+    }
+
+    printf("logger  %d threads x %d calls:   %6.0f ns/call, %lu dropped (ring full)\n",
+           PRODUCER_THREADS, PRODUCER_CALLS, sum / PRODUCER_THREADS, logger_dropped() - dropped_before);
+}
+
+/* Translation throughput: one sentence at a time, waiting for each result */
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_cv = PTHREAD_COND_INITIALIZER;
+static int done_count = 0;
+
+static void on_translation(const translation_output_t *outputs, size_t num_outputs,
+                           const translation_timing_t *timing, void *user_data) {
+    (void)outputs;
+    (void)num_outputs;
+    (void)timing;
+    (void)user_data;
+    pthread_mutex_lock(&done_lock);
+    done_count++;
+    pthread_cond_signal(&done_cv);
+    pthread_mutex_unlock(&done_lock);
+}
+
+static void bench_translation(translation_engine_t *engine, log_level_t level, const char *label) {
+    logger_set_level(level);
+
+    const char *fr = "fr";
+    double t0 = now_sec();
+    int n = 0;
+    for (int round = 0; round < SENTENCE_ROUNDS; round++) {
+        for (size_t i = 0; i < N_SENTENCES; i++) {
+            pthread_mutex_lock(&done_lock);
+            const int target = done_count + 1;
+            pthread_mutex_unlock(&done_lock);
+
+            if (!translation_translate(engine, sentences[i], "en", &fr, 1, NULL)) continue;
+
+            pthread_mutex_lock(&done_lock);
+            while (done_count < target) {
+                pthread_cond_wait(&done_cv, &done_lock);
+            }
+            pthread_mutex_unlock(&done_lock);
+            n++;
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    printf("translate  log %-6s %6.2f sentences/s  (%.0f ms each)\n", label, n / elapsed, elapsed * 1000.0 / n);
+}
+
+int main(int argc, char **argv) {
+    if (!logger_start()) {
+        fprintf(stderr, "Failed to start the logger\n");
+        return 1;
+    }
+
+    printf("Decode loop, %d x %d matvec per token, one log line per token\n", DECODE_DIM, DECODE_DIM);
+    bench_decode(MODE_OFF);
+    bench_decode(MODE_ASYNC);
+    bench_decode(MODE_SYNC);
+    bench_producers();
+
+    if (argc > 1) {
+        logger_set_level(LOG_LEVEL_INFO);
+        translation_engine_t *engine = translation_init(argv[1], on_translation, NULL);
+        if (!engine) {
+            fprintf(stderr, "Failed to load %s\n", argv[1]);
+            logger_shutdown();
+            return 1;
+        }
+        translation_warm_up(engine);
+
+        printf("\nTranslation (%s), %zu sentences x %d%s\n", argv[1], N_SENTENCES, SENTENCE_ROUNDS,
+               VISUALIA_LOG_MIN_LEVEL > LOG_LEVEL_DEBUG ? " - debug logs compiled out" : "");
+        bench_translation(engine, LOG_LEVEL_OFF, "off");
+        bench_translation(engine, LOG_LEVEL_DEBUG, "debug");
+
+        logger_set_level(LOG_LEVEL_INFO);
+        translation_cleanup(engine);
+    }
+
+    logger_shutdown();
+    return 0;
+}
@@ -0,0 +1,169 @@
+/*
+ * Encoder cost vs segment length (adaptive audio_ctx)
+ *
+ * For each model given on the command line, times whisper_encode on segments
+ * of 1-30 s with the encoder context the engine would pick
+ * (whisper_engine_audio_ctx_for) against the full 30 s window.
+ *
+ * Usage: bench_whisper_encoder [-t THREADS] MODEL.gguf [MODEL.gguf ...]
+ *   e.g. models/whisper-base.gguf models/whisper-small.gguf
+ *        models/whisper-medium.gguf models/whisper-large-v3.gguf
+ */
+#include "whisper_engine.h"
+#include "whisper_mel.h"
+#include "whisper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define BENCH_RUNS 5
+
+static const int segment_ms[] = { 1000, 2000, 3000, 5000, 10000, 20000, 30000 };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* Load a speech-like mel (harmonic tone with noise) for a segment into state */
+static bool load_segment(struct whisper_context *ctx, struct whisper_state *state, whisper_mel_t *mel,
+                         size_t num_samples, int audio_ctx) {
+    const int n_mel = whisper_mel_n_mel(mel);
+    const int n_frames = whisper_mel_frames_for(num_samples);
+    int n_len = (int)((num_samples + (size_t)WHISPER_SAMPLE_RATE * 30) / WHISPER_MEL_HOP);
+    if (audio_ctx > 0 && 2 * audio_ctx < n_len) {
+        n_len = 2 * audio_ctx > n_frames ? 2 * audio_ctx : n_frames;
+    }
+
+    float *samples = malloc(num_samples * sizeof(float));
+    float *frames = malloc((size_t)n_frames * n_mel * sizeof(float));
+    float *input = malloc((size_t)n_len * n_mel * sizeof(float));
+    if (!samples || !frames || !input) {
+        free(samples);
+        free(frames);
+        free(input);
+        return false;
+    }
+
+    for (size_t i = 0; i < num_samples; i++) {
+        double t = (double)i / WHISPER_SAMPLE_RATE;
+        samples[i] = (float)(0.2 * sin(2.0 * 3.14159265358979323846 * 180.0 * t) *
+                             (0.6 + 0.4 * sin(2.0 * 3.14159265358979323846 * 3.0 * t)) +
+                             0.01 * ((double)rand() / RAND_MAX - 0.5));
+    }
+    for (int i = 0; i < n_frames; i++) {
+        whisper_mel_frame(mel, samples, (long)num_samples, (long)i * WHISPER_MEL_HOP, true,
+                          frames + (size_t)i * n_mel);
+    }
+    whisper_mel_normalize(frames, n_frames, n_mel, n_len, input);
+
+    bool ok = whisper_set_mel_with_state(ctx, state, input, n_len, n_mel) == 0;
+
+    free(samples);
+    free(frames);
+    free(input);
+    return ok;
+}
+
+/* Best-of-BENCH_RUNS encoder time in ms; whisper_full sets the state's encoder context */
+static double time_encode(struct whisper_context *ctx, struct whisper_state *state, int n_threads,
+                          size_t num_samples, int audio_ctx) {
+    struct whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = n_threads;
+    params.language = "en";
+    params.max_tokens = 1;
+    params.no_context = true;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.audio_ctx = audio_ctx;
+    params.duration_ms = (int)(num_samples * 1000 / WHISPER_SAMPLE_RATE);
+
+    if (whisper_full_with_state(ctx, state, params, NULL, 0) != 0) {
+        return -1.0;
+    }
+
+    double best = 1e30;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        double t0 = now_sec();
+        if (whisper_encode_with_state(ctx, state, 0, n_threads) != 0) {
+            return -1.0;
+        }
+        double elapsed = (now_sec() - t0) * 1000.0;
+        if (elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+static void bench_model(const char *path, int n_threads) {
+    struct whisper_context_params cparams = whisper_context_default_params();
+    struct whisper_context *ctx = whisper_init_from_file_with_params_no_state(path, cparams);
+    if (!ctx) {
+        fprintf(stderr, "Failed to load %s\n", path);
+        return;
+    }
+
+    struct whisper_state *state = whisper_init_state(ctx);
+    whisper_mel_t *mel = whisper_mel_create(whisper_model_n_mels(ctx));
+    if (!state || !mel) {
+        fprintf(stderr, "Failed to set up %s\n", path);
+        if (state) whisper_free_state(state);
+        whisper_mel_destroy(mel);
+        whisper_free(ctx);
+        return;
+    }
+
+    const int n_audio_ctx = whisper_model_n_audio_ctx(ctx);
+    printf("\n%s (%s, %d threads)\n", path, whisper_model_type_readable(ctx), n_threads);
+    printf("  segment  audio_ctx  encode ms  full-window ms  speedup\n");
+
+    for (size_t i = 0; i < sizeof(segment_ms) / sizeof(segment_ms[0]); i++) {
+        const size_t num_samples = (size_t)segment_ms[i] * WHISPER_SAMPLE_RATE / 1000;
+        const int audio_ctx = whisper_engine_audio_ctx_for(num_samples, WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT,
+                                                           WHISPER_AUDIO_CTX_GUARD_MS_DEFAULT, n_audio_ctx);
+
+        double adaptive = -1.0;
+        double full = -1.0;
+        if (load_segment(ctx, state, mel, num_samples, audio_ctx)) {
+            adaptive = time_encode(ctx, state, n_threads, num_samples, audio_ctx);
+        }
+        if (load_segment(ctx, state, mel, num_samples, 0)) {
+            full = time_encode(ctx, state, n_threads, num_samples, 0);
+        }
+
+        printf("  %5.1f s  %9d  %9.1f  %14.1f  %6.2fx\n", segment_ms[i] / 1000.0,
+               audio_ctx > 0 ? audio_ctx : n_audio_ctx, adaptive, full,
+               adaptive > 0.0 ? full / adaptive : 0.0);
+    }
+
+    whisper_mel_destroy(mel);
+    whisper_free_state(state);
+    whisper_free(ctx);
+}
+
+int main(int argc, char *argv[]) {
+    int n_threads = 4;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        n_threads = atoi(argv[2]);
+        if (n_threads < 1) n_threads = 1;
+        first = 3;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [-t THREADS] MODEL.gguf [MODEL.gguf ...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== VisualIA Whisper encoder benchmark ===\n");
+    printf("audio_ctx: segment + %d ms guard, steps of %d positions\n",
+           WHISPER_AUDIO_CTX_GUARD_MS_DEFAULT, WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT);
+
+    for (int i = first; i < argc; i++) {
+        bench_model(argv[i], n_threads);
+    }
+    return 0;
+}
@@ -0,0 +1,726 @@
+/*
+ * VisualIA benchmark suite
+ *
+ * Reproducible scenarios with machine-readable results, for comparing runs
+ * and catching regressions:
+ *   dsp  int16 -> float32 conversion, resampling and the capture push path
+ *   ipc  transcription, translation and stats messages written to stdout
+ *   asr  Whisper real-time factor per model and thread count on WAV fixtures
+ *   mt   translation tokens/s and per-request latency per batch size
+ *   pipe pipelined decoding gives the same transcript as whole-chunk decoding
+ *
+ * The asr scenario runs each fixture through the engine the way the live
+ * pipeline chunks it (3 s chunks, 1 s overlap), one chunk at a time. The
+ * default fixture is whisper.cpp's samples/jfk.wav. In the mt scenario a
+ * batch is that many requests queued at once; the worker translates them
+ * in order, so per-request latency includes the wait behind the others.
+ * The pipe scenario is a check, not a benchmark (not run by default): any
+ * difference makes the exit status 1.
+ *
+ * Usage: visualia_bench [-o FILE] [-r RUNS] [-s SCENARIOS]
+ *                       [-w WHISPER.gguf]... [-a FIXTURE.wav]... [-t THREADS,...]
+ *                       [-m TRANSLATION.gguf]... [-b BATCH,...] [-l LANG]
+ *   e.g. visualia_bench -w models/whisper-base.gguf -t 1,2,4
+ *                       -m models/mt5-small.gguf -b 1,4,8 -o bench.json
+ *
+ * Results go to FILE (default stdout) as one JSON object; progress and
+ * engine logs go to stderr.
+ */
+#include "audio_dsp.h"
+#include "whisper_engine.h"
+#include "translation_engine.h"
+#include "cpu_budget.h"
+#include "ipc.h"
+#include "logger.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+    #define NULL_DEVICE "NUL"
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define NULL_DEVICE "/dev/null"
+#endif
+
+#define BENCH_MAX_ITEMS 16
+#define BENCH_MAX_RUNS 64
+#define DEFAULT_RUNS 5
+#define DEFAULT_FIXTURE "backend/libs/whisper.cpp/samples/jfk.wav"
+#define SYNTHETIC_SECONDS 11    /* Same length as the default fixture */
+
+#define DSP_SAMPLES (1 << 20)
+#define DSP_BLOCK_MS 10         /* Capture callback size */
+#define DSP_SECONDS 30
+#define IPC_MESSAGES 20000
+
+static const char *sentences[] = {
+    "Hello, how are you?",
+    "The meeting has been moved to Thursday afternoon.",
+    "Could you send me the slides after the call?",
+    "We should have the results by the end of the week.",
+    "I think the second option is cheaper in the long run.",
+    "Please speak a little louder, the sound is breaking up.",
+    "Let's take a short break and continue in ten minutes.",
+    "The new version fixes the crash we saw on startup.",
+};
+#define N_SENTENCES (sizeof(sentences) / sizeof(sentences[0]))
+
+typedef struct {
+    const char *output;
+    int runs;
+    bool dsp, ipc, asr, mt, pipe;
+    const char *whisper_models[BENCH_MAX_ITEMS];
+    int n_whisper_models;
+    const char *fixtures[BENCH_MAX_ITEMS];
+    int n_fixtures;
+    int threads[BENCH_MAX_ITEMS];
+    int n_threads;
+    const char *translation_models[BENCH_MAX_ITEMS];
+    int n_translation_models;
+    int batches[BENCH_MAX_ITEMS];
+    int n_batches;
+    const char *target_lang;
+} bench_config_t;
+
+/* Results are written as they are produced: {"...":...,"results":[{...},...]} */
+static FILE *g_out;
+static int g_results = 0;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* Quantile of n values (sorts them) */
+static double quantile(double *values, int n, double q) {
+    if (n <= 0) return 0.0;
+    qsort(values, (size_t)n, sizeof(double), compare_double);
+    int i = (int)(q * (n - 1) + 0.5);
+    return values[i];
+}
+
+static void write_json_string(const char *s) {
+    fputc('"', g_out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', g_out);
+        if ((unsigned char)*s >= 0x20) fputc(*s, g_out);
+    }
+    fputc('"', g_out);
+}
+
+/* A result is {"scenario":..,"name":..,"params":{..},"metrics":{..}}; the
+ * caller writes the members of params, then of metrics */
+static void begin_result(const char *scenario, const char *name) {
+    fprintf(g_out, "%s\n    {\"scenario\":\"%s\",\"name\":", g_results++ > 0 ? "," : "", scenario);
+    write_json_string(name);
+    fprintf(g_out, ",\"params\":{");
+}
+
+static void result_printf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(g_out, fmt, args);
+    va_end(args);
+}
+
+static void begin_metrics(void) {
+    fprintf(g_out, "},\"metrics\":{");
+}
+
+static void end_result(void) {
+    fprintf(g_out, "}}");
+    fflush(g_out);
+}
+
+/* Parse "1,2,4" */
+static int parse_list(const char *s, int *out, int max) {
+    int n = 0;
+    while (*s && n < max) {
+        char *end;
+        long v = strtol(s, &end, 10);
+        if (end == s || v < 1) return 0;
+        out[n++] = (int)v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') return 0;
+    }
+    return n;
+}
+
+/* ---- WAV fixtures ---- */
+
+static uint32_t read_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t read_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+/* Load a 16-bit PCM WAV as mono float32 at AUDIO_SAMPLE_RATE */
+static float* load_wav(const char *path, size_t *num_samples) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    unsigned char header[12];
+    if (fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    unsigned int rate = 0, channels = 0, bits = 0, format = 0;
+    int16_t *pcm = NULL;
+    size_t frames = 0;
+    unsigned char chunk[8];
+    while (fread(chunk, 1, 8, f) == 8) {
+        const uint32_t size = read_u32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            format = read_u16(fmt);
+            channels = read_u16(fmt + 2);
+            rate = read_u32(fmt + 4);
+            bits = read_u16(fmt + 14);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0 && format == 1 && bits == 16 && channels > 0) {
+            frames = size / (2 * channels);
+            pcm = malloc((size_t)size);
+            if (!pcm || fread(pcm, 1, size, f) != size) {
+                free(pcm);
+                pcm = NULL;
+            }
+            break;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fclose(f);
+    if (!pcm || rate == 0) {
+        free(pcm);
+        return NULL;
+    }
+
+    /* Downmix, then resample in one block */
+    float *mono = malloc(frames * sizeof(float));
+    audio_resampler_t *r = rate != AUDIO_SAMPLE_RATE ? audio_resampler_create(rate, AUDIO_SAMPLE_RATE, frames) : NULL;
+    float *out = r ? malloc(audio_resampler_max_output(r, frames) * sizeof(float)) : NULL;
+    if (!mono || (rate != AUDIO_SAMPLE_RATE && !out)) {
+        free(pcm);
+        free(mono);
+        free(out);
+        audio_resampler_destroy(r);
+        return NULL;
+    }
+    for (size_t i = 0; i < frames; i++) {
+        float acc = 0.0f;
+        for (unsigned int c = 0; c < channels; c++) acc += pcm[i * channels + c] / 32768.0f;
+        mono[i] = acc / (float)channels;
+    }
+    free(pcm);
+
+    if (!r) {
+        *num_samples = frames;
+        return mono;
+    }
+    *num_samples = audio_resampler_process(r, mono, frames, out);
+    audio_resampler_destroy(r);
+    free(mono);
+    return out;
+}
+
+/* Speech-like stand-in when no fixture can be read: harmonic tone, syllable envelope, noise */
+static float* synthetic_audio(size_t *num_samples) {
+    const size_t n = (size_t)AUDIO_SAMPLE_RATE * SYNTHETIC_SECONDS;
+    float *samples = malloc(n * sizeof(float));
+    if (!samples) return NULL;
+
+    srand(42);
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / AUDIO_SAMPLE_RATE;
+        samples[i] = (float)(0.2 * sin(2.0 * 3.14159265358979323846 * 180.0 * t) *
+                             (0.6 + 0.4 * sin(2.0 * 3.14159265358979323846 * 3.0 * t)) +
+                             0.01 * ((double)rand() / RAND_MAX - 0.5));
+    }
+    *num_samples = n;
+    return samples;
+}
+
+/* ---- dsp ---- */
+
+static void discard_audio(const float *samples, size_t num_samples, uint64_t capture_ns, void *user_data) {
+    (void)capture_ns;
+    *(volatile float *)user_data += num_samples > 0 ? samples[num_samples - 1] : 0.0f;
+}
+
+static void bench_dsp(const bench_config_t *config) {
+    int16_t *src = malloc(DSP_SAMPLES * sizeof(int16_t));
+    float *dst = malloc(DSP_SAMPLES * sizeof(float));
+    if (!src || !dst) {
+        free(src);
+        free(dst);
+        return;
+    }
+    for (size_t i = 0; i < DSP_SAMPLES; i++) {
+        src[i] = (int16_t)((i * 2654435761u) >> 16);
+    }
+
+    double rates[BENCH_MAX_RUNS];
+    for (int run = 0; run < config->runs; run++) {
+        double t0 = now_sec();
+        for (int it = 0; it < 20; it++) audio_dsp_s16_to_f32(src, dst, DSP_SAMPLES);
+        rates[run] = 20.0 * DSP_SAMPLES / (now_sec() - t0) / 1e6;
+    }
+    begin_result("dsp", "s16_to_f32");
+    result_printf("\"samples\":%d", DSP_SAMPLES);
+    begin_metrics();
+    result_printf("\"msamples_per_s\":%.1f", quantile(rates, config->runs, 0.5));
+    end_result();
+
+    /* Resampling and the full push path, fed in capture-sized blocks */
+    static const unsigned int in_rates[] = { 48000, 44100 };
+    for (size_t k = 0; k < sizeof(in_rates) / sizeof(in_rates[0]); k++) {
+        const unsigned int rate = in_rates[k];
+        const size_t block = rate * DSP_BLOCK_MS / 1000;
+        const size_t total = (size_t)rate * DSP_SECONDS;
+        int16_t *pcm = malloc(total * sizeof(int16_t));
+        audio_dsp_t *dsp = audio_dsp_create(rate, block);
+        if (!pcm || !dsp) {
+            free(pcm);
+            audio_dsp_destroy(dsp);
+            continue;
+        }
+        for (size_t i = 0; i < total; i++) {
+            pcm[i] = (int16_t)(16000.0 * sin(2.0 * 3.14159265358979323846 * 1000.0 * (double)i / rate));
+        }
+
+        float sink = 0.0f;
+        for (int run = 0; run < config->runs; run++) {
+            double t0 = now_sec();
+            for (size_t off = 0; off + block <= total; off += block) {
+                audio_dsp_push_s16(dsp, pcm + off, block, 0, discard_audio, &sink);
+            }
+            rates[run] = DSP_SECONDS / (now_sec() - t0);
+        }
+        begin_result("dsp", "push_s16");
+        result_printf("\"in_rate\":%u,\"block_ms\":%d", rate, DSP_BLOCK_MS);
+        begin_metrics();
+        result_printf("\"x_realtime\":%.1f", quantile(rates, config->runs, 0.5));
+        end_result();
+
+        free(pcm);
+        audio_dsp_destroy(dsp);
+    }
+
+    free(src);
+    free(dst);
+}
+
+/* ---- ipc ---- */
+
+typedef enum { IPC_TRANSCRIPTION, IPC_TRANSLATION, IPC_STATS } ipc_kind_t;
+static const char *ipc_names[] = { "transcription", "translation", "stats" };
+
+static void bench_ipc(const bench_config_t *config) {
+    static const char *text = "The meeting has been moved to Thursday afternoon, "
+                              "please let everyone on the team know.";
+    static const char *translated = "La réunion a été déplacée à jeudi après-midi, "
+                                    "merci de prévenir toute l'équipe.";
+    const ipc_translation_t translation = { "fr", translated };
+    const ipc_fragments_t fragments = { 1, 1 };
+    ipc_latency_t latency = {
+        .audio_start_ns = 81234000000000ull, .audio_end_ns = 81236000000000ull,
+        .capture_ms = 0.4, .queue_ms = 3.1, .asr_ms = 1890.2, .reorder_ms = 0.0,
+        .translation_queue_ms = 0.3, .translation_ms = 612.8,
+    };
+    char stats[4096];
+    metrics_observe(metrics_histogram("bench_latency_ms", "Benchmark latency"), 12.5);
+    metrics_format_json(stats, sizeof(stats));
+
+    /* Messages go to the null device, through stdout's usual buffering and flushes */
+    fflush(stdout);
+    const int saved = dup(1);
+    const int null_fd = open(NULL_DEVICE, O_WRONLY);
+    if (saved < 0 || null_fd < 0) return;
+    dup2(null_fd, 1);
+
+    double rates[3][BENCH_MAX_RUNS];
+    for (int run = 0; run < config->runs; run++) {
+        for (int kind = 0; kind < 3; kind++) {
+            double t0 = now_sec();
+            for (int i = 0; i < IPC_MESSAGES; i++) {
+                if (kind == IPC_TRANSCRIPTION) ipc_send_transcription(text, "mic", 1, 1234567890L, &latency);
+                else if (kind == IPC_TRANSLATION) ipc_send_translation(&translation, 1, text, "mic", &fragments,
+                                                                       1234567890L, &latency);
+                else ipc_send_stats(stats, 1234567890L);
+            }
+            rates[kind][run] = IPC_MESSAGES / (now_sec() - t0);
+        }
+    }
+
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    close(null_fd);
+
+    for (int kind = 0; kind < 3; kind++) {
+        const double rate = quantile(rates[kind], config->runs, 0.5);
+        begin_result("ipc", ipc_names[kind]);
+        result_printf("\"messages\":%d", IPC_MESSAGES);
+        begin_metrics();
+        result_printf("\"messages_per_s\":%.0f,\"us_per_message\":%.2f", rate, 1e6 / rate);
+        end_result();
+    }
+}
+
+/* ---- asr ---- */
+
+static size_t g_transcribed_chars = 0;
+
+static void on_transcription(const char *text, const whisper_timing_t *timing, void *user_data) {
+    (void)timing;
+    (void)user_data;
+    g_transcribed_chars += strlen(text);
+}
+
+static void bench_whisper(const bench_config_t *config, const char *model, int threads,
+                          const char *fixture, const float *audio, size_t num_samples) {
+    whisper_engine_params_t params = whisper_engine_default_params();
+    params.pool_size = 1;
+    params.threads_per_state = threads;
+
+    const double t_load = now_sec();
+    whisper_engine_t *engine = whisper_engine_init_with_params(model, "en", &params, on_transcription, NULL);
+    if (!engine) {
+        fprintf(stderr, "Failed to load %s: %s\n", model, whisper_engine_get_error());
+        return;
+    }
+    const double load_ms = (now_sec() - t_load) * 1000.0;
+    whisper_engine_warm_up(engine);
+
+    /* Chunk like whisper_engine_stream_push, synchronously */
+    const size_t chunk = (size_t)AUDIO_SAMPLE_RATE * WHISPER_CHUNK_MS_DEFAULT / 1000;
+    const size_t overlap = (size_t)AUDIO_SAMPLE_RATE * WHISPER_OVERLAP_MS_DEFAULT / 1000;
+    const size_t step = chunk - overlap;
+
+    double rtf[BENCH_MAX_RUNS];
+    double chunk_ms[BENCH_MAX_RUNS * 64];
+    int n_chunks = 0;
+    for (int run = 0; run < config->runs; run++) {
+        g_transcribed_chars = 0;
+        double audio_ms = 0.0;
+        const double t0 = now_sec();
+        for (size_t off = 0; off < num_samples; off += step) {
+            const size_t n = num_samples - off < chunk ? num_samples - off : chunk;
+            const double t_chunk = now_sec();
+            whisper_engine_process(engine, audio + off, n);
+            if (n_chunks < BENCH_MAX_RUNS * 64) chunk_ms[n_chunks++] = (now_sec() - t_chunk) * 1000.0;
+            const size_t fresh = off == 0 ? n : (n > overlap ? n - overlap : 0);  /* Overlap was already counted */
+            audio_ms += (double)fresh * 1000.0 / AUDIO_SAMPLE_RATE;
+            if (off + n >= num_samples) break;
+        }
+        rtf[run] = (now_sec() - t0) * 1000.0 / audio_ms;
+    }
+
+    whisper_engine_stats_t stats;
+    whisper_engine_get_stats(engine, &stats);
+
+    begin_result("asr", "whisper_rtf");
+    result_printf("\"model\":");
+    write_json_string(model);
+    result_printf(",\"fixture\":");
+    write_json_string(fixture);
+    result_printf(",\"threads\":%d,\"chunk_ms\":%d,\"overlap_ms\":%d,\"audio_s\":%.2f",
+                  threads, WHISPER_CHUNK_MS_DEFAULT, WHISPER_OVERLAP_MS_DEFAULT, (double)num_samples / AUDIO_SAMPLE_RATE);
+    begin_metrics();
+    result_printf("\"rtf\":%.4f,\"rtf_best\":%.4f,\"chunk_ms_p50\":%.1f,\"chunk_ms_p90\":%.1f,"
+                  "\"mel_ms\":%.1f,\"inference_ms\":%.1f,\"load_ms\":%.0f,\"chars\":%zu",
+                  quantile(rtf, config->runs, 0.5), quantile(rtf, config->runs, 0.0),
+                  quantile(chunk_ms, n_chunks, 0.5), quantile(chunk_ms, n_chunks, 0.9),
+                  stats.chunks ? stats.mel_ms / stats.chunks : 0.0,
+                  stats.chunks ? stats.inference_ms / stats.chunks : 0.0, load_ms, g_transcribed_chars);
+    end_result();
+
+    fprintf(stderr, "asr  %s  %d threads  %s: RTF %.3f\n", model, threads, fixture, quantile(rtf, config->runs, 0.5));
+    whisper_engine_cleanup(engine);
+}
+
+/* ---- pipe ---- */
+
+typedef struct {
+    char text[8192];
+    size_t len;
+} transcript_t;
+
+static void append_transcription(const char *text, const whisper_timing_t *timing, void *user_data) {
+    transcript_t *transcript = (transcript_t *)user_data;
+    (void)timing;
+    snprintf(transcript->text + transcript->len, sizeof(transcript->text) - transcript->len, "%s\n", text);
+    transcript->len += strlen(transcript->text + transcript->len);
+}
+
+/* Transcribe audio chunk by chunk, greedy without temperature fallback so
+ * both decoding paths make the same choices; returns the pipelined chunks */
+static long transcribe_chunks(const char *model, int threads, bool pipeline,
+                              const float *audio, size_t num_samples, transcript_t *transcript) {
+    whisper_engine_params_t params = whisper_engine_default_params();
+    params.pool_size = 1;
+    params.threads_per_state = threads;
+    params.pipeline = pipeline;
+
+    memset(transcript, 0, sizeof(*transcript));
+    whisper_engine_t *engine = whisper_engine_init_with_params(model, "en", &params, append_transcription, transcript);
+    if (!engine) {
+        fprintf(stderr, "Failed to load %s: %s\n", model, whisper_engine_get_error());
+        return -1;
+    }
+    whisper_engine_set_decoding(engine, 1, false);
+    whisper_engine_warm_up(engine);
+
+    const size_t chunk = (size_t)AUDIO_SAMPLE_RATE * WHISPER_CHUNK_MS_DEFAULT / 1000;
+    const size_t step = chunk - (size_t)AUDIO_SAMPLE_RATE * WHISPER_OVERLAP_MS_DEFAULT / 1000;
+    for (size_t off = 0; off < num_samples; off += step) {
+        const size_t n = num_samples - off < chunk ? num_samples - off : chunk;
+        whisper_engine_process(engine, audio + off, n);
+        if (off + n >= num_samples) break;
+    }
+
+    whisper_engine_stats_t stats;
+    whisper_engine_get_stats(engine, &stats);
+    whisper_engine_cleanup(engine);
+    return (long)stats.pipelined;
+}
+
+/* The split encoder/decoder path must transcribe exactly like whisper_full */
+static bool check_pipeline(const char *model, int threads, const char *fixture,
+                           const float *audio, size_t num_samples) {
+    static transcript_t whole, pipelined;
+    if (transcribe_chunks(model, threads, false, audio, num_samples, &whole) < 0) return false;
+    const long n_pipelined = transcribe_chunks(model, threads, true, audio, num_samples, &pipelined);
+    if (n_pipelined < 0) return false;
+
+    const bool match = strcmp(whole.text, pipelined.text) == 0;
+    begin_result("pipe", "pipeline_match");
+    result_printf("\"model\":");
+    write_json_string(model);
+    result_printf(",\"fixture\":");
+    write_json_string(fixture);
+    result_printf(",\"threads\":%d", threads);
+    begin_metrics();
+    result_printf("\"match\":%s,\"pipelined_chunks\":%ld", match ? "true" : "false", n_pipelined);
+    end_result();
+
+    if (!match) {
+        fprintf(stderr, "pipe %s  %s: transcripts differ\n--- whole chunks\n%s--- pipelined\n%s",
+                model, fixture, whole.text, pipelined.text);
+    } else if (n_pipelined == 0) {
+        fprintf(stderr, "pipe %s  %s: no chunk took the pipelined path\n", model, fixture);
+    } else {
+        fprintf(stderr, "pipe %s  %s: %ld pipelined chunks match\n", model, fixture, n_pipelined);
+    }
+    return match && n_pipelined > 0;
+}
+
+/* ---- mt ---- */
+
+static pthread_mutex_t mt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mt_cv = PTHREAD_COND_INITIALIZER;
+static int mt_done = 0;
+static double mt_latency_ms[BENCH_MAX_RUNS * TRANSLATION_MAX_PENDING];
+static int mt_latencies = 0;
+
+static void on_translation(const translation_output_t *outputs, size_t num_outputs,
+                           const translation_timing_t *timing, void *user_data) {
+    (void)outputs;
+    (void)num_outputs;
+    (void)user_data;
+    pthread_mutex_lock(&mt_lock);
+    if (timing && mt_latencies < BENCH_MAX_RUNS * TRANSLATION_MAX_PENDING) {
+        mt_latency_ms[mt_latencies++] = (double)(timing->done_ns - timing->queued_ns) / 1e6;
+    }
+    mt_done++;
+    pthread_cond_signal(&mt_cv);
+    pthread_mutex_unlock(&mt_lock);
+}
+
+static void bench_translation(const bench_config_t *config, const char *model) {
+    const double t_load = now_sec();
+    translation_engine_t *engine = translation_init(model, on_translation, NULL);
+    if (!engine) {
+        fprintf(stderr, "Failed to load %s\n", model);
+        return;
+    }
+    const double load_ms = (now_sec() - t_load) * 1000.0;
+    translation_warm_up(engine);
+
+    /* Decoder steps come from the engine's translation_token_ms histogram */
+    metrics_histogram_t *tokens = metrics_histogram("translation_token_ms", NULL);
+
+    for (int b = 0; b < config->n_batches; b++) {
+        const int batch = config->batches[b] < TRANSLATION_MAX_PENDING ? config->batches[b] : TRANSLATION_MAX_PENDING;
+        metrics_summary_t before, after;
+        metrics_histogram_summary(tokens, &before);
+        mt_latencies = 0;
+
+        size_t next = 0;
+        const double t0 = now_sec();
+        for (int run = 0; run < config->runs; run++) {
+            pthread_mutex_lock(&mt_lock);
+            mt_done = 0;
+            pthread_mutex_unlock(&mt_lock);
+
+            int queued = 0;
+            for (int i = 0; i < batch; i++) {
+                if (translation_translate(engine, sentences[next++ % N_SENTENCES], "en", &config->target_lang, 1, NULL)) {
+                    queued++;
+                }
+            }
+
+            pthread_mutex_lock(&mt_lock);
+            while (mt_done < queued) pthread_cond_wait(&mt_cv, &mt_lock);
+            pthread_mutex_unlock(&mt_lock);
+        }
+        const double elapsed = now_sec() - t0;
+        metrics_histogram_summary(tokens, &after);
+
+        const uint64_t steps = after.count - before.count;
+        const int n = mt_latencies;
+        begin_result("mt", "translation");
+        result_printf("\"model\":");
+        write_json_string(model);
+        result_printf(",\"batch\":%d,\"requests\":%d,\"target\":", batch, n);
+        write_json_string(config->target_lang);
+        begin_metrics();
+        result_printf("\"tokens_per_s\":%.1f,\"token_ms\":%.2f,\"requests_per_s\":%.2f,"
+                      "\"latency_ms_p50\":%.1f,\"latency_ms_p90\":%.1f,\"latency_ms_max\":%.1f,\"load_ms\":%.0f",
+                      steps / elapsed, steps ? (after.sum - before.sum) / (double)steps : 0.0, n / elapsed,
+                      quantile(mt_latency_ms, n, 0.5), quantile(mt_latency_ms, n, 0.9),
+                      quantile(mt_latency_ms, n, 1.0), load_ms);
+        end_result();
+
+        fprintf(stderr, "mt   %s  batch %d: %.1f tokens/s\n", model, batch, steps / elapsed);
+    }
+
+    translation_cleanup(engine);
+}
+
+/* ---- main ---- */
+
+static int usage(const char *argv0) {
+    fprintf(stderr, "Usage: %s [-o FILE] [-r RUNS] [-s dsp,ipc,asr,mt,pipe]\n"
+                    "       [-w WHISPER.gguf]... [-a FIXTURE.wav]... [-t THREADS,...]\n"
+                    "       [-m TRANSLATION.gguf]... [-b BATCH,...] [-l LANG]\n", argv0);
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    bench_config_t config;
+    memset(&config, 0, sizeof(config));
+    config.runs = DEFAULT_RUNS;
+    config.dsp = config.ipc = config.asr = config.mt = true;
+    config.threads[0] = 1;
+    config.threads[1] = 2;
+    config.threads[2] = 4;
+    config.n_threads = 3;
+    config.batches[0] = 1;
+    config.batches[1] = 4;
+    config.batches[2] = 8;
+    config.n_batches = 3;
+    config.target_lang = "fr";
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (i + 1 >= argc) return usage(argv[0]);
+        const char *value = argv[++i];
+        if (strcmp(arg, "-o") == 0) {
+            config.output = value;
+        } else if (strcmp(arg, "-r") == 0) {
+            config.runs = atoi(value);
+            if (config.runs < 1 || config.runs > BENCH_MAX_RUNS) return usage(argv[0]);
+        } else if (strcmp(arg, "-s") == 0) {
+            config.dsp = strstr(value, "dsp") != NULL;
+            config.ipc = strstr(value, "ipc") != NULL;
+            config.asr = strstr(value, "asr") != NULL;
+            config.mt = strstr(value, "mt") != NULL;
+            config.pipe = strstr(value, "pipe") != NULL;
+        } else if (strcmp(arg, "-w") == 0 && config.n_whisper_models < BENCH_MAX_ITEMS) {
+            config.whisper_models[config.n_whisper_models++] = value;
+        } else if (strcmp(arg, "-a") == 0 && config.n_fixtures < BENCH_MAX_ITEMS) {
+            config.fixtures[config.n_fixtures++] = value;
+        } else if (strcmp(arg, "-t") == 0) {
+            config.n_threads = parse_list(value, config.threads, BENCH_MAX_ITEMS);
+            if (config.n_threads == 0) return usage(argv[0]);
+        } else if (strcmp(arg, "-m") == 0 && config.n_translation_models < BENCH_MAX_ITEMS) {
+            config.translation_models[config.n_translation_models++] = value;
+        } else if (strcmp(arg, "-b") == 0) {
+            config.n_batches = parse_list(value, config.batches, BENCH_MAX_ITEMS);
+            if (config.n_batches == 0) return usage(argv[0]);
+        } else if (strcmp(arg, "-l") == 0) {
+            config.target_lang = value;
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    g_out = config.output ? fopen(config.output, "w") : stdout;
+    if (!g_out) {
+        fprintf(stderr, "Cannot write %s\n", config.output);
+        return 1;
+    }
+    logger_set_level(LOG_LEVEL_WARN);
+    ipc_init();  /* stdout buffering as in the backend, set before anything is written */
+
+    fprintf(g_out, "{\n  \"benchmark\":\"visualia\",\"version\":1,\"timestamp\":%ld,\"runs\":%d,"
+            "\"host\":{\"cores\":%d},\n  \"results\":[", (long)time(NULL), config.runs, cpu_budget_total());
+
+    if (config.dsp) bench_dsp(&config);
+    if (config.ipc) bench_ipc(&config);
+
+    int status = 0;
+    if ((config.asr || config.pipe) && config.n_whisper_models > 0) {
+        if (config.n_fixtures == 0) config.fixtures[config.n_fixtures++] = DEFAULT_FIXTURE;
+        for (int f = 0; f < config.n_fixtures; f++) {
+            size_t num_samples = 0;
+            const char *fixture = config.fixtures[f];
+            float *audio = load_wav(fixture, &num_samples);
+            if (!audio) {
+                fprintf(stderr, "Cannot read %s (16-bit PCM WAV), using synthetic audio\n", fixture);
+                fixture = "synthetic";
+                audio = synthetic_audio(&num_samples);
+                if (!audio) continue;
+            }
+            for (int m = 0; m < config.n_whisper_models; m++) {
+                for (int t = 0; config.asr && t < config.n_threads; t++) {
+                    bench_whisper(&config, config.whisper_models[m], config.threads[t], fixture, audio, num_samples);
+                }
+                if (config.pipe && !check_pipeline(config.whisper_models[m], config.threads[0], fixture, audio, num_samples)) {
+                    status = 1;
+                }
+            }
+            free(audio);
+        }
+    }
+
+    if (config.mt) {
+        for (int m = 0; m < config.n_translation_models; m++) {
+            bench_translation(&config, config.translation_models[m]);
+        }
+    }
+
+    fprintf(g_out, "\n  ]\n}\n");
+    if (g_out != stdout) fclose(g_out);
+    return status;
+}
@@ -0,0 +1,42 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Heap allocation counter (debug builds)
+ *
+ * Built with VISUALIA_ALLOC_COUNTER on glibc, the process's malloc family is
+ * interposed and every allocation is counted, process-wide and per thread.
+ * Reading the thread counter before and after a callback tells how many
+ * allocations it made, which is how the steady-state audio and result paths
+ * are checked to be allocation-free. Without the option the counters read 0.
+ */
+
+/**
+ * Whether allocations are being counted
+ * @return true if built with VISUALIA_ALLOC_COUNTER on a supported libc
+ */
+bool alloc_counter_available(void);
+
+/**
+ * Allocations made by the whole process so far
+ * @return Count (malloc, calloc, realloc, aligned allocations)
+ */
+unsigned long long alloc_counter_total(void);
+
+/**
+ * Allocations made by the calling thread so far
+ * @return Count
+ */
+unsigned long long alloc_counter_thread(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALLOC_COUNTER_H */
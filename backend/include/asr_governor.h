@@ -0,0 +1,84 @@
+#ifndef ASR_GOVERNOR_H
+#define ASR_GOVERNOR_H
+
+#include "whisper_engine.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Real-time governor for the Whisper engine
+ *
+ * Watches the engine's rolling real-time factor and trades quality for speed
+ * when transcription falls behind the audio: first cheaper decoding (beam
+ * search -> greedy -> no temperature fallback), then longer chunks (less
+ * overlap re-decoded per second of audio), then smaller models. When there
+ * is headroom again the most recent step is undone.
+ */
+
+/* Governor context (opaque) */
+typedef struct asr_governor asr_governor_t;
+
+/* Model ladder length (the startup model plus smaller fallbacks) */
+#define ASR_GOVERNOR_MAX_MODELS 4
+
+/* Governor tuning (see asr_governor_default_params) */
+typedef struct {
+    const char *models[ASR_GOVERNOR_MAX_MODELS]; /* Largest first; models[0] is the engine's startup model */
+    size_t num_models;
+    double high_load;   /* Step down above this engine load */
+    double low_load;    /* Consider stepping up below this engine load */
+    int hold_ms;        /* Minimum time between two decisions */
+} asr_governor_params_t;
+
+/* A decision, reported through the governor callback */
+typedef struct {
+    const char *action;         /* "step_down" or "step_up" */
+    const char *knob;           /* "decoding", "chunk" or "model" */
+    const char *model;          /* Active model after the decision */
+    int beam_size;              /* 1 = greedy */
+    bool temperature_fallback;
+    int chunk_ms;
+    double rtf;                 /* Measurements that triggered the decision */
+    double load;
+} asr_governor_decision_t;
+
+/* Decision callback */
+typedef void (*asr_governor_callback_t)(const asr_governor_decision_t *decision, void *user_data);
+
+/**
+ * Default governor parameters (no fallback models)
+ * @return Parameters
+ */
+asr_governor_params_t asr_governor_default_params(void);
+
+/**
+ * Create a governor for an engine; the engine's current settings are the top quality level
+ * @param engine Whisper engine context
+ * @param params Governor parameters, NULL for defaults
+ * @param callback Function to call for every decision
+ * @param user_data User data to pass to callback
+ * @return Governor or NULL on failure
+ */
+asr_governor_t* asr_governor_create(whisper_engine_t *engine, const asr_governor_params_t *params,
+                                    asr_governor_callback_t callback, void *user_data);
+
+/**
+ * Evaluate the engine load and act on it; call periodically from one thread
+ * Model switches load in the background and are reported when they complete.
+ * @param gov Governor
+ */
+void asr_governor_update(asr_governor_t *gov);
+
+/**
+ * Destroy governor (waits for a model switch in progress)
+ * @param gov Governor
+ */
+void asr_governor_destroy(asr_governor_t *gov);
+
+/**
+ * Get last error message
+ * @return Error message string
+ */
+const char* asr_governor_get_error(void);
+
+#endif /* ASR_GOVERNOR_H */
@@ -0,0 +1,86 @@
+#ifndef ASR_ROUTER_H
+#define ASR_ROUTER_H
+
+#include "whisper_engine.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Language-based model routing for the Whisper engine
+ *
+ * Once the detected language has been stable for a while, switches the
+ * engine to a faster model for that language (an English-only .en model or
+ * a per-language fine-tune), loading it in the background. The multilingual
+ * model stays resident: it keeps detecting the language, and the engine
+ * goes straight back to it when the detected language changes.
+ */
+
+/* Router context (opaque) */
+typedef struct asr_router asr_router_t;
+
+/* Maximum language-specific routes */
+#define ASR_ROUTER_MAX_ROUTES 4
+
+/* A language and the model to use for it */
+typedef struct {
+    const char *language;   /* Language code, e.g. "en" */
+    const char *model;      /* Model path */
+} asr_route_t;
+
+/* Router tuning (see asr_router_default_params) */
+typedef struct {
+    asr_route_t routes[ASR_ROUTER_MAX_ROUTES];
+    size_t num_routes;
+    const char *language;   /* Fixed source language, NULL = follow detection */
+    bool discover_english;  /* Route "en" to MODEL.en.gguf next to the startup model if present */
+    int min_detections;     /* Consecutive agreeing detections before routing */
+    int hold_ms;            /* Minimum time the language must have been stable */
+} asr_router_params_t;
+
+/* A routing decision, reported through the router callback */
+typedef struct {
+    const char *action;     /* "route" or "fallback" */
+    const char *language;   /* Language that triggered the decision */
+    const char *model;      /* Active model after the decision */
+} asr_router_decision_t;
+
+/* Decision callback */
+typedef void (*asr_router_callback_t)(const asr_router_decision_t *decision, void *user_data);
+
+/**
+ * Default router parameters (English discovery on, no explicit routes)
+ * @return Parameters
+ */
+asr_router_params_t asr_router_default_params(void);
+
+/**
+ * Create a router for an engine; the engine's current model is the multilingual fallback
+ * @param engine Whisper engine context
+ * @param params Router parameters, NULL for defaults
+ * @param callback Function to call for every decision
+ * @param user_data User data to pass to callback
+ * @return Router or NULL on failure (including no usable route)
+ */
+asr_router_t* asr_router_create(whisper_engine_t *engine, const asr_router_params_t *params,
+                                asr_router_callback_t callback, void *user_data);
+
+/**
+ * Act on new language detections; call periodically from one thread
+ * Routed models load in the background and are reported when active.
+ * @param router Router
+ */
+void asr_router_update(asr_router_t *router);
+
+/**
+ * Destroy router (waits for a model load in progress)
+ * @param router Router
+ */
+void asr_router_destroy(asr_router_t *router);
+
+/**
+ * Get last error message
+ * @return Error message string
+ */
+const char* asr_router_get_error(void);
+
+#endif /* ASR_ROUTER_H */
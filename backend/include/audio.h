@@ -11,19 +11,73 @@
 #define AUDIO_BUFFER_MS 3000  /* 3 second buffer for Whisper */
 #define AUDIO_BUFFER_SIZE (AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * AUDIO_BUFFER_MS / 1000)
 
-/* Audio callback function type */
-typedef void (*audio_callback_t)(const float *samples, size_t num_samples, void *user_data);
+/* Audio callback function type; capture_ns is the capture time of the last
+ * sample in monotonic ns (trace_now_ns() clock) */
+typedef void (*audio_callback_t)(const float *samples, size_t num_samples, uint64_t capture_ns, void *user_data);
 
 /* Audio context (opaque) */
 typedef struct audio_context audio_context_t;
 
+/* Maximum number of simultaneously captured sources */
+#define AUDIO_MAX_SOURCES 4
+
+#ifdef PLATFORM_LINUX
+/* PulseAudio alias for the monitor (loopback) of the default output sink */
+#define AUDIO_DEVICE_DEFAULT_MONITOR "@DEFAULT_MONITOR@"
+#endif
+
+/* Capture source description */
+typedef struct {
+    const char *device;  /* Device name (PulseAudio source incl. "*.monitor", CoreAudio device UID), NULL for default input */
+    const char *label;   /* Tag for log output, e.g. "mic" or "system" */
+    void *user_data;     /* Passed to the callback for this source's audio */
+} audio_source_t;
+
+/* Capture thread scheduling (see audio_default_params) */
+typedef struct {
+    bool realtime;          /* SCHED_FIFO (Linux) / time-critical (Windows) capture threads */
+    int rt_priority;        /* SCHED_FIFO priority, 1-99 */
+    const char *affinity;   /* CPU list to pin capture threads to, e.g. "0", NULL = inherit */
+} audio_params_t;
+
+/* Capture health of one source since audio_start() */
+typedef struct {
+    unsigned long reads;        /* Buffers delivered */
+    unsigned long late_reads;   /* Buffers collected more than two periods after the previous one */
+    unsigned long gaps;         /* Discontinuities: audio captured by the device but never delivered */
+    double lost_ms;             /* Audio lost in gaps */
+    double max_stall_ms;        /* Longest time between two buffers */
+} audio_stats_t;
+
+/**
+ * Default capture parameters (normal priority, no pinning)
+ * @return Parameters
+ */
+audio_params_t audio_default_params(void);
+
 /**
  * Initialize audio capture
+ * Each source is captured as a separate stream with its own buffers and
+ * delivered to callback with that source's user_data.
+ * @param sources Sources to capture (1..AUDIO_MAX_SOURCES)
+ * @param num_sources Number of sources
  * @param callback Function to call when audio data is available
- * @param user_data User data to pass to callback
  * @return Audio context or NULL on failure
  */
-audio_context_t* audio_init(audio_callback_t callback, void *user_data);
+audio_context_t* audio_init(const audio_source_t *sources, size_t num_sources, audio_callback_t callback);
+
+/**
+ * Initialize audio capture with explicit capture thread scheduling
+ * Priority and affinity are applied by each capture thread when it starts;
+ * failures are logged and capture continues at normal priority.
+ * @param sources Sources to capture (1..AUDIO_MAX_SOURCES)
+ * @param num_sources Number of sources
+ * @param callback Function to call when audio data is available
+ * @param params Scheduling parameters, NULL for defaults
+ * @return Audio context or NULL on failure
+ */
+audio_context_t* audio_init_with_params(const audio_source_t *sources, size_t num_sources,
+                                        audio_callback_t callback, const audio_params_t *params);
 
 /**
  * Start audio capture
@@ -38,6 +92,15 @@ bool audio_start(audio_context_t *ctx);
  */
 void audio_stop(audio_context_t *ctx);
 
+/**
+ * Get the capture health counters of one source
+ * @param ctx Audio context
+ * @param source Source index, in audio_init order
+ * @param stats Receives the counters
+ * @return true on success, false for an unknown source
+ */
+bool audio_get_stats(audio_context_t *ctx, size_t source, audio_stats_t *stats);
+
 /**
  * Cleanup audio resources
  * @param ctx Audio context
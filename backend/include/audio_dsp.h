@@ -0,0 +1,96 @@
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include "audio.h"
+#include <stdint.h>
+#include <stddef.h>
+
+/* Audio front-end: PCM conversion and sample-rate conversion (opaque) */
+typedef struct audio_resampler audio_resampler_t;
+typedef struct audio_dsp audio_dsp_t;
+
+/* Native capture rate requested from the sound server when the device rate is unknown */
+#define AUDIO_CAPTURE_RATE_DEFAULT 48000
+
+/**
+ * Convert signed 16-bit PCM to float32 in [-1, 1) (SSE2/NEON when available)
+ * @param src Input samples
+ * @param dst Output samples (may not alias src)
+ * @param n Number of samples
+ */
+void audio_dsp_s16_to_f32(const int16_t *src, float *dst, size_t n);
+
+/**
+ * Create a polyphase FIR resampler
+ * @param in_rate Input sample rate in Hz
+ * @param out_rate Output sample rate in Hz
+ * @param max_input Largest block passed to a single audio_resampler_process() call
+ * @return Resampler or NULL on failure
+ */
+audio_resampler_t* audio_resampler_create(unsigned int in_rate, unsigned int out_rate, size_t max_input);
+
+/**
+ * Upper bound on output samples produced for num_input input samples
+ * @param r Resampler
+ * @param num_input Number of input samples
+ * @return Maximum number of output samples
+ */
+size_t audio_resampler_max_output(const audio_resampler_t *r, size_t num_input);
+
+/**
+ * Resample a block of samples; filter state carries over between calls
+ * @param r Resampler
+ * @param in Input samples (at most max_input)
+ * @param num_input Number of input samples
+ * @param out Output buffer with room for audio_resampler_max_output() samples
+ * @return Number of output samples written
+ */
+size_t audio_resampler_process(audio_resampler_t *r, const float *in, size_t num_input, float *out);
+
+/**
+ * Clear filter history
+ * @param r Resampler
+ */
+void audio_resampler_reset(audio_resampler_t *r);
+
+/**
+ * Free resampler
+ * @param r Resampler
+ */
+void audio_resampler_destroy(audio_resampler_t *r);
+
+/**
+ * Create a capture front-end (int16 -> float32 -> AUDIO_SAMPLE_RATE)
+ * All buffers are allocated here so that pushing audio never allocates.
+ * @param in_rate Capture sample rate in Hz
+ * @param max_frames Largest block processed at once; longer pushes are split
+ * @return Front-end or NULL on failure
+ */
+audio_dsp_t* audio_dsp_create(unsigned int in_rate, size_t max_frames);
+
+/**
+ * Convert and resample captured PCM, then deliver it to callback at AUDIO_SAMPLE_RATE
+ * @param dsp Front-end
+ * @param samples Signed 16-bit mono PCM at the capture rate
+ * @param num_samples Number of samples
+ * @param capture_ns Capture time of the last sample (trace_now_ns() clock)
+ * @param callback Receives float32 samples at AUDIO_SAMPLE_RATE
+ * @param user_data User data to pass to callback
+ */
+void audio_dsp_push_s16(audio_dsp_t *dsp, const int16_t *samples, size_t num_samples, uint64_t capture_ns,
+                        audio_callback_t callback, void *user_data);
+
+/**
+ * Capture sample rate the front-end was created for
+ * @param dsp Front-end
+ * @return Sample rate in Hz
+ */
+unsigned int audio_dsp_get_input_rate(const audio_dsp_t *dsp);
+
+/**
+ * Free front-end
+ * @param dsp Front-end
+ */
+void audio_dsp_destroy(audio_dsp_t *dsp);
+
+#endif /* AUDIO_DSP_H */
@@ -0,0 +1,90 @@
+#ifndef CPU_BUDGET_H
+#define CPU_BUDGET_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Process-wide compute thread budget
+ *
+ * Whisper and the translation model both run ggml kernels on the CPU. The
+ * budget is sized to the physical cores the process may run on, and every
+ * inference call asks it for threads: an engine working alone gets what it
+ * asks for up to the whole budget, and while both have work the budget is
+ * split between them, so the two thread pools never fight over the same
+ * cores. Optionally pins the process to a set of CPUs.
+ */
+
+/* Budget users */
+typedef enum {
+    CPU_BUDGET_ASR,
+    CPU_BUDGET_TRANSLATION,
+    CPU_BUDGET_CLIENTS
+} cpu_budget_client_t;
+
+/* Budget configuration (see cpu_budget_default_params) */
+typedef struct {
+    int threads;            /* Total compute threads, 0 = physical cores in the CPU set */
+    const char *affinity;   /* CPU list to pin the process to, e.g. "0-3,8", NULL = inherit */
+    double asr_share;       /* Fraction of the budget kept for ASR while both engines are busy */
+} cpu_budget_params_t;
+
+/**
+ * Default budget parameters (physical cores, no pinning, ASR share 0.75)
+ * @return Parameters
+ */
+cpu_budget_params_t cpu_budget_default_params(void);
+
+/**
+ * Size the budget and apply the CPU affinity
+ * Call from the main thread before starting other threads: threads created
+ * afterwards, including ggml's workers, inherit the affinity.
+ * @param params Budget parameters, NULL for defaults
+ * @return true on success, false if the affinity could not be applied
+ */
+bool cpu_budget_init(const cpu_budget_params_t *params);
+
+/**
+ * Total compute threads (physical cores if cpu_budget_init was not called)
+ * @return Thread count
+ */
+int cpu_budget_total(void);
+
+/**
+ * Ask for threads for one inference call
+ * Without cpu_budget_init the request is granted as is.
+ * @param client Engine making the call
+ * @param wanted Threads the call would use on an idle machine
+ * @return Threads to use (at least 1)
+ */
+int cpu_budget_acquire(cpu_budget_client_t client, int wanted);
+
+/**
+ * Return the threads of a finished call
+ * @param client Engine that made the call
+ * @param wanted The value passed to cpu_budget_acquire
+ */
+void cpu_budget_release(cpu_budget_client_t client, int wanted);
+
+/**
+ * Pin the calling thread to a set of CPUs, e.g. to keep audio capture off
+ * the cores the inference threads run on
+ * @param cpus CPU list, e.g. "0-3,8"
+ * @return true on success (Linux, Windows), false otherwise
+ */
+bool cpu_budget_pin_thread(const char *cpus);
+
+/**
+ * Get last error message
+ * @return Error message string
+ */
+const char* cpu_budget_get_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_BUDGET_H */
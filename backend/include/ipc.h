@@ -2,6 +2,8 @@
 #define IPC_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
 
 /* IPC message types */
 typedef enum {
@@ -11,6 +13,19 @@ typedef enum {
     IPC_MSG_CONTROL
 } ipc_message_type_t;
 
+/* Where a message's audio came from in time and what each stage cost.
+ * Times are monotonic ns (trace_now_ns() clock); stages are in ms. */
+typedef struct {
+    uint64_t audio_start_ns;      /* Capture time of the first new sample */
+    uint64_t audio_end_ns;        /* Capture time of the last sample */
+    double capture_ms;            /* Last sample captured to chunk queued (capture hand-off, startup buffer) */
+    double queue_ms;              /* Chunk waiting for a Whisper state */
+    double asr_ms;                /* Whisper inference */
+    double reorder_ms;            /* Waiting for earlier chunks of the same stream */
+    double translation_queue_ms;  /* Transcript waiting for the translation worker (translations only) */
+    double translation_ms;        /* Translation model (translations only) */
+} ipc_latency_t;
+
 /**
  * Initialize IPC system (JSON-RPC over stdio)
  * @return true on success, false on failure
@@ -20,10 +35,14 @@ bool ipc_init(void);
 /**
  * Send transcription result to frontend
  * @param text Transcribed text
+ * @param source Label of the audio source it came from, or NULL
+ * @param id Number of the transcript within its source (from 1), 0 to omit
  * @param timestamp Unix timestamp
+ * @param latency Capture times and stage latencies, or NULL
  * @return true on success, false on failure
  */
-bool ipc_send_transcription(const char *text, long timestamp);
+bool ipc_send_transcription(const char *text, const char *source, uint64_t id, long timestamp,
+                            const ipc_latency_t *latency);
 
 /**
  * Send error message to frontend
@@ -39,14 +58,34 @@ bool ipc_send_error(const char *error_msg);
  */
 bool ipc_send_status(const char *status);
 
+/* Transcripts of one source a translation covers, by their ids (see
+ * ipc_send_transcription); first 0 to omit */
+typedef struct {
+    uint64_t first;
+    uint64_t last;
+} ipc_fragments_t;
+
+/* One target language of a translation message */
+typedef struct {
+    const char *lang;   /* Target language code */
+    const char *text;   /* Translated text */
+} ipc_translation_t;
+
 /**
- * Send translation result to frontend
- * @param translated_text Translated text
+ * Send the translations of one transcript to frontend, every target in one message
+ * "text" carries the first target's translation for single-language clients.
+ * @param translations Translations, one per target language
+ * @param num_translations Number of targets (at least 1)
  * @param original_text Original text that was translated
+ * @param source Label of the audio source it came from, or NULL
+ * @param fragments Transcripts the original text was assembled from, or NULL
  * @param timestamp Unix timestamp
+ * @param latency Capture times and stage latencies, or NULL
  * @return true on success, false on failure
  */
-bool ipc_send_translation(const char *translated_text, const char *original_text, long timestamp);
+bool ipc_send_translation(const ipc_translation_t *translations, size_t num_translations, const char *original_text,
+                          const char *source, const ipc_fragments_t *fragments, long timestamp,
+                          const ipc_latency_t *latency);
 
 /**
  * Send detected language to frontend
@@ -55,8 +94,74 @@ bool ipc_send_translation(const char *translated_text, const char *original_text
  */
 bool ipc_send_language_detected(const char *language);
 
+/**
+ * Send a real-time governor decision to frontend
+ * @param action "step_down" or "step_up"
+ * @param knob Setting that changed ("decoding", "chunk" or "model")
+ * @param model Active model path
+ * @param beam_size Beam size (1 = greedy)
+ * @param temperature_fallback Whether temperature fallback is enabled
+ * @param chunk_ms Chunk length in milliseconds
+ * @param rtf Real-time factor that triggered the decision
+ * @param load Engine load that triggered the decision
+ * @param timestamp Unix timestamp
+ * @return true on success, false on failure
+ */
+bool ipc_send_governor(const char *action, const char *knob, const char *model, int beam_size,
+                       bool temperature_fallback, int chunk_ms, double rtf, double load, long timestamp);
+
+/**
+ * Send the duration of a startup phase to frontend
+ * @param phase Phase name ("audio", "whisper_load", "whisper_warmup",
+ *              "translation_load", "translation_warmup" or "ready")
+ * @param ms Duration in milliseconds ("ready": since process start)
+ * @param timestamp Unix timestamp
+ * @return true on success, false on failure
+ */
+bool ipc_send_startup(const char *phase, double ms, long timestamp);
+
+/**
+ * Send the memory cost of loading a model to frontend
+ * @param phase Loading phase ("whisper_load" or "translation_load")
+ * @param rss_mb Resident set size after loading
+ * @param huge_mb Of which backed by huge pages
+ * @param minor_faults Page faults served without I/O while loading
+ * @param major_faults Page faults that read from disk while loading
+ * @param timestamp Unix timestamp
+ * @return true on success, false on failure
+ */
+bool ipc_send_memory(const char *phase, double rss_mb, double huge_mb,
+                     unsigned long minor_faults, unsigned long major_faults, long timestamp);
+
+/**
+ * Send the periodic runtime metrics to frontend
+ * @param metrics_json Metrics as one JSON object (see metrics_format_json)
+ * @param timestamp Unix timestamp
+ * @return true on success, false on failure
+ */
+bool ipc_send_stats(const char *metrics_json, long timestamp);
+
+/**
+ * Send a metrics dump in Prometheus text format to frontend
+ * @param text Exposition text (see metrics_format_prometheus)
+ * @return true on success, false on failure
+ */
+bool ipc_send_metrics(const char *text);
+
+/* Command callback: type is the "type" member of a JSON line read from stdin */
+typedef void (*ipc_command_callback_t)(const char *type, void *user_data);
+
+/**
+ * Set the callback for commands from frontend (called from ipc_poll)
+ * @param callback Callback function, NULL to ignore commands
+ * @param user_data User data for the callback
+ */
+void ipc_set_command_callback(ipc_command_callback_t callback, void *user_data);
+
 /**
  * Check for incoming messages from frontend (non-blocking)
+ * Reads the JSON lines written to stdin so far and passes each one's type
+ * to the command callback.
  * @return true if message received and handled, false otherwise
  */
 bool ipc_poll(void);
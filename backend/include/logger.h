@@ -0,0 +1,107 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Leveled asynchronous logger
+ *
+ * Log calls format their message into a slot of a lock-free ring and
+ * return; a background thread drains the ring to stderr in batches. A full
+ * ring drops messages (and says so) rather than block the caller, so the
+ * audio, inference and translation threads never wait on the terminal or on
+ * Electron reading the pipe. Before logger_start() and after
+ * logger_shutdown() messages are written to stderr directly.
+ *
+ * Levels below VISUALIA_LOG_MIN_LEVEL are compiled out: debug messages
+ * cost nothing in release (NDEBUG) builds.
+ */
+
+typedef enum {
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+} log_level_t;
+
+/* Lowest level compiled in (0 = debug, 1 = info, ...) */
+#ifndef VISUALIA_LOG_MIN_LEVEL
+    #ifdef NDEBUG
+        #define VISUALIA_LOG_MIN_LEVEL 1
+    #else
+        #define VISUALIA_LOG_MIN_LEVEL 0
+    #endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define LOGGER_PRINTF(fmt, args) __attribute__((format(printf, fmt, args)))
+#else
+    #define LOGGER_PRINTF(fmt, args)
+#endif
+
+#define LOG_AT(level, ...) \
+    do { \
+        if ((int)(level) >= VISUALIA_LOG_MIN_LEVEL) logger_write((level), __VA_ARGS__); \
+    } while (0)
+
+/* Messages keep their "[Module] " prefix and trailing newline */
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+/**
+ * Start the background writer thread
+ * @return true on success (on failure messages stay synchronous)
+ */
+bool logger_start(void);
+
+/**
+ * Write out every queued message and stop the writer thread
+ */
+void logger_shutdown(void);
+
+/**
+ * Set the lowest level written at run time (default LOG_LEVEL_INFO)
+ * @param level Minimum level, LOG_LEVEL_OFF for none
+ */
+void logger_set_level(log_level_t level);
+
+/**
+ * Parse a level name: "debug", "info", "warn", "error" or "off"
+ * @param name Level name
+ * @param level Receives the level
+ * @return true if name is a known level
+ */
+bool logger_parse_level(const char *name, log_level_t *level);
+
+/**
+ * Whether a message at this level would be written
+ * @param level Message level
+ * @return true if enabled at compile and run time
+ */
+bool logger_enabled(log_level_t level);
+
+/**
+ * Queue a message (use the LOG_* macros)
+ * @param level Message level
+ * @param fmt printf format
+ */
+void logger_write(log_level_t level, const char *fmt, ...) LOGGER_PRINTF(2, 3);
+
+/**
+ * Messages dropped because the ring was full
+ * @return Count since start
+ */
+unsigned long logger_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOGGER_H */
@@ -0,0 +1,116 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Process-wide metrics registry
+ *
+ * Modules look their metrics up by name once (registering them on first
+ * use) and then record without locks. Latency histograms are log-linear
+ * (HDR-style): 32 sub-buckets per power of two of microseconds, so any
+ * quantile is within about 3% of the recorded value, from 1 us to hours.
+ *
+ * The registry renders as a JSON object (the periodic "stats" IPC message)
+ * or as Prometheus text exposition format.
+ */
+
+typedef struct metrics_histogram metrics_histogram_t;
+typedef struct metrics_counter metrics_counter_t;
+typedef struct metrics_gauge metrics_gauge_t;
+
+/* Histogram summary (milliseconds) */
+typedef struct {
+    uint64_t count;
+    double sum;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} metrics_summary_t;
+
+/**
+ * Get or register a latency histogram
+ * @param name Metric name, e.g. "capture_to_transcript_ms"
+ * @param help One-line description
+ * @return Histogram, NULL if the registry is full (recording to NULL is a no-op)
+ */
+metrics_histogram_t* metrics_histogram(const char *name, const char *help);
+
+/**
+ * Record a latency
+ * @param histogram Histogram (may be NULL)
+ * @param ms Value in milliseconds
+ */
+void metrics_observe(metrics_histogram_t *histogram, double ms);
+
+/**
+ * Summarise a histogram
+ * @param histogram Histogram
+ * @param summary Receives count, sum and quantiles
+ */
+void metrics_histogram_summary(const metrics_histogram_t *histogram, metrics_summary_t *summary);
+
+/**
+ * Get or register a monotonic counter
+ * @param name Metric name, e.g. "audio_gaps_total"
+ * @param help One-line description
+ * @return Counter, NULL if the registry is full
+ */
+metrics_counter_t* metrics_counter(const char *name, const char *help);
+
+/**
+ * Add to a counter
+ * @param counter Counter (may be NULL)
+ * @param n Amount
+ */
+void metrics_counter_add(metrics_counter_t *counter, uint64_t n);
+
+/**
+ * Set a counter from a total kept elsewhere
+ * @param counter Counter (may be NULL)
+ * @param value Total
+ */
+void metrics_counter_set(metrics_counter_t *counter, uint64_t value);
+
+/**
+ * Get or register a gauge
+ * @param name Metric name, e.g. "translation_queue_depth"
+ * @param help One-line description
+ * @return Gauge, NULL if the registry is full
+ */
+metrics_gauge_t* metrics_gauge(const char *name, const char *help);
+
+/**
+ * Set a gauge
+ * @param gauge Gauge (may be NULL)
+ * @param value Value
+ */
+void metrics_gauge_set(metrics_gauge_t *gauge, double value);
+
+/**
+ * Render every metric as one JSON object
+ * @param buf Destination
+ * @param size Size of buf
+ * @return Length written (truncated output is still terminated)
+ */
+size_t metrics_format_json(char *buf, size_t size);
+
+/**
+ * Render every metric in Prometheus text format (histograms as summaries)
+ * @param buf Destination
+ * @param size Size of buf
+ * @return Length written
+ */
+size_t metrics_format_prometheus(char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
@@ -0,0 +1,116 @@
+#ifndef MODEL_MEMORY_H
+#define MODEL_MEMORY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Model weight memory: how model files are read, where the weights live
+ * once loaded, and what loading them cost
+ *
+ * Model files are memory-mapped with sequential/WILLNEED advice, so the
+ * kernel reads ahead of the parser and a backend restart finds the file in
+ * the page cache. After loading, the large regions that hold the weights
+ * can be backed by transparent huge pages and pinned in RAM.
+ */
+
+/* Huge pages for the weight regions */
+typedef enum {
+    MODEL_HUGE_PAGES_OFF,
+    MODEL_HUGE_PAGES_TRANSPARENT,   /* madvise(MADV_HUGEPAGE); khugepaged collapses in the background */
+    MODEL_HUGE_PAGES_COLLAPSE       /* Also MADV_COLLAPSE, synchronously (Linux 6.1+) */
+} model_huge_pages_t;
+
+/* Loading options (see model_memory_default_params) */
+typedef struct {
+    bool mmap;                      /* Map model files with read-ahead advice instead of reading them */
+    bool mlock;                     /* Pin everything loaded so far in RAM */
+    model_huge_pages_t huge_pages;
+} model_memory_params_t;
+
+/* Memory footprint and page faults */
+typedef struct {
+    double rss_mb;                  /* Resident set size (peak where the current one is unavailable) */
+    double huge_mb;                 /* Of which backed by huge pages (Linux) */
+    unsigned long minor_faults;     /* Page faults served without I/O */
+    unsigned long major_faults;     /* Page faults that read from disk */
+} model_memory_usage_t;
+
+/* A mapped model file (opaque) */
+typedef struct model_file model_file_t;
+
+/**
+ * Default loading options (mmap on, mlock and huge pages off)
+ * @return Parameters
+ */
+model_memory_params_t model_memory_default_params(void);
+
+/**
+ * Parse a huge page mode: "off", "thp" or "collapse"
+ * @param name Mode name
+ * @param mode Receives the mode
+ * @return true if name is a known mode
+ */
+bool model_memory_parse_huge_pages(const char *name, model_huge_pages_t *mode);
+
+/**
+ * Map a model file read-only and start reading it ahead
+ * @param path Model file path
+ * @return Mapped file or NULL on failure (including platforms without mmap)
+ */
+model_file_t* model_file_open(const char *path);
+
+/**
+ * Copy the next bytes of a mapped file, like fread()
+ * @param file Mapped file
+ * @param out Destination
+ * @param size Bytes wanted
+ * @return Bytes copied (less than size at the end of the file)
+ */
+size_t model_file_read(model_file_t *file, void *out, size_t size);
+
+/**
+ * Whether every byte has been read
+ * @param file Mapped file
+ * @return true at the end of the file
+ */
+bool model_file_eof(const model_file_t *file);
+
+/**
+ * Unmap a model file (its pages stay in the page cache)
+ * @param file Mapped file
+ */
+void model_file_close(model_file_t *file);
+
+/**
+ * Apply huge page and mlock options to the process once weights are loaded
+ * Huge pages are requested for every anonymous or model-file mapping of at
+ * least min_bytes, which is where the weight tensors live.
+ * @param params Loading options
+ * @param min_bytes Smallest mapping to consider
+ * @return true if every requested option took effect
+ */
+bool model_memory_apply(const model_memory_params_t *params, size_t min_bytes);
+
+/**
+ * Current footprint and page faults
+ * @param usage Receives the figures
+ * @param thread Count the calling thread's faults only (Linux), else the process's
+ */
+void model_memory_usage(model_memory_usage_t *usage, bool thread);
+
+/**
+ * Get last error message
+ * @return Error message string
+ */
+const char* model_memory_get_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MODEL_MEMORY_H */
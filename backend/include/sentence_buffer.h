@@ -0,0 +1,93 @@
+#ifndef SENTENCE_BUFFER_H
+#define SENTENCE_BUFFER_H
+
+#include "whisper_engine.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Sentence assembly between transcription and translation
+ *
+ * Whisper delivers one fragment per chunk, cut wherever the chunk ended and
+ * starting with the words its overlap shares with the previous chunk. The
+ * buffer drops those repeated words, joins the fragments and hands on
+ * complete sentences, each once: when a sentence ends inside a fragment or
+ * the next fragment confirms it, when the speaker pauses, or when the
+ * pending text has waited too long.
+ */
+
+/* Buffer context (opaque) */
+typedef struct sentence_buffer sentence_buffer_t;
+
+/* Longest pending text; anything longer is committed at a word boundary */
+#define SENTENCE_BUFFER_MAX_TEXT 1024
+
+/* Longest run of words a fragment may repeat from the previous one */
+#define SENTENCE_BUFFER_MAX_OVERLAP 16
+
+/* Commit rules (see sentence_buffer_default_params) */
+typedef struct {
+    int pause_ms;           /* Silence between fragments' audio that ends a sentence */
+    int idle_ms;            /* Commit pending text when no fragment has arrived for this long */
+    int max_latency_ms;     /* Commit pending text once its first words have waited this long */
+    int max_overlap_words;  /* Repeated words looked for at a fragment's start (max SENTENCE_BUFFER_MAX_OVERLAP) */
+} sentence_buffer_params_t;
+
+/* Sentence callback; timing spans the fragments the sentence came from
+ * (audio_start_ns from the first, every other field from the last), and
+ * first_id/last_id are the ids of those fragments (see sentence_buffer_push) */
+typedef void (*sentence_buffer_callback_t)(const char *sentence, const whisper_timing_t *timing,
+                                           uint64_t first_id, uint64_t last_id, void *user_data);
+
+/**
+ * Default parameters (800 ms pause, 3.5 s idle, 5 s maximum latency, 8 overlap words)
+ * @return Parameters
+ */
+sentence_buffer_params_t sentence_buffer_default_params(void);
+
+/**
+ * Create a buffer for one transcription stream
+ * @param params Commit rules, NULL for defaults
+ * @param callback Function to call with every committed sentence; it runs
+ *                 with the buffer locked and must not call back into it
+ * @param user_data User data to pass to callback
+ * @return Buffer or NULL on failure
+ */
+sentence_buffer_t* sentence_buffer_create(const sentence_buffer_params_t *params,
+                                          sentence_buffer_callback_t callback, void *user_data);
+
+/**
+ * Add a transcribed fragment; commits any sentence it completes
+ * @param buffer Buffer
+ * @param text Fragment text
+ * @param timing Timeline of the fragment's chunk, may be NULL
+ * @param id Caller's id for the fragment, handed back with the sentences it is part of
+ */
+void sentence_buffer_push(sentence_buffer_t *buffer, const char *text, const whisper_timing_t *timing, uint64_t id);
+
+/**
+ * Apply the idle and latency timers; call periodically from one thread
+ * @param buffer Buffer
+ * @param now_ns Current time on the trace_now_ns() clock
+ */
+void sentence_buffer_poll(sentence_buffer_t *buffer, uint64_t now_ns);
+
+/**
+ * Commit whatever is pending
+ * @param buffer Buffer
+ */
+void sentence_buffer_flush(sentence_buffer_t *buffer);
+
+/**
+ * Destroy buffer, discarding pending text
+ * @param buffer Buffer
+ */
+void sentence_buffer_destroy(sentence_buffer_t *buffer);
+
+/**
+ * Get last error message
+ * @return Error message string
+ */
+const char* sentence_buffer_get_error(void);
+
+#endif /* SENTENCE_BUFFER_H */
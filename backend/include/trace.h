@@ -0,0 +1,100 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per-stage trace spans, exported as Chrome trace JSON (chrome://tracing,
+ * ui.perfetto.dev)
+ *
+ * A span is the time between trace_begin() and trace_end() on one thread.
+ * Spans carry an id that ties the stages of one chunk together across
+ * threads: Whisper gives every chunk an id, makes it the delivering
+ * thread's context (trace_context) while the transcription callback runs,
+ * and the translation engine and IPC tag their spans with it.
+ *
+ * While tracing is off trace_begin() is a load and a branch, and
+ * trace_end() returns at once.
+ */
+
+/* Set while a trace is being recorded; read through trace_begin() */
+extern int trace_active;
+
+/**
+ * Start recording spans
+ * @param path File the trace is written to by trace_stop()
+ * @return true on success
+ */
+bool trace_start(const char *path);
+
+/**
+ * Stop recording and write the trace file
+ * @return true if the file was written
+ */
+bool trace_stop(void);
+
+/**
+ * Monotonic clock in nanoseconds
+ * @return Timestamp
+ */
+uint64_t trace_now_ns(void);
+
+/**
+ * Start a span
+ * @return Start timestamp, 0 when tracing is off
+ */
+static inline uint64_t trace_begin(void) {
+    return __atomic_load_n(&trace_active, __ATOMIC_RELAXED) ? trace_now_ns() : 0;
+}
+
+/**
+ * Record a span started with trace_begin()
+ * @param name Span name (string literal: kept by pointer)
+ * @param category Category (string literal), e.g. "audio", "asr", "mt", "ipc"
+ * @param start Value returned by trace_begin(); 0 records nothing
+ * @param id Chunk or request id, 0 for none
+ */
+void trace_end(const char *name, const char *category, uint64_t start, uint64_t id);
+
+/**
+ * Record a point event
+ * @param name Event name (string literal)
+ * @param category Category (string literal)
+ * @param id Chunk or request id, 0 for none
+ */
+void trace_instant(const char *name, const char *category, uint64_t id);
+
+/**
+ * Name the calling thread in the trace (copied)
+ * @param name Thread name
+ */
+void trace_thread_name(const char *name);
+
+/**
+ * Allocate an id for a chunk or request
+ * @return Id, never 0
+ */
+uint64_t trace_new_id(void);
+
+/**
+ * Set the id the calling thread is working on (0 clears it)
+ * @param id Chunk or request id
+ */
+void trace_set_context(uint64_t id);
+
+/**
+ * Id the calling thread is working on
+ * @return Id, 0 if none
+ */
+uint64_t trace_context(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRACE_H */
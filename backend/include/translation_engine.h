@@ -1,7 +1,9 @@
 #ifndef TRANSLATION_ENGINE_H
 #define TRANSLATION_ENGINE_H
 
+#include "model_memory.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stddef.h>
 
 #ifdef __cplusplus
@@ -13,22 +15,72 @@ extern "C" {
  *
  * Supports multilingual translation with T5 encoder-decoder architecture.
  * Uses existing llama.cpp infrastructure for zero new dependencies.
+ *
+ * Models without an encoder (instruction-tuned decoder-only LLMs) are
+ * prompted through the chat template in their GGUF metadata; the prompt
+ * prefix shared by all requests is decoded once and kept in the KV cache.
  */
 
 typedef struct translation_engine_t translation_engine_t;
 
+/* Requests waiting for the worker; translation_translate() refuses more */
+#define TRANSLATION_MAX_PENDING 8
+
+/* Target languages one request can be translated into at once */
+#define TRANSLATION_MAX_TARGETS 4
+
+/* Previous sentences a target can keep as context */
+#define TRANSLATION_MAX_CONTEXT 8
+
+/**
+ * Engine options (see translation_default_params)
+ *
+ * With context on, each target keeps its last few sentences and their
+ * translations, so terms and pronouns carry over from one sentence to the
+ * next. Decoder-only models keep them in the target's KV sequence and only
+ * decode each new sentence; T5 models re-encode them with the new sentence
+ * (the encoder sees the whole input at once) and prefill the previous
+ * translations into the decoder in one call.
+ */
+typedef struct {
+    model_memory_params_t memory;  /* Model loading options */
+    int context_sentences;         /* Previous sentences kept per target, 0 = off (max TRANSLATION_MAX_CONTEXT) */
+    int context_tokens;            /* Tokens those sentences may take per target; the oldest go first */
+} translation_params_t;
+
+/**
+ * One target language's translation of a request
+ */
+typedef struct {
+    const char *target_lang;  /* Target language code, as passed to translation_translate() */
+    const char *text;         /* Translated text (UTF-8) */
+} translation_output_t;
+
+/**
+ * Timeline of one translation request, in monotonic ns (trace_now_ns() clock)
+ */
+typedef struct {
+    uint64_t queued_ns;   /* translation_translate() accepted it */
+    uint64_t started_ns;  /* The worker took it */
+    uint64_t done_ns;     /* Translation finished */
+} translation_timing_t;
+
 /**
- * Callback for translation results
+ * Callback for translation results, once per request with every target
  *
- * @param translated_text The translated text (UTF-8)
+ * @param outputs One translation per target language, in request order;
+ *        only valid during the call
+ * @param num_outputs Number of targets
+ * @param timing Request timeline, only valid during the call
  * @param user_data User-provided context pointer
  */
-typedef void (*translation_callback_t)(const char *translated_text, void *user_data);
+typedef void (*translation_callback_t)(const translation_output_t *outputs, size_t num_outputs,
+                                       const translation_timing_t *timing, void *user_data);
 
 /**
  * Initialize translation engine with T5 model
  *
- * @param model_path Path to GGUF T5/mT5 model file
+ * @param model_path Path to GGUF T5/mT5 model, or a decoder-only model with a chat template
  * @param callback Callback function for translation results
  * @param user_data User context to pass to callback
  * @return Initialized engine or NULL on failure
@@ -40,25 +92,69 @@ translation_engine_t* translation_init(
 );
 
 /**
- * Translate text from source language to target language
+ * Default engine options (default model loading, no context; 256 context tokens once turned on)
+ * @return Parameters
+ */
+translation_params_t translation_default_params(void);
+
+/**
+ * Initialize translation engine with explicit options
+ *
+ * With params->memory.mmap the weights are used in place from the mapped file;
+ * mlock and huge pages are applied once the model and context are loaded.
+ *
+ * @param model_path Path to GGUF T5/mT5 model, or a decoder-only model with a chat template
+ * @param params Engine options, NULL for defaults
+ * @param callback Callback function for translation results
+ * @param user_data User context to pass to callback
+ * @return Initialized engine or NULL on failure
+ */
+translation_engine_t* translation_init_with_params(
+    const char *model_path,
+    const translation_params_t *params,
+    translation_callback_t callback,
+    void *user_data
+);
+
+/**
+ * Translate text from source language into one or more target languages
+ *
+ * Each target is a separate sequence of the same model: the prompts are
+ * encoded in one call (for decoder-only models, decoded in one call after
+ * a copy of the resident prefix) and the targets are decoded side by side,
+ * one token each per decoder call, until every target has finished.
  *
  * @param engine The translation engine
  * @param text Text to translate (UTF-8)
  * @param source_lang Source language code (e.g., "en", "fr", "auto")
- * @param target_lang Target language code (e.g., "en", "fr", "es")
+ * @param target_langs Target language codes (e.g., "en", "fr", "es")
+ * @param num_targets Number of targets (1..TRANSLATION_MAX_TARGETS)
  * @param user_data User context to pass to callback for this request
- * @return true if translation request was queued successfully
+ * @return true if translation request was queued successfully, false if
+ *         TRANSLATION_MAX_PENDING requests are already waiting
  *
- * Note: Translation is asynchronous. Result will be delivered via callback.
+ * Note: Translation is asynchronous. Results will be delivered via callback.
+ * Requests reuse preallocated buffers, so queueing one does not allocate.
  */
 bool translation_translate(
     translation_engine_t *engine,
     const char *text,
     const char *source_lang,
-    const char *target_lang,
+    const char *const *target_langs,
+    size_t num_targets,
     void *user_data
 );
 
+/**
+ * Run a short translation through the model so the first real request
+ * doesn't pay for first-touch allocations and setup. Blocks until done;
+ * the result is discarded and leaves no trace in the context.
+ *
+ * @param engine The translation engine
+ * @return true once the warm-up request has run
+ */
+bool translation_warm_up(translation_engine_t *engine);
+
 /**
  * Check if translation engine is ready
  *
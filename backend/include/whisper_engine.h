@@ -1,14 +1,104 @@
 #ifndef WHISPER_ENGINE_H
 #define WHISPER_ENGINE_H
 
+#include "model_memory.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 /* Whisper engine context (opaque) */
 typedef struct whisper_engine whisper_engine_t;
 
-/* Transcription result callback */
-typedef void (*transcription_callback_t)(const char *text, void *user_data);
+/* Per-stream decoding state on a shared model (opaque) */
+typedef struct whisper_stream whisper_stream_t;
+
+/* Maximum number of streams per engine */
+#define WHISPER_MAX_STREAMS 8
+
+/* Chunks a stream may have waiting for inference before the oldest is dropped */
+#define WHISPER_MAX_PENDING_CHUNKS 4
+
+/* Maximum number of whisper_state objects decoding concurrently */
+#define WHISPER_MAX_POOL_SIZE 4
+
+/* Models that can be resident at once (see whisper_engine_load_model) */
+#define WHISPER_MAX_MODELS 3
+
+/* Default chunking for whisper_engine_stream_push() */
+#define WHISPER_CHUNK_MS_DEFAULT 3000
+#define WHISPER_OVERLAP_MS_DEFAULT 1000
+
+/* Longest chunk a stream can be configured for */
+#define WHISPER_MAX_CHUNK_MS 30000
+
+/* Encoder context sizing: one position covers 20 ms of audio. The context is
+ * the segment plus a guard band of trailing silence, rounded up to a multiple
+ * of the granularity and capped at the model's 30 s window. */
+#define WHISPER_AUDIO_CTX_MS 20
+#define WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT 64
+#define WHISPER_AUDIO_CTX_GUARD_MS_DEFAULT 1000
+
+/* Engine tuning (see whisper_engine_default_params) */
+typedef struct {
+    int pool_size;          /* Concurrent decoder states, 0 = derive from core count */
+    int threads_per_state;  /* Compute threads per state, 0 = derive from core count */
+    int chunk_ms;           /* Chunk length cut by whisper_engine_stream_push() */
+    int overlap_ms;         /* Audio shared by consecutive chunks */
+    int audio_ctx_granularity; /* Encoder positions per step, 0 = always the full 30 s window */
+    int audio_ctx_guard_ms; /* Silence kept after the segment for accuracy */
+    int beam_size;          /* Beam search width, <= 1 = greedy */
+    bool pipeline;          /* Overlap one chunk's decoder with the next chunk's encoder */
+    model_memory_params_t memory; /* How model files are read and where weights live */
+} whisper_engine_params_t;
+
+/* Engine timings and load */
+typedef struct {
+    unsigned long chunks;   /* Chunks run through the model */
+    unsigned long dropped;  /* Chunks discarded because inference fell behind */
+    double mel_ms;          /* Log-mel feature extraction */
+    double inference_ms;    /* Encoder and decoder (the slower of the two when pipelined) */
+    double audio_ms;        /* New audio covered by the chunks (overlap excluded) */
+    double rtf;             /* Rolling real-time factor: inference time / new audio */
+    double load;            /* rtf x streams / pool_size; above 1.0 latency grows */
+    size_t queued;          /* Chunks waiting for a state */
+    unsigned long detections; /* Confident language detections (see whisper_engine_get_detected_language) */
+    unsigned long pipelined;     /* Chunks encoded and decoded as separate pipeline stages */
+    double encode_ms;            /* Their encoder stage */
+    double decode_ms;            /* Their decoder stage */
+    int encoder_threads;         /* Current split of a lane's threads (pipeline mode) */
+    int decoder_threads;
+    int streams;
+    int pool_size;          /* Concurrent states, or lanes when pipelined */
+} whisper_engine_stats_t;
+
+/**
+ * Default engine parameters (everything auto-tuned)
+ * @return Parameters
+ */
+whisper_engine_params_t whisper_engine_default_params(void);
+
+/**
+ * Encoder context the engine uses for a segment
+ * @param num_samples Segment length in samples (16kHz)
+ * @param granularity Positions per step, 0 for the full window
+ * @param guard_ms Silence kept after the segment
+ * @param n_audio_ctx The model's full context (1500 for every Whisper model)
+ * @return Value for whisper_full_params.audio_ctx (0 = full window)
+ */
+int whisper_engine_audio_ctx_for(size_t num_samples, int granularity, int guard_ms, int n_audio_ctx);
+
+/* Timeline of one transcription, in monotonic ns (trace_now_ns() clock) */
+typedef struct {
+    uint64_t audio_start_ns;  /* Capture time of the chunk's first new sample (overlap excluded) */
+    uint64_t audio_end_ns;    /* Capture time of its last sample */
+    uint64_t queued_ns;       /* Cut and queued for a decoder state */
+    uint64_t started_ns;      /* A state started on it */
+    uint64_t done_ns;         /* Inference finished */
+    uint64_t delivered_ns;    /* Handed to the callback, after earlier chunks of its stream */
+} whisper_timing_t;
+
+/* Transcription result callback; timing is only valid during the call */
+typedef void (*transcription_callback_t)(const char *text, const whisper_timing_t *timing, void *user_data);
 
 /**
  * Initialize Whisper engine
@@ -21,7 +111,28 @@ typedef void (*transcription_callback_t)(const char *text, void *user_data);
 whisper_engine_t* whisper_engine_init(const char *model_path, const char *language, transcription_callback_t callback, void *user_data);
 
 /**
- * Process audio samples for transcription
+ * Initialize Whisper engine with explicit tuning
+ * The model is loaded once; a pool of decoder states lets independent chunks
+ * run in parallel. Results are delivered in submission order per stream.
+ * With params->pipeline, each pool slot becomes a lane of two states that
+ * take turns: while one chunk is in the decoder, the next one is encoded,
+ * and the lane's threads are split between the stages by their measured
+ * cost. Steady-state throughput approaches the slower stage rather than
+ * the sum of both. Pipelined chunks decode greedily without temperature
+ * fallback; beam search disables pipelining.
+ * @param model_path Path to Whisper model file (.gguf)
+ * @param language Language code or NULL for auto-detect
+ * @param params Engine parameters, NULL for defaults
+ * @param callback Function to call when transcription is ready
+ * @param user_data User data to pass to callback
+ * @return Whisper engine context or NULL on failure
+ */
+whisper_engine_t* whisper_engine_init_with_params(const char *model_path, const char *language,
+                                                  const whisper_engine_params_t *params,
+                                                  transcription_callback_t callback, void *user_data);
+
+/**
+ * Process audio samples for transcription (synchronous, on the engine's default stream)
  * @param engine Whisper engine context
  * @param samples Audio samples (float32, mono, 16kHz)
  * @param num_samples Number of samples
@@ -29,12 +140,175 @@ whisper_engine_t* whisper_engine_init(const char *model_path, const char *langua
  */
 bool whisper_engine_process(whisper_engine_t *engine, const float *samples, size_t num_samples);
 
+/**
+ * Create an independent stream on the engine's model
+ * Streams share the model weights and the engine's pool of decoder states;
+ * each keeps its own queue position and result ordering.
+ * @param engine Whisper engine context
+ * @param user_data User data passed to the transcription callback for this stream
+ * @return Stream or NULL on failure
+ */
+whisper_stream_t* whisper_engine_stream_create(whisper_engine_t *engine, void *user_data);
+
+/**
+ * Queue audio for asynchronous transcription on a stream
+ * Chunks from all streams are run by the engine's state pool; the callback
+ * fires on a pool thread with the stream's user data, in submission order.
+ * @param engine Whisper engine context
+ * @param stream Stream created with whisper_engine_stream_create()
+ * @param samples Audio samples (float32, mono, 16kHz), copied
+ * @param num_samples Number of samples
+ * @return true if queued, false on failure
+ */
+bool whisper_engine_submit(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples);
+
+/**
+ * Feed captured audio to a stream
+ * The engine cuts it into overlapping chunks (params.chunk_ms / overlap_ms)
+ * and queues each one like whisper_engine_submit(). Log-mel frames are
+ * computed once as audio arrives, so frames shared by overlapping chunks are
+ * never recomputed.
+ * @param engine Whisper engine context
+ * @param stream Stream created with whisper_engine_stream_create()
+ * @param samples Audio samples (float32, mono, 16kHz)
+ * @param num_samples Number of samples
+ * @param capture_ns Capture time of the last sample (trace_now_ns() clock), 0 = now
+ * @return true on success, false on failure
+ */
+bool whisper_engine_stream_push(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples,
+                                uint64_t capture_ns);
+
+/**
+ * Destroy a stream, discarding any chunks still queued for it
+ * @param engine Whisper engine context
+ * @param stream Stream to destroy
+ */
+void whisper_engine_stream_destroy(whisper_engine_t *engine, whisper_stream_t *stream);
+
+/**
+ * Queue the audio each stream holds past its last chunk, then wait until
+ * every queued chunk has been decoded and its result delivered. Call once
+ * audio has stopped and before whisper_engine_cleanup, which discards
+ * whatever is still queued.
+ * @param engine Whisper engine context
+ */
+void whisper_engine_drain(whisper_engine_t *engine);
+
 /**
  * Cleanup Whisper engine
  * @param engine Whisper engine context
  */
 void whisper_engine_cleanup(whisper_engine_t *engine);
 
+/**
+ * Run a silent chunk through every decoder state, in parallel, so the first
+ * real chunk doesn't pay for first-touch allocations and setup. Blocks until
+ * done; chunks queued meanwhile wait for it.
+ * @param engine Whisper engine context
+ * @return true on success, false if the engine shut down first
+ */
+bool whisper_engine_warm_up(whisper_engine_t *engine);
+
+/**
+ * Get cumulative timings, with feature extraction reported apart from inference
+ * @param engine Whisper engine context
+ * @param stats Receives the timings
+ */
+void whisper_engine_get_stats(whisper_engine_t *engine, whisper_engine_stats_t *stats);
+
+/**
+ * Load another model next to the active one (blocks while loading; chunks
+ * keep decoding meanwhile). Models must use the same mel layout.
+ * @param engine Whisper engine context
+ * @param model_path Path to Whisper model file (.gguf)
+ * @return true if the model is resident
+ */
+bool whisper_engine_load_model(whisper_engine_t *engine, const char *model_path);
+
+/**
+ * Decode new chunks with a resident model; chunks already running finish on the old one
+ * @param engine Whisper engine context
+ * @param model_path Path given to whisper_engine_load_model() or init
+ * @return true on success, false if the model is not loaded
+ */
+bool whisper_engine_use_model(whisper_engine_t *engine, const char *model_path);
+
+/**
+ * Free a resident model that is not active (waits for chunks still using it)
+ * @param engine Whisper engine context
+ * @param model_path Model to unload
+ * @return true on success
+ */
+bool whisper_engine_unload_model(whisper_engine_t *engine, const char *model_path);
+
+/**
+ * Pin the language token a resident model decodes with, for models
+ * fine-tuned on one language. English-only (.en) models are pinned to "en"
+ * when loaded. While a pinned model is active and the engine auto-detects,
+ * detection runs on a resident multilingual model instead.
+ * @param engine Whisper engine context
+ * @param model_path Resident model
+ * @param language Language code, or NULL to follow the engine's language setting
+ * @return true on success
+ */
+bool whisper_engine_set_model_language(whisper_engine_t *engine, const char *model_path, const char *language);
+
+/**
+ * Whether a resident model can transcribe any language
+ * @param engine Whisper engine context
+ * @param model_path Resident model, or NULL for the active one
+ * @return true if multilingual and not pinned to a language
+ */
+bool whisper_engine_model_is_multilingual(whisper_engine_t *engine, const char *model_path);
+
+/**
+ * Path of the active model
+ * @param engine Whisper engine context
+ * @param model_path Receives the path
+ * @param size Size of model_path
+ */
+void whisper_engine_get_model(whisper_engine_t *engine, char *model_path, size_t size);
+
+/**
+ * Change decoding for subsequent chunks
+ * @param engine Whisper engine context
+ * @param beam_size Beam search width, <= 1 for greedy
+ * @param temperature_fallback Re-decode low-confidence segments at higher temperature
+ */
+void whisper_engine_set_decoding(whisper_engine_t *engine, int beam_size, bool temperature_fallback);
+
+/**
+ * Current decoding settings
+ * @param engine Whisper engine context
+ * @param beam_size Receives the beam width (1 = greedy), may be NULL
+ * @param temperature_fallback Receives the fallback setting, may be NULL
+ */
+void whisper_engine_get_decoding(whisper_engine_t *engine, int *beam_size, bool *temperature_fallback);
+
+/**
+ * Change the chunking of whisper_engine_stream_push() on all streams
+ * @param engine Whisper engine context
+ * @param chunk_ms Chunk length, at most whisper_engine_get_max_chunk_ms()
+ * @param overlap_ms Audio shared by consecutive chunks
+ * @return true on success
+ */
+bool whisper_engine_set_chunking(whisper_engine_t *engine, int chunk_ms, int overlap_ms);
+
+/**
+ * Current chunking
+ * @param engine Whisper engine context
+ * @param chunk_ms Receives the chunk length, may be NULL
+ * @param overlap_ms Receives the overlap, may be NULL
+ */
+void whisper_engine_get_chunking(whisper_engine_t *engine, int *chunk_ms, int *overlap_ms);
+
+/**
+ * Longest chunk the stream buffers hold (twice the initial chunk length)
+ * @param engine Whisper engine context
+ * @return Chunk length in ms
+ */
+int whisper_engine_get_max_chunk_ms(whisper_engine_t *engine);
+
 /**
  * Get last error message
  * @return Error message string
@@ -42,9 +316,11 @@ void whisper_engine_cleanup(whisper_engine_t *engine);
 const char* whisper_engine_get_error(void);
 
 /**
- * Get the detected language from the last transcription
+ * Get the language auto-detect has settled on
+ * Chunks are decoded with it, skipping whisper.cpp's own detection; it is
+ * re-checked every few seconds and dropped again when speech changes language.
  * @param engine Whisper engine context
- * @return Language code (e.g., "en", "fr") or NULL if not detected
+ * @return Language code (e.g., "en", "fr") or NULL if not confident yet
  */
 const char* whisper_engine_get_detected_language(whisper_engine_t *engine);
 
@@ -0,0 +1,73 @@
+#ifndef WHISPER_MEL_H
+#define WHISPER_MEL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ * Whisper-compatible log-mel feature extraction
+ *
+ * Reproduces whisper.cpp's log_mel_spectrogram (400-point Hann STFT, hop 160,
+ * Slaney mel filterbank, log10) one frame at a time so frames can be computed
+ * once as audio arrives and reused by every overlapping chunk. Normalization
+ * depends on the whole window and is applied per chunk.
+ */
+
+#define WHISPER_MEL_N_FFT 400
+#define WHISPER_MEL_HOP 160
+#define WHISPER_MEL_MAX_BINS 128
+
+/* Mel extractor with its own scratch buffers (opaque, not thread-safe) */
+typedef struct whisper_mel whisper_mel_t;
+
+/**
+ * Create a mel extractor
+ * @param n_mel Number of mel bins (80, or 128 for large-v3)
+ * @return Extractor or NULL on failure
+ */
+whisper_mel_t* whisper_mel_create(int n_mel);
+
+/**
+ * Number of mel bins
+ * @param mel Extractor
+ * @return Mel bins per frame
+ */
+int whisper_mel_n_mel(const whisper_mel_t *mel);
+
+/**
+ * Compute the log10 mel energies of one STFT frame
+ * @param mel Extractor
+ * @param samples Audio samples (float32, mono, 16kHz)
+ * @param num_samples Number of valid samples; later positions read as zero
+ * @param center Index of the frame center in samples (may be < WHISPER_MEL_N_FFT / 2)
+ * @param reflect_start Mirror samples before index 0 (whisper's padding at the start of a clip)
+ * @param out n_mel values
+ */
+void whisper_mel_frame(whisper_mel_t *mel, const float *samples, long num_samples,
+                       long center, bool reflect_start, float *out);
+
+/**
+ * Number of frames whisper.cpp computes from a clip, excluding its 30 s zero padding
+ * @param num_samples Clip length in samples
+ * @return Frame count
+ */
+int whisper_mel_frames_for(size_t num_samples);
+
+/**
+ * Normalize log10 mel frames and lay them out for whisper_set_mel_with_state()
+ * Frames past n_frames are filled with the value of digital silence.
+ * @param frames Frame-major log10 mel, n_frames x n_mel
+ * @param n_frames Number of computed frames
+ * @param n_mel Mel bins per frame
+ * @param n_len Frames in the output (>= n_frames)
+ * @param out Mel-major output, n_mel x n_len
+ */
+void whisper_mel_normalize(const float *frames, int n_frames, int n_mel, int n_len, float *out);
+
+/**
+ * Free extractor
+ * @param mel Extractor
+ */
+void whisper_mel_destroy(whisper_mel_t *mel);
+
+#endif /* WHISPER_MEL_H */
@@ -0,0 +1,51 @@
+#ifndef MOCK_ENV_H
+#define MOCK_ENV_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+
+/*
+ * Settings shared by the stand-in engines and the replay source
+ *
+ * The replay build links main.c unchanged, so its knobs come from the
+ * environment (VISUALIA_MOCK_*, VISUALIA_REPLAY_*) rather than the command line.
+ */
+
+/* Numeric environment variable, or fallback when unset or not a number */
+static inline double mock_env_double(const char *name, double fallback) {
+    const char *value = getenv(name);
+    if (!value || !*value) return fallback;
+    char *end;
+    double d = strtod(value, &end);
+    return end != value ? d : fallback;
+}
+
+/* String environment variable, or fallback when unset */
+static inline const char* mock_env_string(const char *name, const char *fallback) {
+    const char *value = getenv(name);
+    return value && *value ? value : fallback;
+}
+
+/* Sleep for ms milliseconds, resuming after signals */
+static inline void mock_sleep_ms(double ms) {
+    if (ms <= 0.0) return;
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000.0);
+    ts.tv_nsec = (long)((ms - (double)ts.tv_sec * 1000.0) * 1e6);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+/* Reproducible jitter in [-1, 1) for item 'seq' of source 'key' (splitmix64),
+ * so a replay with the same settings sees the same latencies */
+static inline double mock_jitter(uint64_t key, uint64_t seq) {
+    uint64_t z = key * 0x9E3779B97F4A7C15ull + seq + 1;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (double)(z >> 11) / (double)(1ull << 52) - 1.0;
+}
+
+#endif /* MOCK_ENV_H */
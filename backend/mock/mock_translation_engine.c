@@ -0,0 +1,252 @@
+#include "translation_engine.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
+#include "mock_env.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+/*
+ * Stand-in for the translation engine with synthetic latency and output
+ *
+ * Implements translation_engine.h without loading a model: one worker takes
+ * requests from the same bounded queue (TRANSLATION_MAX_PENDING) and sleeps
+ * instead of running the model. Configured from the environment:
+ *
+ *   VISUALIA_MOCK_LOAD_MS       Model load time (default 0)
+ *   VISUALIA_MOCK_MT_MS         Fixed time per request (default 20)
+ *   VISUALIA_MOCK_MT_TOKEN_MS   Time per decoder step, one step per word; targets of a
+ *                               request share the steps like the real engine's batch (default 0)
+ *   VISUALIA_MOCK_MT_JITTER_MS  Reproducible +/- jitter per request (default 0)
+ *   VISUALIA_MOCK_MT_TEXT       Translation for every target, default "[target] text"
+ */
+
+#define TRANSLATION_MAX_TEXT 1024
+
+typedef struct {
+    char text[TRANSLATION_MAX_TEXT];
+    char target_langs[TRANSLATION_MAX_TARGETS][16];
+    size_t num_targets;
+    void *user_data;
+    translation_timing_t timing;
+} translation_request_t;
+
+struct translation_engine_t {
+    translation_callback_t callback;
+    void *default_user_data;
+
+    double request_ms;
+    double token_ms;
+    double jitter_ms;
+    const char *text;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cv;
+    pthread_t worker;
+    bool worker_started;
+    bool shutdown;
+
+    translation_request_t slots[TRANSLATION_MAX_PENDING];
+    size_t queue_head;
+    size_t queue_count;
+    unsigned long requests;
+
+    metrics_histogram_t *latency_metric;
+    metrics_histogram_t *token_metric;
+    metrics_gauge_t *depth_metric;
+};
+
+/* One token per whitespace-separated word */
+static int count_tokens(const char *text) {
+    int n = 0;
+    bool in_word = false;
+    for (const char *p = text; *p; p++) {
+        bool space = isspace((unsigned char)*p) != 0;
+        if (!space && !in_word) n++;
+        in_word = !space;
+    }
+    return n;
+}
+
+static void* translation_worker(void *arg) {
+    translation_engine_t *engine = (translation_engine_t *)arg;
+    trace_thread_name("translation:mock");
+
+    pthread_mutex_lock(&engine->lock);
+    while (true) {
+        while (engine->queue_count == 0 && !engine->shutdown) {
+            pthread_cond_wait(&engine->cv, &engine->lock);
+        }
+        if (engine->shutdown && engine->queue_count == 0) break;
+
+        /* Copy out so the slot is free for the next request while we work */
+        translation_request_t req = engine->slots[engine->queue_head];
+        engine->queue_head = (engine->queue_head + 1) % TRANSLATION_MAX_PENDING;
+        engine->queue_count--;
+        metrics_gauge_set(engine->depth_metric, (double)engine->queue_count);
+        const unsigned long seq = engine->requests++;
+        pthread_mutex_unlock(&engine->lock);
+
+        req.timing.started_ns = trace_now_ns();
+        mock_sleep_ms(engine->request_ms + engine->jitter_ms * mock_jitter(0, seq));
+        const int n_tokens = count_tokens(req.text);
+        for (int i = 0; i < n_tokens && engine->token_ms > 0.0; i++) {
+            const uint64_t t_step = trace_now_ns();
+            mock_sleep_ms(engine->token_ms);
+            metrics_observe(engine->token_metric, (double)(trace_now_ns() - t_step) / 1e6);
+        }
+
+        char results[TRANSLATION_MAX_TARGETS][TRANSLATION_MAX_TEXT + 24];
+        translation_output_t outputs[TRANSLATION_MAX_TARGETS];
+        for (size_t t = 0; t < req.num_targets; t++) {
+            if (engine->text) {
+                snprintf(results[t], sizeof(results[t]), "%s", engine->text);
+            } else {
+                snprintf(results[t], sizeof(results[t]), "[%s] %s", req.target_langs[t], req.text);
+            }
+            outputs[t].target_lang = req.target_langs[t];
+            outputs[t].text = results[t];
+        }
+
+        req.timing.done_ns = trace_now_ns();
+        metrics_observe(engine->latency_metric, (double)(req.timing.done_ns - req.timing.queued_ns) / 1e6);
+        engine->callback(outputs, req.num_targets, &req.timing, req.user_data);
+
+        pthread_mutex_lock(&engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+translation_engine_t* translation_init(
+    const char *model_path,
+    translation_callback_t callback,
+    void *user_data
+) {
+    return translation_init_with_params(model_path, NULL, callback, user_data);
+}
+
+translation_params_t translation_default_params(void) {
+    translation_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.memory = model_memory_default_params();
+    params.context_tokens = 256;
+    return params;
+}
+
+translation_engine_t* translation_init_with_params(
+    const char *model_path,
+    const translation_params_t *params,
+    translation_callback_t callback,
+    void *user_data
+) {
+    (void)params;  /* No model: nothing to load or keep as context */
+
+    if (!model_path || !callback) {
+        LOG_ERROR("[Translation] Invalid parameters\n");
+        return NULL;
+    }
+
+    translation_engine_t *engine = calloc(1, sizeof(translation_engine_t));
+    if (!engine) {
+        LOG_ERROR("[Translation] Memory allocation failed\n");
+        return NULL;
+    }
+
+    engine->callback = callback;
+    engine->default_user_data = user_data;
+    engine->request_ms = mock_env_double("VISUALIA_MOCK_MT_MS", 20.0);
+    engine->token_ms = mock_env_double("VISUALIA_MOCK_MT_TOKEN_MS", 0.0);
+    engine->jitter_ms = mock_env_double("VISUALIA_MOCK_MT_JITTER_MS", 0.0);
+    engine->text = getenv("VISUALIA_MOCK_MT_TEXT");
+    engine->latency_metric = metrics_histogram("transcript_to_translation_ms",
+                                               "Transcript queued for translation to its translation delivered");
+    engine->token_metric = metrics_histogram("translation_token_ms", "One decoder step of the translation model");
+    engine->depth_metric = metrics_gauge("translation_queue_depth", "Transcripts waiting for the translation worker");
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->cv, NULL);
+
+    mock_sleep_ms(mock_env_double("VISUALIA_MOCK_LOAD_MS", 0.0));
+
+    if (pthread_create(&engine->worker, NULL, translation_worker, engine) != 0) {
+        LOG_ERROR("[Translation] Failed to start worker thread\n");
+        translation_cleanup(engine);
+        return NULL;
+    }
+    engine->worker_started = true;
+
+    LOG_INFO("[Translation] Mock engine: %s, %.0f ms + %.0f ms/token per request\n",
+            model_path, engine->request_ms, engine->token_ms);
+    return engine;
+}
+
+bool translation_translate(
+    translation_engine_t *engine,
+    const char *text,
+    const char *source_lang,
+    const char *const *target_langs,
+    size_t num_targets,
+    void *user_data
+) {
+    (void)source_lang;
+    if (!engine || !text || !target_langs || num_targets == 0 || num_targets > TRANSLATION_MAX_TARGETS) {
+        return false;
+    }
+    for (size_t t = 0; t < num_targets; t++) {
+        if (!target_langs[t]) return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    if (engine->queue_count >= TRANSLATION_MAX_PENDING) {
+        pthread_mutex_unlock(&engine->lock);
+        LOG_WARN("[Translation] Queue full, dropping request\n");
+        return false;
+    }
+
+    translation_request_t *slot =
+        &engine->slots[(engine->queue_head + engine->queue_count) % TRANSLATION_MAX_PENDING];
+    snprintf(slot->text, sizeof(slot->text), "%s", text);
+    for (size_t t = 0; t < num_targets; t++) {
+        snprintf(slot->target_langs[t], sizeof(slot->target_langs[t]), "%s", target_langs[t]);
+    }
+    slot->num_targets = num_targets;
+    slot->user_data = user_data ? user_data : engine->default_user_data;
+    memset(&slot->timing, 0, sizeof(slot->timing));
+    slot->timing.queued_ns = trace_now_ns();
+    engine->queue_count++;
+    metrics_gauge_set(engine->depth_metric, (double)engine->queue_count);
+    pthread_cond_signal(&engine->cv);
+    pthread_mutex_unlock(&engine->lock);
+    return true;
+}
+
+bool translation_warm_up(translation_engine_t *engine) {
+    if (!engine) return false;
+    LOG_INFO("[Translation] Warm-up: 0ms (mock)\n");
+    return true;
+}
+
+bool translation_is_ready(translation_engine_t *engine) {
+    return engine != NULL && engine->worker_started;
+}
+
+void translation_cleanup(translation_engine_t *engine) {
+    if (!engine) return;
+
+    /* Requests still queued are translated first, like the real engine */
+    pthread_mutex_lock(&engine->lock);
+    engine->shutdown = true;
+    pthread_cond_broadcast(&engine->cv);
+    pthread_mutex_unlock(&engine->lock);
+    if (engine->worker_started) {
+        pthread_join(engine->worker, NULL);
+    }
+
+    LOG_INFO("[Translation] %lu requests (mock)\n", engine->requests);
+    pthread_cond_destroy(&engine->cv);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine);
+}
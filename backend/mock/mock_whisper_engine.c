@@ -0,0 +1,922 @@
+#include "whisper_engine.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
+#include "mock_env.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+/*
+ * Stand-in for the Whisper engine with synthetic latency and output
+ *
+ * Implements whisper_engine.h without loading a model: audio is cut into
+ * chunks exactly like the real engine, queued on a pool of workers that
+ * sleep instead of decoding, and delivered in order per stream with the
+ * same backpressure (WHISPER_MAX_PENDING_CHUNKS) and timing fields. What is
+ * left is the pipeline around the model. Configured from the environment:
+ *
+ *   VISUALIA_MOCK_LOAD_MS        Model load time (default 0)
+ *   VISUALIA_MOCK_ASR_MS         Fixed inference time per chunk (default 50)
+ *   VISUALIA_MOCK_ASR_RTF        Inference time per ms of chunk audio (default 0)
+ *   VISUALIA_MOCK_ASR_JITTER_MS  Reproducible +/- jitter on top (default 0)
+ *   VISUALIA_MOCK_ASR_TEXT       Transcript for every chunk, default
+ *                                "chunk N: S-E s" with the stream position
+ *   VISUALIA_MOCK_SILENCE_RMS    Chunks quieter than this transcribe to "" (default 0.001)
+ *   VISUALIA_MOCK_LANGUAGE       Language auto-detect settles on (default "en")
+ */
+
+#define WHISPER_SAMPLE_RATE 16000
+#define WHISPER_MAX_TEXT 256
+#define WHISPER_REORDER_WINDOW 16
+#define WHISPER_DRAIN_MIN_MS 200
+#define WHISPER_RTF_SMOOTHING 0.2
+
+typedef struct {
+    char text[WHISPER_MAX_TEXT];
+    whisper_timing_t timing;
+    bool done;
+} whisper_result_t;
+
+struct whisper_stream {
+    void *user_data;
+    int index;                      /* Jitter key */
+    float *audio;                   /* Current chunk, overlap included */
+    size_t audio_len;
+    size_t audio_capacity;
+    size_t audio_start;             /* Stream position of audio[0], in samples */
+    uint64_t audio_end_ns;
+    unsigned long next_seq;
+    unsigned long deliver_seq;
+    size_t queued;
+    int running;
+    bool delivering;
+    bool flush;                     /* Dropped chunks left results for a worker to deliver */
+    whisper_result_t results[WHISPER_REORDER_WINDOW];
+};
+
+/* Jobs reserved per stream, like the real engine: the queue's worth plus
+ * the chunks running on it */
+#define WHISPER_JOBS_PER_STREAM (WHISPER_MAX_PENDING_CHUNKS + 2)
+
+/* A chunk waiting for a worker; recycled through engine->free_jobs */
+typedef struct whisper_job {
+    whisper_stream_t *stream;
+    unsigned long seq;
+    double audio_ms;                /* New audio (overlap excluded) */
+    double chunk_ms;                /* Whole chunk */
+    double start_s, end_s;          /* Stream position of the new audio */
+    bool silent;
+    double latency_ms;              /* Synthetic inference time */
+    whisper_timing_t timing;
+    struct whisper_job *next;
+} whisper_job_t;
+
+struct whisper_engine {
+    transcription_callback_t callback;
+    void *user_data;
+    char language[8];               /* Empty = auto-detect */
+    char detected[8];
+
+    char models[WHISPER_MAX_MODELS][512];
+    char model_language[WHISPER_MAX_MODELS][8];
+    int active;
+
+    int pool_size;
+    int beam_size;
+    bool temperature_fallback;
+    size_t chunk_samples;
+    size_t overlap_samples;
+    size_t max_chunk_samples;
+
+    double asr_ms;
+    double asr_rtf;
+    double jitter_ms;
+    const char *text;
+    double silence_rms;
+
+    pthread_mutex_t lock;
+    pthread_cond_t queue_cv;
+    pthread_cond_t done_cv;
+    whisper_job_t *queue_head;
+    whisper_job_t *queue_tail;
+    whisper_job_t *free_jobs;       /* Idle jobs, so steady-state chunking does not allocate */
+    pthread_t workers[WHISPER_MAX_POOL_SIZE];
+    int num_workers;
+    bool flush_pending;             /* Some stream has flush set */
+    bool shutdown;
+
+    whisper_stream_t *streams[WHISPER_MAX_STREAMS];
+    whisper_stream_t *default_stream;
+    whisper_engine_stats_t stats;
+    metrics_histogram_t *latency_metric;
+};
+
+static char last_error[256] = {0};
+
+/* Duration of num_samples at WHISPER_SAMPLE_RATE, in ns */
+static uint64_t samples_to_ns(size_t num_samples) {
+    return (uint64_t)num_samples * 1000000000ull / WHISPER_SAMPLE_RATE;
+}
+
+static size_t ms_to_samples(int ms) {
+    return (size_t)ms * WHISPER_SAMPLE_RATE / 1000;
+}
+
+whisper_engine_params_t whisper_engine_default_params(void) {
+    whisper_engine_params_t params;
+    params.pool_size = 0;
+    params.threads_per_state = 0;
+    params.chunk_ms = WHISPER_CHUNK_MS_DEFAULT;
+    params.overlap_ms = WHISPER_OVERLAP_MS_DEFAULT;
+    params.audio_ctx_granularity = WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT;
+    params.audio_ctx_guard_ms = WHISPER_AUDIO_CTX_GUARD_MS_DEFAULT;
+    params.beam_size = 1;
+    params.pipeline = false;
+    params.memory = model_memory_default_params();
+    return params;
+}
+
+int whisper_engine_audio_ctx_for(size_t num_samples, int granularity, int guard_ms, int n_audio_ctx) {
+    if (granularity <= 0 || n_audio_ctx <= 0) {
+        return 0;
+    }
+    if (guard_ms < 0) guard_ms = 0;
+
+    const size_t samples_per_pos = (size_t)WHISPER_SAMPLE_RATE * WHISPER_AUDIO_CTX_MS / 1000;
+    size_t positions = (num_samples + samples_per_pos - 1) / samples_per_pos;
+    positions += (size_t)(guard_ms + WHISPER_AUDIO_CTX_MS - 1) / WHISPER_AUDIO_CTX_MS;
+    positions = (positions + granularity - 1) / granularity * granularity;
+
+    if (positions >= (size_t)n_audio_ctx) {
+        return 0;
+    }
+    return (int)positions;
+}
+
+static int find_model(whisper_engine_t *engine, const char *model_path) {
+    for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+        if (engine->models[i][0] && strcmp(engine->models[i], model_path) == 0) return i;
+    }
+    return -1;
+}
+
+/* Register a model path; English-only names are pinned to "en" like real .en models */
+static int add_model(whisper_engine_t *engine, const char *model_path) {
+    for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+        if (engine->models[i][0]) continue;
+        snprintf(engine->models[i], sizeof(engine->models[i]), "%s", model_path);
+        snprintf(engine->model_language[i], sizeof(engine->model_language[i]), "%s",
+                 strstr(model_path, ".en.") ? "en" : "");
+        return i;
+    }
+    snprintf(last_error, sizeof(last_error), "Too many resident models (max %d)", WHISPER_MAX_MODELS);
+    return -1;
+}
+
+/* Hand finished chunks to the callback in sequence order (engine->lock held,
+ * released around each call) */
+static void deliver_results(whisper_engine_t *engine, whisper_stream_t *stream) {
+    if (stream->delivering) return;
+    stream->delivering = true;
+
+    while (stream->deliver_seq < stream->next_seq) {
+        whisper_result_t *result = &stream->results[stream->deliver_seq % WHISPER_REORDER_WINDOW];
+        if (!result->done) break;
+        stream->deliver_seq++;
+
+        if (result->text[0] && engine->callback) {
+            /* The slot can be reused once deliver_seq has moved past it */
+            whisper_result_t out = *result;
+            out.timing.delivered_ns = trace_now_ns();
+            metrics_observe(engine->latency_metric,
+                            (double)(out.timing.delivered_ns - out.timing.audio_end_ns) / 1e6);
+            pthread_mutex_unlock(&engine->lock);
+            engine->callback(out.text, &out.timing, stream->user_data);
+            pthread_mutex_lock(&engine->lock);
+        }
+    }
+
+    stream->delivering = false;
+    pthread_cond_broadcast(&engine->done_cv);
+}
+
+/* Deliver for the streams enqueue_chunk dropped chunks from (engine->lock held) */
+static void flush_dropped(whisper_engine_t *engine) {
+    engine->flush_pending = false;
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        whisper_stream_t *stream = engine->streams[i];
+        if (stream && stream->flush) {
+            stream->flush = false;
+            deliver_results(engine, stream);
+        }
+    }
+}
+
+/* Synthetic inference time of a chunk; beam search costs a quarter more per
+ * extra beam so the governor's quality steps have an effect (engine->lock held) */
+static double job_latency_ms(const whisper_engine_t *engine, const whisper_job_t *job) {
+    double ms = engine->asr_ms + engine->asr_rtf * job->chunk_ms;
+    if (engine->beam_size > 1) {
+        ms *= 1.0 + 0.25 * (engine->beam_size - 1);
+    }
+    return ms + engine->jitter_ms * mock_jitter((uint64_t)job->stream->index, job->seq);
+}
+
+static void run_job(whisper_engine_t *engine, whisper_job_t *job) {
+    whisper_stream_t *stream = job->stream;
+
+    mock_sleep_ms(job->latency_ms);
+
+    pthread_mutex_lock(&engine->lock);
+    job->timing.done_ns = trace_now_ns();
+    const double inference_ms = (double)(job->timing.done_ns - job->timing.started_ns) / 1e6;
+
+    whisper_engine_stats_t *stats = &engine->stats;
+    stats->chunks++;
+    stats->inference_ms += inference_ms;
+    stats->audio_ms += job->audio_ms;
+    if (job->audio_ms > 0.0) {
+        double rtf = inference_ms / job->audio_ms;
+        stats->rtf = stats->chunks == 1 ? rtf : stats->rtf + WHISPER_RTF_SMOOTHING * (rtf - stats->rtf);
+    }
+
+    whisper_result_t *result = &stream->results[job->seq % WHISPER_REORDER_WINDOW];
+    result->timing = job->timing;
+    if (job->silent) {
+        result->text[0] = '\0';
+    } else if (engine->text) {
+        snprintf(result->text, sizeof(result->text), "%s", engine->text);
+    } else {
+        snprintf(result->text, sizeof(result->text), "chunk %lu: %.2f-%.2f s", job->seq, job->start_s, job->end_s);
+    }
+    result->done = true;
+
+    /* Auto-detect settles on the configured language after the first speech */
+    if (!engine->language[0] && !engine->detected[0] && !job->silent) {
+        snprintf(engine->detected, sizeof(engine->detected), "%s", mock_env_string("VISUALIA_MOCK_LANGUAGE", "en"));
+        stats->detections++;
+    }
+
+    stream->running--;
+    deliver_results(engine, stream);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+static void* worker_thread(void *arg) {
+    whisper_engine_t *engine = (whisper_engine_t *)arg;
+    trace_thread_name("asr:mock");
+
+    pthread_mutex_lock(&engine->lock);
+    while (!engine->shutdown) {
+        if (engine->flush_pending) {
+            flush_dropped(engine);
+            continue;
+        }
+        whisper_job_t *job = engine->queue_head;
+        if (!job) {
+            pthread_cond_wait(&engine->queue_cv, &engine->lock);
+            continue;
+        }
+        engine->queue_head = job->next;
+        if (!engine->queue_head) engine->queue_tail = NULL;
+        job->stream->queued--;
+        job->stream->running++;
+        job->timing.started_ns = trace_now_ns();
+        job->latency_ms = job_latency_ms(engine, job);
+        pthread_mutex_unlock(&engine->lock);
+
+        run_job(engine, job);
+
+        pthread_mutex_lock(&engine->lock);
+        job->next = engine->free_jobs;
+        engine->free_jobs = job;
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+/* Remove the oldest queued chunk of a stream, leaving an empty result (engine->lock held) */
+static whisper_job_t* dequeue_stream_job(whisper_engine_t *engine, whisper_stream_t *stream) {
+    whisper_job_t *prev = NULL;
+    for (whisper_job_t *job = engine->queue_head; job; prev = job, job = job->next) {
+        if (job->stream != stream) continue;
+
+        if (prev) prev->next = job->next;
+        else engine->queue_head = job->next;
+        if (engine->queue_tail == job) engine->queue_tail = prev;
+        stream->queued--;
+
+        whisper_result_t *result = &stream->results[job->seq % WHISPER_REORDER_WINDOW];
+        result->text[0] = '\0';
+        result->done = true;
+        return job;
+    }
+    return NULL;
+}
+
+/* Same backpressure as the real engine: drop the stream's oldest queued
+ * chunk once WHISPER_MAX_PENDING_CHUNKS are waiting, and leave delivery to a
+ * worker rather than the capture thread (engine->lock held) */
+static bool enqueue_chunk(whisper_engine_t *engine, whisper_stream_t *stream, whisper_job_t *job) {
+    if (stream->queued >= WHISPER_MAX_PENDING_CHUNKS) {
+        whisper_job_t *dropped = dequeue_stream_job(engine, stream);
+        if (dropped) {
+            engine->stats.dropped++;
+            LOG_WARN("[Whisper] Inference backlog, dropped a queued chunk\n");
+            dropped->next = engine->free_jobs;
+            engine->free_jobs = dropped;
+            stream->flush = true;
+            engine->flush_pending = true;
+            pthread_cond_signal(&engine->queue_cv);
+        }
+    }
+
+    if (stream->next_seq - stream->deliver_seq >= WHISPER_REORDER_WINDOW) {
+        snprintf(last_error, sizeof(last_error), "Inference backlog full");
+        engine->stats.dropped++;
+        return false;
+    }
+
+    job->stream = stream;
+    job->seq = stream->next_seq++;
+    job->timing.queued_ns = trace_now_ns();
+    job->next = NULL;
+    stream->results[job->seq % WHISPER_REORDER_WINDOW].done = false;
+
+    if (engine->queue_tail) engine->queue_tail->next = job;
+    else engine->queue_head = job;
+    engine->queue_tail = job;
+    stream->queued++;
+    pthread_cond_signal(&engine->queue_cv);
+    return true;
+}
+
+static void release_job(whisper_engine_t *engine, whisper_job_t *job) {
+    if (!job) return;
+    pthread_mutex_lock(&engine->lock);
+    job->next = engine->free_jobs;
+    engine->free_jobs = job;
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/* Add count idle jobs */
+static void reserve_jobs(whisper_engine_t *engine, int count) {
+    for (int i = 0; i < count; i++) {
+        whisper_job_t *job = calloc(1, sizeof(whisper_job_t));
+        if (!job) return;
+        release_job(engine, job);
+    }
+}
+
+/* Take an idle job for a chunk (only a pool still growing allocates) and
+ * judge the chunk's speech */
+static whisper_job_t* create_job(whisper_engine_t *engine, const float *samples, size_t num_samples, size_t skip) {
+    pthread_mutex_lock(&engine->lock);
+    whisper_job_t *job = engine->free_jobs;
+    if (job) engine->free_jobs = job->next;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (job) {
+        memset(job, 0, sizeof(*job));
+    } else {
+        job = calloc(1, sizeof(whisper_job_t));
+        if (!job) {
+            snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+            return NULL;
+        }
+    }
+
+    /* Speech is judged on the new audio only */
+    double energy = 0.0;
+    for (size_t i = skip; i < num_samples; i++) {
+        energy += (double)samples[i] * samples[i];
+    }
+    const size_t n = num_samples - skip;
+    job->silent = n == 0 || sqrt(energy / (double)n) < engine->silence_rms;
+    job->audio_ms = (double)n * 1000.0 / WHISPER_SAMPLE_RATE;
+    job->chunk_ms = (double)num_samples * 1000.0 / WHISPER_SAMPLE_RATE;
+    return job;
+}
+
+whisper_engine_t* whisper_engine_init(const char *model_path, const char *language, transcription_callback_t callback, void *user_data) {
+    return whisper_engine_init_with_params(model_path, language, NULL, callback, user_data);
+}
+
+whisper_engine_t* whisper_engine_init_with_params(const char *model_path, const char *language,
+                                                  const whisper_engine_params_t *params,
+                                                  transcription_callback_t callback, void *user_data) {
+    if (!model_path || !callback) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return NULL;
+    }
+
+    whisper_engine_params_t defaults = whisper_engine_default_params();
+    if (!params) params = &defaults;
+
+    whisper_engine_t *engine = calloc(1, sizeof(whisper_engine_t));
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    engine->callback = callback;
+    engine->user_data = user_data;
+    if (language) snprintf(engine->language, sizeof(engine->language), "%s", language);
+    engine->pool_size = params->pool_size > 0 ? params->pool_size : 1;
+    if (engine->pool_size > WHISPER_MAX_POOL_SIZE) engine->pool_size = WHISPER_MAX_POOL_SIZE;
+    engine->beam_size = params->beam_size > 1 ? params->beam_size : 1;
+    engine->temperature_fallback = true;
+
+    int chunk_ms = params->chunk_ms > 0 ? params->chunk_ms : WHISPER_CHUNK_MS_DEFAULT;
+    if (chunk_ms > WHISPER_MAX_CHUNK_MS) chunk_ms = WHISPER_MAX_CHUNK_MS;
+    int overlap_ms = params->overlap_ms >= 0 && params->overlap_ms < chunk_ms ? params->overlap_ms : 0;
+    engine->chunk_samples = ms_to_samples(chunk_ms);
+    engine->overlap_samples = ms_to_samples(overlap_ms);
+    engine->max_chunk_samples = 2 * engine->chunk_samples;
+
+    engine->asr_ms = mock_env_double("VISUALIA_MOCK_ASR_MS", 50.0);
+    engine->asr_rtf = mock_env_double("VISUALIA_MOCK_ASR_RTF", 0.0);
+    engine->jitter_ms = mock_env_double("VISUALIA_MOCK_ASR_JITTER_MS", 0.0);
+    engine->text = getenv("VISUALIA_MOCK_ASR_TEXT");
+    engine->silence_rms = mock_env_double("VISUALIA_MOCK_SILENCE_RMS", 0.001);
+    engine->latency_metric = metrics_histogram("capture_to_transcript_ms",
+                                               "Last sample of a chunk captured to its transcript delivered");
+
+    mock_sleep_ms(mock_env_double("VISUALIA_MOCK_LOAD_MS", 0.0));
+    add_model(engine, model_path);
+    engine->active = 0;
+
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->queue_cv, NULL);
+    pthread_cond_init(&engine->done_cv, NULL);
+
+    for (int i = 0; i < engine->pool_size; i++) {
+        if (pthread_create(&engine->workers[i], NULL, worker_thread, engine) != 0) {
+            snprintf(last_error, sizeof(last_error), "Failed to start worker thread");
+            whisper_engine_cleanup(engine);
+            return NULL;
+        }
+        engine->num_workers++;
+    }
+
+    LOG_INFO("[Whisper] Mock engine: %s, %d worker(s), %.0f ms + %.2f x audio per chunk\n",
+            model_path, engine->pool_size, engine->asr_ms, engine->asr_rtf);
+    return engine;
+}
+
+whisper_stream_t* whisper_engine_stream_create(whisper_engine_t *engine, void *user_data) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return NULL;
+    }
+
+    whisper_stream_t *stream = calloc(1, sizeof(whisper_stream_t));
+    if (!stream) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+    stream->user_data = user_data;
+    stream->audio_capacity = engine->max_chunk_samples;
+    stream->audio = malloc(stream->audio_capacity * sizeof(float));
+    if (!stream->audio) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        free(stream);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (!engine->streams[i]) {
+            engine->streams[i] = stream;
+            stream->index = i;
+            pthread_mutex_unlock(&engine->lock);
+            reserve_jobs(engine, WHISPER_JOBS_PER_STREAM);
+            return stream;
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    snprintf(last_error, sizeof(last_error), "Too many streams (max %d)", WHISPER_MAX_STREAMS);
+    free(stream->audio);
+    free(stream);
+    return NULL;
+}
+
+bool whisper_engine_submit(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples) {
+    if (!engine || !stream || !samples || num_samples == 0) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    whisper_job_t *job = create_job(engine, samples, num_samples, 0);
+    if (!job) return false;
+    job->timing.audio_end_ns = trace_now_ns();
+    job->timing.audio_start_ns = job->timing.audio_end_ns - samples_to_ns(num_samples);
+
+    pthread_mutex_lock(&engine->lock);
+    bool queued = enqueue_chunk(engine, stream, job);
+    pthread_mutex_unlock(&engine->lock);
+    if (!queued) release_job(engine, job);
+    return queued;
+}
+
+/* Queue the buffered audio as a chunk whose first skip samples were already
+ * decoded, then keep all but its first advance samples */
+static bool push_chunk(whisper_engine_t *engine, whisper_stream_t *stream, size_t advance, size_t skip) {
+    bool ok = true;
+    whisper_job_t *job = create_job(engine, stream->audio, stream->audio_len, skip);
+    if (job) {
+        job->audio_ms = (double)advance * 1000.0 / WHISPER_SAMPLE_RATE;
+        job->start_s = (double)(stream->audio_start + skip) / WHISPER_SAMPLE_RATE;
+        job->end_s = (double)(stream->audio_start + stream->audio_len) / WHISPER_SAMPLE_RATE;
+        job->timing.audio_end_ns = stream->audio_end_ns;
+        job->timing.audio_start_ns = stream->audio_end_ns - samples_to_ns(advance);
+
+        pthread_mutex_lock(&engine->lock);
+        if (!enqueue_chunk(engine, stream, job)) {
+            job->next = engine->free_jobs;
+            engine->free_jobs = job;
+            ok = false;
+        }
+        pthread_mutex_unlock(&engine->lock);
+    } else {
+        ok = false;
+    }
+
+    const size_t keep = stream->audio_len - advance;
+    memmove(stream->audio, stream->audio + advance, keep * sizeof(float));
+    stream->audio_start += advance;
+    stream->audio_len = keep;
+    return ok;
+}
+
+bool whisper_engine_stream_push(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples,
+                                uint64_t capture_ns) {
+    if (!engine || !stream || !samples) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    const size_t chunk_samples = engine->chunk_samples;
+    const size_t overlap_samples = engine->overlap_samples;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (capture_ns == 0) capture_ns = trace_now_ns();
+
+    bool ok = true;
+    while (true) {
+        if (stream->audio_len >= chunk_samples) {
+            const size_t skip = stream->audio_start > 0 ? overlap_samples : 0;
+            if (!push_chunk(engine, stream, stream->audio_len - overlap_samples, skip)) {
+                ok = false;
+            }
+            continue;
+        }
+        if (num_samples == 0) break;
+
+        size_t room = chunk_samples - stream->audio_len;
+        size_t n = num_samples < room ? num_samples : room;
+
+        memcpy(stream->audio + stream->audio_len, samples, n * sizeof(float));
+        stream->audio_len += n;
+        samples += n;
+        num_samples -= n;
+        stream->audio_end_ns = capture_ns - samples_to_ns(num_samples);
+    }
+
+    return ok;
+}
+
+bool whisper_engine_process(whisper_engine_t *engine, const float *samples, size_t num_samples) {
+    if (!engine || !samples || num_samples == 0) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    if (!engine->default_stream) {
+        engine->default_stream = whisper_engine_stream_create(engine, engine->user_data);
+        if (!engine->default_stream) {
+            return false;
+        }
+    }
+
+    whisper_stream_t *stream = engine->default_stream;
+    whisper_job_t *job = create_job(engine, samples, num_samples, 0);
+    if (!job) return false;
+    job->timing.audio_end_ns = trace_now_ns();
+    job->timing.audio_start_ns = job->timing.audio_end_ns - samples_to_ns(num_samples);
+
+    /* Queue on the pool and wait until our result has been delivered */
+    pthread_mutex_lock(&engine->lock);
+    bool queued = enqueue_chunk(engine, stream, job);
+    if (queued) {
+        unsigned long seq = job->seq;
+        while (stream->deliver_seq <= seq && !engine->shutdown) {
+            pthread_cond_wait(&engine->done_cv, &engine->lock);
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!queued) release_job(engine, job);
+    return queued;
+}
+
+/* Remove stream from the engine and free it once no chunk is running on it */
+static void destroy_stream(whisper_engine_t *engine, whisper_stream_t *stream) {
+    pthread_mutex_lock(&engine->lock);
+
+    whisper_job_t *job;
+    while ((job = dequeue_stream_job(engine, stream)) != NULL) {
+        job->next = engine->free_jobs;
+        engine->free_jobs = job;
+    }
+    while ((stream->running > 0 || stream->delivering) && !engine->shutdown) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i] == stream) engine->streams[i] = NULL;
+    }
+    if (engine->default_stream == stream) engine->default_stream = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+    free(stream->audio);
+    free(stream);
+}
+
+void whisper_engine_stream_destroy(whisper_engine_t *engine, whisper_stream_t *stream) {
+    if (!engine || !stream) return;
+    destroy_stream(engine, stream);
+}
+
+/* Nothing queued, running or waiting for delivery (engine->lock held) */
+static bool drained(const whisper_engine_t *engine) {
+    if (engine->queue_head || engine->flush_pending) return false;
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        const whisper_stream_t *stream = engine->streams[i];
+        if (stream && (stream->running > 0 || stream->delivering || stream->deliver_seq != stream->next_seq)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void whisper_engine_drain(whisper_engine_t *engine) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    const size_t overlap_samples = engine->overlap_samples;
+    whisper_stream_t *streams[WHISPER_MAX_STREAMS];
+    memcpy(streams, engine->streams, sizeof(streams));
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        whisper_stream_t *stream = streams[i];
+        if (!stream) continue;
+        size_t skip = stream->audio_start > 0 ? overlap_samples : 0;
+        if (skip > stream->audio_len) skip = stream->audio_len;
+        const size_t tail = stream->audio_len - skip;
+        if ((double)tail * 1000.0 / WHISPER_SAMPLE_RATE >= WHISPER_DRAIN_MIN_MS) {
+            push_chunk(engine, stream, tail, skip);
+        }
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    while (!drained(engine) && !engine->shutdown) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_cleanup(whisper_engine_t *engine) {
+    if (!engine) return;
+
+    /* Stop the pool; chunks still queued (no whisper_engine_drain) are discarded */
+    pthread_mutex_lock(&engine->lock);
+    engine->shutdown = true;
+    pthread_cond_broadcast(&engine->queue_cv);
+    pthread_cond_broadcast(&engine->done_cv);
+    pthread_mutex_unlock(&engine->lock);
+    for (int i = 0; i < engine->num_workers; i++) {
+        pthread_join(engine->workers[i], NULL);
+    }
+
+    if (engine->stats.chunks > 0) {
+        LOG_INFO("[Whisper] %lu chunks (mock), %lu dropped, inference %.1f ms/chunk\n",
+                engine->stats.chunks, engine->stats.dropped, engine->stats.inference_ms / engine->stats.chunks);
+    }
+
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i]) {
+            destroy_stream(engine, engine->streams[i]);
+        }
+    }
+
+    while (engine->free_jobs) {
+        whisper_job_t *job = engine->free_jobs;
+        engine->free_jobs = job->next;
+        free(job);
+    }
+
+    pthread_cond_destroy(&engine->queue_cv);
+    pthread_cond_destroy(&engine->done_cv);
+    pthread_mutex_destroy(&engine->lock);
+    free(engine);
+}
+
+bool whisper_engine_warm_up(whisper_engine_t *engine) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+    LOG_INFO("[Whisper] Warm-up: %d states in 0 ms (mock)\n", engine->pool_size);
+    return true;
+}
+
+void whisper_engine_get_stats(whisper_engine_t *engine, whisper_engine_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    *stats = engine->stats;
+    for (whisper_job_t *job = engine->queue_head; job; job = job->next) {
+        stats->queued++;
+    }
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i]) stats->streams++;
+    }
+    stats->pool_size = engine->pool_size;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (stats->pool_size > 0) {
+        stats->load = stats->rtf * (double)(stats->streams > 0 ? stats->streams : 1) / stats->pool_size;
+    }
+}
+
+bool whisper_engine_load_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    bool resident = find_model(engine, model_path) >= 0;
+    pthread_mutex_unlock(&engine->lock);
+    if (resident) return true;
+
+    mock_sleep_ms(mock_env_double("VISUALIA_MOCK_LOAD_MS", 0.0));
+
+    pthread_mutex_lock(&engine->lock);
+    bool loaded = find_model(engine, model_path) >= 0 || add_model(engine, model_path) >= 0;
+    pthread_mutex_unlock(&engine->lock);
+    if (loaded) LOG_INFO("[Whisper] Loaded model %s (mock)\n", model_path);
+    return loaded;
+}
+
+bool whisper_engine_use_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int index = find_model(engine, model_path);
+    if (index >= 0) engine->active = index;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (index < 0) {
+        snprintf(last_error, sizeof(last_error), "Model not loaded: %s", model_path);
+        return false;
+    }
+    return true;
+}
+
+bool whisper_engine_unload_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int index = find_model(engine, model_path);
+    bool ok = index >= 0 && index != engine->active;
+    if (ok) engine->models[index][0] = '\0';
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!ok) {
+        snprintf(last_error, sizeof(last_error), index < 0 ? "Model not loaded: %s" : "Model is active: %s",
+                 model_path);
+    }
+    return ok;
+}
+
+bool whisper_engine_set_model_language(whisper_engine_t *engine, const char *model_path, const char *language) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int index = find_model(engine, model_path);
+    if (index >= 0) {
+        snprintf(engine->model_language[index], sizeof(engine->model_language[index]), "%s",
+                 language ? language : "");
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (index < 0) {
+        snprintf(last_error, sizeof(last_error), "Model not loaded: %s", model_path);
+        return false;
+    }
+    return true;
+}
+
+bool whisper_engine_model_is_multilingual(whisper_engine_t *engine, const char *model_path) {
+    if (!engine) return false;
+
+    pthread_mutex_lock(&engine->lock);
+    int index = model_path ? find_model(engine, model_path) : engine->active;
+    bool multilingual = index >= 0 && !engine->model_language[index][0];
+    pthread_mutex_unlock(&engine->lock);
+    return multilingual;
+}
+
+void whisper_engine_get_model(whisper_engine_t *engine, char *model_path, size_t size) {
+    if (!model_path || size == 0) return;
+    model_path[0] = '\0';
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    snprintf(model_path, size, "%s", engine->models[engine->active]);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_set_decoding(whisper_engine_t *engine, int beam_size, bool temperature_fallback) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    engine->beam_size = beam_size > 1 ? beam_size : 1;
+    engine->temperature_fallback = temperature_fallback;
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_get_decoding(whisper_engine_t *engine, int *beam_size, bool *temperature_fallback) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    if (beam_size) *beam_size = engine->beam_size;
+    if (temperature_fallback) *temperature_fallback = engine->temperature_fallback;
+    pthread_mutex_unlock(&engine->lock);
+}
+
+bool whisper_engine_set_chunking(whisper_engine_t *engine, int chunk_ms, int overlap_ms) {
+    if (!engine || chunk_ms <= 0 || overlap_ms < 0 || overlap_ms >= chunk_ms) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    const size_t chunk_samples = ms_to_samples(chunk_ms);
+    if (chunk_samples > engine->max_chunk_samples) {
+        snprintf(last_error, sizeof(last_error), "Chunk longer than %d ms",
+                 whisper_engine_get_max_chunk_ms(engine));
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->chunk_samples = chunk_samples;
+    engine->overlap_samples = ms_to_samples(overlap_ms);
+    pthread_mutex_unlock(&engine->lock);
+    return true;
+}
+
+void whisper_engine_get_chunking(whisper_engine_t *engine, int *chunk_ms, int *overlap_ms) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    if (chunk_ms) *chunk_ms = (int)(engine->chunk_samples * 1000 / WHISPER_SAMPLE_RATE);
+    if (overlap_ms) *overlap_ms = (int)(engine->overlap_samples * 1000 / WHISPER_SAMPLE_RATE);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+int whisper_engine_get_max_chunk_ms(whisper_engine_t *engine) {
+    if (!engine) return 0;
+    return (int)(engine->max_chunk_samples * 1000 / WHISPER_SAMPLE_RATE);
+}
+
+const char* whisper_engine_get_error(void) {
+    return last_error;
+}
+
+const char* whisper_engine_get_detected_language(whisper_engine_t *engine) {
+    if (!engine) return NULL;
+
+    pthread_mutex_lock(&engine->lock);
+    const char *language = engine->detected[0] ? engine->detected : NULL;
+    pthread_mutex_unlock(&engine->lock);
+    return language;
+}
@@ -0,0 +1,389 @@
+#include "audio.h"
+#include "audio_dsp.h"
+#include "logger.h"
+#include "trace.h"
+#include "mock_env.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <pthread.h>
+
+/*
+ * Replay audio source: implements audio.h by playing WAV files
+ *
+ * Each source's device is the path of a 16-bit PCM WAV (any rate, channels
+ * downmixed), or tone:SECONDS for synthetic audio (2 s of a 440 Hz tone,
+ * then 1 s of silence, repeated), so CI needs no fixture; the default input
+ * plays VISUALIA_REPLAY_FILE. Files are read up front and fed through the
+ * capture front-end (audio_dsp) in 100 ms periods, paced like a device:
+ *
+ *   VISUALIA_REPLAY_SPEED    Playback speed, 1 = real time, 0 = as fast as the pipeline takes it (default 1)
+ *   VISUALIA_REPLAY_LOOP     Start over at the end of the file, number of plays, 0 = forever (default 1)
+ *   VISUALIA_REPLAY_TAIL_MS  Silence played after the file, e.g. to flush the last chunk (default 0)
+ *   VISUALIA_REPLAY_EXIT_MS  Once every source has finished, wait this long and stop the
+ *                            backend as SIGTERM would; negative = keep running (default -1)
+ */
+
+/* Frames per period, as a fraction of the file's rate (100 ms) */
+#define REPLAY_PERIODS_PER_S 10
+
+/* Periods delivered more than this many periods late count as late reads */
+#define REPLAY_LATE_PERIODS 2.0
+
+static char last_error[256] = {0};
+
+typedef struct {
+    audio_context_t *ctx;
+    audio_dsp_t *dsp;
+    int16_t *pcm;                 /* Whole file, mono */
+    size_t frames;
+    unsigned int rate;
+    size_t period_frames;
+    void *user_data;
+    char label[32];
+    pthread_t thread;
+    bool thread_started;
+    audio_stats_t stats;          /* Guarded by ctx->lock */
+} replay_stream_t;
+
+struct audio_context {
+    replay_stream_t streams[AUDIO_MAX_SOURCES];
+    size_t num_streams;
+    audio_callback_t callback;
+    double speed;
+    int plays;
+    double tail_ms;
+    double exit_ms;
+    volatile bool running;
+    int finished;                 /* Streams at the end of their file, guarded by lock */
+    pthread_mutex_t lock;
+};
+
+static uint32_t read_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint16_t read_u16(const unsigned char *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+/* Load a 16-bit PCM WAV, downmixed to mono at its own rate */
+static bool load_wav(replay_stream_t *stream, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        snprintf(last_error, sizeof(last_error), "Cannot open '%s'", path);
+        return false;
+    }
+
+    unsigned char header[12];
+    if (fread(header, 1, 12, f) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+        snprintf(last_error, sizeof(last_error), "'%s' is not a WAV file", path);
+        fclose(f);
+        return false;
+    }
+
+    unsigned int rate = 0, channels = 0, bits = 0, format = 0;
+    int16_t *pcm = NULL;
+    size_t frames = 0;
+    unsigned char chunk[8];
+    while (fread(chunk, 1, 8, f) == 8) {
+        const uint32_t size = read_u32(chunk + 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            unsigned char fmt[16];
+            if (fread(fmt, 1, 16, f) != 16) break;
+            format = read_u16(fmt);
+            channels = read_u16(fmt + 2);
+            rate = read_u32(fmt + 4);
+            bits = read_u16(fmt + 14);
+            fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (memcmp(chunk, "data", 4) == 0 && format == 1 && bits == 16 && channels > 0) {
+            frames = size / (2 * channels);
+            pcm = malloc(frames * channels * sizeof(int16_t));
+            if (pcm && fread(pcm, 2 * channels, frames, f) != frames) {
+                free(pcm);
+                pcm = NULL;
+            }
+            break;
+        } else {
+            fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+        }
+    }
+    fclose(f);
+
+    if (!pcm || rate == 0 || frames == 0) {
+        snprintf(last_error, sizeof(last_error), "'%s' has no 16-bit PCM audio", path);
+        free(pcm);
+        return false;
+    }
+
+    /* Downmix in place */
+    for (size_t i = 0; i < frames; i++) {
+        int acc = 0;
+        for (unsigned int c = 0; c < channels; c++) acc += pcm[i * channels + c];
+        pcm[i] = (int16_t)(acc / (int)channels);
+    }
+
+    stream->pcm = pcm;
+    stream->frames = frames;
+    stream->rate = rate;
+    return true;
+}
+
+/* Synthesize tone:SECONDS audio at AUDIO_SAMPLE_RATE: speech-like
+ * stretches for the mock engine's silence check, with pauses between them */
+static bool load_tone(replay_stream_t *stream, const char *spec) {
+    const double seconds = atof(spec + strlen("tone:"));
+    const size_t frames = (size_t)(seconds * AUDIO_SAMPLE_RATE);
+    if (frames == 0) {
+        snprintf(last_error, sizeof(last_error), "'%s' has no duration", spec);
+        return false;
+    }
+
+    int16_t *pcm = malloc(frames * sizeof(int16_t));
+    if (!pcm) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return false;
+    }
+    for (size_t i = 0; i < frames; i++) {
+        const bool voiced = i % (3 * AUDIO_SAMPLE_RATE) < 2 * AUDIO_SAMPLE_RATE;
+        pcm[i] = voiced ? (int16_t)(8000.0 * sin(2.0 * M_PI * 440.0 * (double)i / AUDIO_SAMPLE_RATE)) : 0;
+    }
+
+    stream->pcm = pcm;
+    stream->frames = frames;
+    stream->rate = AUDIO_SAMPLE_RATE;
+    return true;
+}
+
+static double elapsed_ms(uint64_t from_ns) {
+    return (double)(trace_now_ns() - from_ns) / 1e6;
+}
+
+/* Deliver one period at its due time on the replay clock */
+static void play_period(replay_stream_t *stream, const int16_t *samples, size_t frames,
+                        uint64_t t_start, double due_ms, double *last_ms) {
+    audio_context_t *ctx = stream->ctx;
+    if (ctx->speed > 0.0) {
+        mock_sleep_ms(due_ms - elapsed_ms(t_start));
+    }
+
+    const double now = elapsed_ms(t_start);
+    const double period_ms = (double)frames * 1000.0 / stream->rate / (ctx->speed > 0.0 ? ctx->speed : 1.0);
+    const uint64_t span = trace_begin();
+    pthread_mutex_lock(&ctx->lock);
+    audio_stats_t *stats = &stream->stats;
+    stats->reads++;
+    if (stats->reads > 1) {
+        const double stall = now - *last_ms;
+        if (stall > stats->max_stall_ms) stats->max_stall_ms = stall;
+        if (ctx->speed > 0.0 && now - due_ms > REPLAY_LATE_PERIODS * period_ms) stats->late_reads++;
+    }
+    *last_ms = now;
+    audio_dsp_push_s16(stream->dsp, samples, frames, trace_now_ns(), ctx->callback, stream->user_data);
+    pthread_mutex_unlock(&ctx->lock);
+    trace_end("capture", "audio", span, 0);
+}
+
+static void* replay_thread(void *arg) {
+    replay_stream_t *stream = (replay_stream_t *)arg;
+    audio_context_t *ctx = stream->ctx;
+
+    char name[48];
+    snprintf(name, sizeof(name), "audio:%s", stream->label);
+    trace_thread_name(name);
+
+    const uint64_t t_start = trace_now_ns();
+    const double speed = ctx->speed > 0.0 ? ctx->speed : 1.0;
+    double played_frames = 0.0;
+    double last_ms = 0.0;
+
+    for (int play = 0; ctx->running && (ctx->plays <= 0 || play < ctx->plays); play++) {
+        for (size_t pos = 0; ctx->running && pos < stream->frames; pos += stream->period_frames) {
+            const size_t n = stream->frames - pos < stream->period_frames ? stream->frames - pos : stream->period_frames;
+            played_frames += (double)n;
+            play_period(stream, stream->pcm + pos, n, t_start, played_frames * 1000.0 / stream->rate / speed, &last_ms);
+        }
+    }
+
+    /* Trailing silence */
+    int16_t *silence = calloc(stream->period_frames, sizeof(int16_t));
+    const double tail_frames = ctx->tail_ms * stream->rate / 1000.0;
+    for (double done = 0.0; silence && ctx->running && done < tail_frames; done += (double)stream->period_frames) {
+        played_frames += (double)stream->period_frames;
+        play_period(stream, silence, stream->period_frames, t_start, played_frames * 1000.0 / stream->rate / speed,
+                    &last_ms);
+    }
+    free(silence);
+
+    if (!ctx->running) return NULL;
+    LOG_INFO("[Audio] '%s' replay finished: %.1f s of audio in %.1f s\n", stream->label,
+            played_frames / stream->rate, elapsed_ms(t_start) / 1000.0);
+
+    /* The last source to finish stops the backend */
+    pthread_mutex_lock(&ctx->lock);
+    const bool last = ++ctx->finished == (int)ctx->num_streams;
+    pthread_mutex_unlock(&ctx->lock);
+    if (last && ctx->exit_ms >= 0.0) {
+        const uint64_t t_end = trace_now_ns();
+        while (ctx->running && elapsed_ms(t_end) < ctx->exit_ms) {
+            mock_sleep_ms(ctx->exit_ms - elapsed_ms(t_end) < 50.0 ? ctx->exit_ms - elapsed_ms(t_end) : 50.0);
+        }
+        if (ctx->running) raise(SIGTERM);
+    }
+    return NULL;
+}
+
+static void close_stream(replay_stream_t *stream) {
+    audio_dsp_destroy(stream->dsp);
+    stream->dsp = NULL;
+    free(stream->pcm);
+    stream->pcm = NULL;
+}
+
+audio_params_t audio_default_params(void) {
+    audio_params_t params;
+    params.realtime = false;
+    params.rt_priority = 20;
+    params.affinity = NULL;
+    return params;
+}
+
+audio_context_t* audio_init(const audio_source_t *sources, size_t num_sources, audio_callback_t callback) {
+    return audio_init_with_params(sources, num_sources, callback, NULL);
+}
+
+audio_context_t* audio_init_with_params(const audio_source_t *sources, size_t num_sources,
+                                        audio_callback_t callback, const audio_params_t *params) {
+    (void)params;  /* Replay threads run at normal priority */
+
+    if (!callback) {
+        snprintf(last_error, sizeof(last_error), "Invalid callback");
+        return NULL;
+    }
+    if (!sources || num_sources == 0 || num_sources > AUDIO_MAX_SOURCES) {
+        snprintf(last_error, sizeof(last_error), "Invalid source count (1..%d)", AUDIO_MAX_SOURCES);
+        return NULL;
+    }
+
+    audio_context_t *ctx = calloc(1, sizeof(audio_context_t));
+    if (!ctx) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    ctx->callback = callback;
+    ctx->speed = mock_env_double("VISUALIA_REPLAY_SPEED", 1.0);
+    ctx->plays = (int)mock_env_double("VISUALIA_REPLAY_LOOP", 1.0);
+    ctx->tail_ms = mock_env_double("VISUALIA_REPLAY_TAIL_MS", 0.0);
+    ctx->exit_ms = mock_env_double("VISUALIA_REPLAY_EXIT_MS", -1.0);
+    pthread_mutex_init(&ctx->lock, NULL);
+
+    for (size_t i = 0; i < num_sources; i++) {
+        replay_stream_t *stream = &ctx->streams[i];
+        const char *label = sources[i].label ? sources[i].label : (sources[i].device ? sources[i].device : "default");
+        const char *path = sources[i].device ? sources[i].device : getenv("VISUALIA_REPLAY_FILE");
+        stream->ctx = ctx;
+        stream->user_data = sources[i].user_data;
+        snprintf(stream->label, sizeof(stream->label), "%s", label);
+
+        bool ok = false;
+        if (!path) {
+            snprintf(last_error, sizeof(last_error), "No file for '%s': set VISUALIA_REPLAY_FILE or use -s %s=FILE.wav",
+                     stream->label, stream->label);
+        } else if (strncmp(path, "tone:", 5) == 0 ? load_tone(stream, path) : load_wav(stream, path)) {
+            stream->period_frames = stream->rate / REPLAY_PERIODS_PER_S;
+            if (stream->period_frames == 0) stream->period_frames = 1;
+            stream->dsp = audio_dsp_create(stream->rate, stream->period_frames);
+            if (stream->dsp) {
+                ok = true;
+            } else {
+                snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+            }
+        }
+
+        if (!ok) {
+            close_stream(stream);
+            for (size_t j = 0; j < i; j++) {
+                close_stream(&ctx->streams[j]);
+            }
+            pthread_mutex_destroy(&ctx->lock);
+            free(ctx);
+            return NULL;
+        }
+        ctx->num_streams++;
+        LOG_INFO("[Audio] Replaying '%s' from %s (%.1f s, %u Hz -> %d Hz)\n", stream->label, path,
+                (double)stream->frames / stream->rate, stream->rate, AUDIO_SAMPLE_RATE);
+    }
+
+    if (ctx->speed > 0.0) {
+        LOG_INFO("[Audio] Initialized (replay at %.2fx, %zu source(s))\n", ctx->speed, ctx->num_streams);
+    } else {
+        LOG_INFO("[Audio] Initialized (replay unpaced, %zu source(s))\n", ctx->num_streams);
+    }
+    return ctx;
+}
+
+bool audio_start(audio_context_t *ctx) {
+    if (!ctx) return false;
+
+    ctx->running = true;
+    ctx->finished = 0;
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        replay_stream_t *stream = &ctx->streams[s];
+        memset(&stream->stats, 0, sizeof(stream->stats));
+        if (pthread_create(&stream->thread, NULL, replay_thread, stream) != 0) {
+            snprintf(last_error, sizeof(last_error), "Failed to create thread for '%s'", stream->label);
+            audio_stop(ctx);
+            return false;
+        }
+        stream->thread_started = true;
+    }
+
+    LOG_INFO("[Audio] Started replay\n");
+    return true;
+}
+
+void audio_stop(audio_context_t *ctx) {
+    if (!ctx) return;
+
+    ctx->running = false;
+    bool stopped = false;
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        replay_stream_t *stream = &ctx->streams[s];
+        if (stream->thread_started) {
+            pthread_join(stream->thread, NULL);
+            stream->thread_started = false;
+            stopped = true;
+        }
+    }
+    if (stopped) {
+        LOG_INFO("[Audio] Stopped replay\n");
+    }
+}
+
+bool audio_get_stats(audio_context_t *ctx, size_t source, audio_stats_t *stats) {
+    if (!ctx || !stats || source >= ctx->num_streams) return false;
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->streams[source].stats;
+    pthread_mutex_unlock(&ctx->lock);
+    return true;
+}
+
+void audio_cleanup(audio_context_t *ctx) {
+    if (!ctx) return;
+
+    audio_stop(ctx);
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        close_stream(&ctx->streams[s]);
+    }
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx);
+    LOG_INFO("[Audio] Cleanup complete\n");
+}
+
+const char* audio_get_error(void) {
+    return last_error;
+}
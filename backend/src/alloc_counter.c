@@ -0,0 +1,86 @@
+#include "alloc_counter.h"
+#include <stddef.h>
+#include <errno.h>
+
+#if defined(VISUALIA_ALLOC_COUNTER) && defined(__GLIBC__)
+
+/* glibc exports its allocator under these names as well, so the wrappers
+ * below can forward to it without dlsym (which itself allocates) */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void *ptr);
+
+static unsigned long long total_allocs = 0;
+static _Thread_local unsigned long long thread_allocs = 0;
+
+static inline void count_alloc(void) {
+    __atomic_fetch_add(&total_allocs, 1, __ATOMIC_RELAXED);
+    thread_allocs++;
+}
+
+void *malloc(size_t size) {
+    count_alloc();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    count_alloc();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_alloc();
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) {
+    if (alignment < sizeof(void *) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    count_alloc();
+    void *ptr = __libc_memalign(alignment, size);
+    if (!ptr && size > 0) {
+        return ENOMEM;
+    }
+    *out = ptr;
+    return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    count_alloc();
+    return __libc_memalign(alignment, size);
+}
+
+bool alloc_counter_available(void) {
+    return true;
+}
+
+unsigned long long alloc_counter_total(void) {
+    return __atomic_load_n(&total_allocs, __ATOMIC_RELAXED);
+}
+
+unsigned long long alloc_counter_thread(void) {
+    return thread_allocs;
+}
+
+#else
+
+bool alloc_counter_available(void) {
+    return false;
+}
+
+unsigned long long alloc_counter_total(void) {
+    return 0;
+}
+
+unsigned long long alloc_counter_thread(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,385 @@
+#include "asr_governor.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Chunks that must finish after a decision before the next one, so the
+ * rolling real-time factor reflects the new settings */
+#define GOVERNOR_MIN_CHUNKS 4
+
+/* Stepping up must leave the predicted load below this */
+#define GOVERNOR_STEP_UP_TARGET 0.75
+
+/* Assumed speedup of a step until it has been measured */
+#define GOVERNOR_DEFAULT_GAIN 2.0
+
+#define GOVERNOR_MAX_LEVELS 3
+#define GOVERNOR_MAX_STEPS 16
+#define GOVERNOR_MAX_PATH 512
+
+typedef enum {
+    KNOB_DECODING,
+    KNOB_CHUNK,
+    KNOB_MODEL
+} governor_knob_t;
+
+typedef struct {
+    int beam_size;
+    bool temperature_fallback;
+} decoding_level_t;
+
+/* A step down that can be undone */
+typedef struct {
+    governor_knob_t knob;
+    double load_before;       /* Load that triggered it */
+    double gain;              /* load_before / load measured afterwards, 0 until measured */
+} governor_step_t;
+
+struct asr_governor {
+    whisper_engine_t *engine;
+    asr_governor_params_t params;
+    asr_governor_callback_t callback;
+    void *user_data;
+
+    /* Ladders, best quality first */
+    decoding_level_t decoding[GOVERNOR_MAX_LEVELS];
+    int num_decoding;
+    int decoding_level;
+    int chunk_ms[GOVERNOR_MAX_LEVELS];
+    int num_chunk;
+    int chunk_level;
+    int overlap_ms;
+    char models[ASR_GOVERNOR_MAX_MODELS][GOVERNOR_MAX_PATH];
+    int num_models;
+    int model_level;
+
+    governor_step_t steps[GOVERNOR_MAX_STEPS];
+    int num_steps;
+    double last_decision_ms;
+    unsigned long chunks_at_decision;
+    unsigned long dropped_at_decision;
+    bool saturated;           /* Every knob is at its cheapest setting */
+
+    /* Background model switch */
+    pthread_t loader;
+    bool loading;
+    int load_target;
+    bool load_down;
+    double load_rtf;
+    double load_load;
+    pthread_mutex_t lock;
+    bool load_done;
+    bool load_ok;
+};
+
+static char last_error[256] = {0};
+
+static const char *knob_names[] = { "decoding", "chunk", "model" };
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+asr_governor_params_t asr_governor_default_params(void) {
+    asr_governor_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.high_load = 0.9;
+    params.low_load = 0.5;
+    params.hold_ms = 10000;
+    return params;
+}
+
+static void report(asr_governor_t *gov, bool down, governor_knob_t knob, double rtf, double load) {
+    const decoding_level_t *decoding = &gov->decoding[gov->decoding_level];
+
+    asr_governor_decision_t decision;
+    decision.action = down ? "step_down" : "step_up";
+    decision.knob = knob_names[knob];
+    decision.model = gov->models[gov->model_level];
+    decision.beam_size = decoding->beam_size;
+    decision.temperature_fallback = decoding->temperature_fallback;
+    decision.chunk_ms = gov->chunk_ms[gov->chunk_level];
+    decision.rtf = rtf;
+    decision.load = load;
+
+    LOG_INFO("[Governor] %s %s (rtf %.2f, load %.2f): model %s, beam %d%s, chunk %d ms\n",
+            decision.action, decision.knob, rtf, load, decision.model, decision.beam_size,
+            decision.temperature_fallback ? "" : " (no fallback)", decision.chunk_ms);
+
+    if (gov->callback) {
+        gov->callback(&decision, gov->user_data);
+    }
+}
+
+asr_governor_t* asr_governor_create(whisper_engine_t *engine, const asr_governor_params_t *params,
+                                    asr_governor_callback_t callback, void *user_data) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return NULL;
+    }
+
+    asr_governor_params_t defaults = asr_governor_default_params();
+    if (!params) params = &defaults;
+
+    asr_governor_t *gov = calloc(1, sizeof(asr_governor_t));
+    if (!gov) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    gov->engine = engine;
+    gov->params = *params;
+    gov->callback = callback;
+    gov->user_data = user_data;
+    pthread_mutex_init(&gov->lock, NULL);
+
+    /* Decoding: configured beam, then greedy, then greedy without fallback */
+    int beam_size = 1;
+    bool fallback = true;
+    whisper_engine_get_decoding(engine, &beam_size, &fallback);
+    gov->decoding[gov->num_decoding++] = (decoding_level_t){ beam_size, fallback };
+    if (beam_size > 1) {
+        gov->decoding[gov->num_decoding++] = (decoding_level_t){ 1, fallback };
+    }
+    if (fallback) {
+        gov->decoding[gov->num_decoding++] = (decoding_level_t){ 1, false };
+    }
+
+    /* Chunks: configured length up to the longest the stream buffers hold */
+    int chunk_ms = 0;
+    whisper_engine_get_chunking(engine, &chunk_ms, &gov->overlap_ms);
+    const int max_chunk_ms = whisper_engine_get_max_chunk_ms(engine);
+    gov->chunk_ms[gov->num_chunk++] = chunk_ms;
+    if (chunk_ms * 3 / 2 < max_chunk_ms) {
+        gov->chunk_ms[gov->num_chunk++] = chunk_ms * 3 / 2;
+    }
+    if (max_chunk_ms > chunk_ms) {
+        gov->chunk_ms[gov->num_chunk++] = max_chunk_ms;
+    }
+
+    /* Models: the one loaded now, then the fallbacks */
+    whisper_engine_get_model(engine, gov->models[0], GOVERNOR_MAX_PATH);
+    gov->num_models = 1;
+    for (size_t i = 0; i < params->num_models && gov->num_models < ASR_GOVERNOR_MAX_MODELS; i++) {
+        if (!params->models[i] || strcmp(params->models[i], gov->models[0]) == 0) continue;
+        snprintf(gov->models[gov->num_models++], GOVERNOR_MAX_PATH, "%s", params->models[i]);
+    }
+
+    gov->last_decision_ms = now_ms();
+    LOG_INFO("[Governor] %d decoding, %d chunk and %d model levels (load %.2f-%.2f)\n",
+            gov->num_decoding, gov->num_chunk, gov->num_models, params->low_load, params->high_load);
+    return gov;
+}
+
+/* Load, activate and swap in a model in the background */
+static void* loader_thread(void *arg) {
+    asr_governor_t *gov = (asr_governor_t*)arg;
+    const char *target = gov->models[gov->load_target];
+
+    char previous[GOVERNOR_MAX_PATH];
+    whisper_engine_get_model(gov->engine, previous, sizeof(previous));
+
+    bool ok = whisper_engine_load_model(gov->engine, target) && whisper_engine_use_model(gov->engine, target);
+    if (!ok) {
+        LOG_ERROR("[Governor] Model switch to %s failed: %s\n", target, whisper_engine_get_error());
+    } else if (strcmp(previous, target) != 0) {
+        whisper_engine_unload_model(gov->engine, previous);
+    }
+
+    pthread_mutex_lock(&gov->lock);
+    gov->load_ok = ok;
+    gov->load_done = true;
+    pthread_mutex_unlock(&gov->lock);
+    return NULL;
+}
+
+static bool start_model_switch(asr_governor_t *gov, int target, bool down, double rtf, double load) {
+    gov->load_target = target;
+    gov->load_down = down;
+    gov->load_rtf = rtf;
+    gov->load_load = load;
+    gov->load_done = false;
+
+    if (pthread_create(&gov->loader, NULL, loader_thread, gov) != 0) {
+        snprintf(last_error, sizeof(last_error), "Failed to create model loader thread");
+        return false;
+    }
+    gov->loading = true;
+    LOG_INFO("[Governor] Switching to %s in the background\n", gov->models[target]);
+    return true;
+}
+
+/* Returns true once no switch is in progress */
+static bool finish_model_switch(asr_governor_t *gov, const whisper_engine_stats_t *stats) {
+    if (!gov->loading) return true;
+
+    pthread_mutex_lock(&gov->lock);
+    bool done = gov->load_done;
+    bool ok = gov->load_ok;
+    pthread_mutex_unlock(&gov->lock);
+    if (!done) return false;
+
+    pthread_join(gov->loader, NULL);
+    gov->loading = false;
+    gov->last_decision_ms = now_ms();
+    gov->chunks_at_decision = stats->chunks;
+    gov->dropped_at_decision = stats->dropped;
+
+    if (!ok) {
+        /* Don't retry a model that can't be loaded */
+        if (gov->load_down) gov->num_models = gov->load_target;
+        return true;
+    }
+
+    gov->model_level = gov->load_target;
+    if (gov->load_down) {
+        if (gov->num_steps < GOVERNOR_MAX_STEPS) {
+            gov->steps[gov->num_steps++] = (governor_step_t){ KNOB_MODEL, gov->load_load, 0.0 };
+        }
+    } else {
+        gov->num_steps--;
+    }
+    report(gov, gov->load_down, KNOB_MODEL, gov->load_rtf, gov->load_load);
+    return true;
+}
+
+static void apply_decoding(asr_governor_t *gov) {
+    const decoding_level_t *level = &gov->decoding[gov->decoding_level];
+    whisper_engine_set_decoding(gov->engine, level->beam_size, level->temperature_fallback);
+}
+
+static void apply_chunk(asr_governor_t *gov) {
+    if (!whisper_engine_set_chunking(gov->engine, gov->chunk_ms[gov->chunk_level], gov->overlap_ms)) {
+        LOG_ERROR("[Governor] %s\n", whisper_engine_get_error());
+    }
+}
+
+/* The model knob is ours only while the engine runs the model we put there;
+ * the language router may have swapped in a language-specific one */
+static bool owns_model(asr_governor_t *gov) {
+    char active[GOVERNOR_MAX_PATH];
+    whisper_engine_get_model(gov->engine, active, sizeof(active));
+    return strcmp(active, gov->models[gov->model_level]) == 0;
+}
+
+/* Cheapen the first knob that still has room: decoding, chunk, then model */
+static bool step_down(asr_governor_t *gov, double rtf, double load) {
+    governor_knob_t knob;
+
+    if (gov->num_steps >= GOVERNOR_MAX_STEPS) {
+        return false;
+    } else if (gov->decoding_level + 1 < gov->num_decoding) {
+        gov->decoding_level++;
+        apply_decoding(gov);
+        knob = KNOB_DECODING;
+    } else if (gov->chunk_level + 1 < gov->num_chunk) {
+        gov->chunk_level++;
+        apply_chunk(gov);
+        knob = KNOB_CHUNK;
+    } else if (gov->model_level + 1 < gov->num_models && owns_model(gov)) {
+        return start_model_switch(gov, gov->model_level + 1, true, rtf, load);
+    } else {
+        return false;
+    }
+
+    gov->steps[gov->num_steps++] = (governor_step_t){ knob, load, 0.0 };
+    report(gov, true, knob, rtf, load);
+    return true;
+}
+
+/* Undo the most recent step if the predicted load leaves enough headroom */
+static bool step_up(asr_governor_t *gov, double rtf, double load) {
+    if (gov->num_steps == 0) return false;
+
+    governor_step_t *step = &gov->steps[gov->num_steps - 1];
+    double gain = step->gain > 0.0 ? step->gain : GOVERNOR_DEFAULT_GAIN;
+    if (load * gain >= GOVERNOR_STEP_UP_TARGET) {
+        return false;
+    }
+
+    switch (step->knob) {
+        case KNOB_DECODING:
+            gov->decoding_level--;
+            apply_decoding(gov);
+            break;
+        case KNOB_CHUNK:
+            gov->chunk_level--;
+            apply_chunk(gov);
+            break;
+        case KNOB_MODEL:
+            if (!owns_model(gov)) return false;
+            /* Popped when the switch completes */
+            return start_model_switch(gov, gov->model_level - 1, false, rtf, load);
+    }
+
+    gov->num_steps--;
+    report(gov, false, step->knob, rtf, load);
+    return true;
+}
+
+void asr_governor_update(asr_governor_t *gov) {
+    if (!gov) return;
+
+    whisper_engine_stats_t stats;
+    whisper_engine_get_stats(gov->engine, &stats);
+
+    if (!finish_model_switch(gov, &stats)) {
+        return;
+    }
+
+    /* Wait for enough chunks on the current settings */
+    if (stats.chunks < gov->chunks_at_decision + GOVERNOR_MIN_CHUNKS) {
+        return;
+    }
+
+    /* Measure what the last step down bought */
+    if (gov->num_steps > 0 && gov->steps[gov->num_steps - 1].gain == 0.0 && stats.load > 0.0) {
+        governor_step_t *step = &gov->steps[gov->num_steps - 1];
+        step->gain = step->load_before / stats.load;
+        if (step->gain < 1.0) step->gain = 1.0;
+    }
+
+    if (now_ms() - gov->last_decision_ms < gov->params.hold_ms) {
+        return;
+    }
+
+    const int streams = stats.streams > 0 ? stats.streams : 1;
+    const bool backlog = stats.queued > (size_t)streams || stats.dropped > gov->dropped_at_decision;
+    bool acted = false;
+
+    if (stats.load > gov->params.high_load || backlog) {
+        acted = step_down(gov, stats.rtf, stats.load);
+        if (!acted && !gov->saturated) {
+            LOG_WARN("[Governor] Falling behind (load %.2f) with every knob at its cheapest\n", stats.load);
+        }
+        gov->saturated = !acted;
+    } else if (stats.load < gov->params.low_load && stats.queued == 0) {
+        acted = step_up(gov, stats.rtf, stats.load);
+        gov->saturated = false;
+    }
+
+    if (acted) {
+        gov->last_decision_ms = now_ms();
+        gov->chunks_at_decision = stats.chunks;
+        gov->dropped_at_decision = stats.dropped;
+    }
+}
+
+void asr_governor_destroy(asr_governor_t *gov) {
+    if (!gov) return;
+
+    if (gov->loading) {
+        pthread_join(gov->loader, NULL);
+    }
+    pthread_mutex_destroy(&gov->lock);
+    free(gov);
+}
+
+const char* asr_governor_get_error(void) {
+    return last_error;
+}
@@ -0,0 +1,289 @@
+#include "asr_router.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define ROUTER_MAX_PATH 512
+
+typedef struct {
+    char language[8];
+    char model[ROUTER_MAX_PATH];
+    bool failed;              /* Failed to load; not retried */
+} router_route_t;
+
+struct asr_router {
+    whisper_engine_t *engine;
+    asr_router_params_t params;
+    asr_router_callback_t callback;
+    void *user_data;
+
+    char base[ROUTER_MAX_PATH];  /* Multilingual fallback, always resident */
+    router_route_t routes[ASR_ROUTER_MAX_ROUTES];
+    int num_routes;
+    int resident;             /* Route whose model is loaded besides the base, -1 = none */
+
+    /* Detection tracking */
+    unsigned long detections_seen;
+    char candidate[8];
+    int agree;
+    double candidate_since_ms;
+
+    /* Background load */
+    pthread_t loader;
+    bool loading;
+    int load_route;
+    pthread_mutex_t lock;
+    bool load_done;
+    bool load_ok;
+};
+
+static char last_error[256] = {0};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+asr_router_params_t asr_router_default_params(void) {
+    asr_router_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.discover_english = true;
+    params.min_detections = 2;
+    params.hold_ms = 15000;
+    return params;
+}
+
+static void report(asr_router_t *router, const char *action, const char *language, const char *model) {
+    LOG_INFO("[Router] %s %s: %s\n", action, language, model);
+
+    if (router->callback) {
+        asr_router_decision_t decision = { action, language, model };
+        router->callback(&decision, router->user_data);
+    }
+}
+
+static int find_route(const asr_router_t *router, const char *language) {
+    for (int i = 0; i < router->num_routes; i++) {
+        if (strcmp(router->routes[i].language, language) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void add_route(asr_router_t *router, const char *language, const char *model) {
+    if (router->num_routes >= ASR_ROUTER_MAX_ROUTES || find_route(router, language) >= 0) {
+        return;
+    }
+    router_route_t *route = &router->routes[router->num_routes++];
+    snprintf(route->language, sizeof(route->language), "%s", language);
+    snprintf(route->model, sizeof(route->model), "%s", model);
+    LOG_INFO("[Router] %s -> %s\n", route->language, route->model);
+}
+
+/* models/whisper-base.gguf -> models/whisper-base.en.gguf, if that file exists */
+static bool english_variant(const char *path, char *out, size_t size) {
+    const char *dot = strrchr(path, '.');
+    const char *slash = strrchr(path, '/');
+    const char *backslash = strrchr(path, '\\');
+    if (backslash > slash) slash = backslash;
+    if (!dot || (slash && dot < slash)) dot = path + strlen(path);
+
+    snprintf(out, size, "%.*s.en%s", (int)(dot - path), path, dot);
+
+    FILE *f = fopen(out, "rb");
+    if (!f) return false;
+    fclose(f);
+    return true;
+}
+
+asr_router_t* asr_router_create(whisper_engine_t *engine, const asr_router_params_t *params,
+                                asr_router_callback_t callback, void *user_data) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return NULL;
+    }
+
+    asr_router_params_t defaults = asr_router_default_params();
+    if (!params) params = &defaults;
+
+    if (!whisper_engine_model_is_multilingual(engine, NULL)) {
+        snprintf(last_error, sizeof(last_error), "Startup model is not multilingual");
+        return NULL;
+    }
+
+    asr_router_t *router = calloc(1, sizeof(asr_router_t));
+    if (!router) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    router->engine = engine;
+    router->params = *params;
+    router->callback = callback;
+    router->user_data = user_data;
+    router->resident = -1;
+    whisper_engine_get_model(engine, router->base, sizeof(router->base));
+
+    for (size_t i = 0; i < params->num_routes; i++) {
+        if (params->routes[i].language && params->routes[i].model) {
+            add_route(router, params->routes[i].language, params->routes[i].model);
+        }
+    }
+
+    char english[ROUTER_MAX_PATH];
+    if (params->discover_english && find_route(router, "en") < 0 &&
+        english_variant(router->base, english, sizeof(english))) {
+        add_route(router, "en", english);
+    }
+
+    if (router->num_routes == 0) {
+        snprintf(last_error, sizeof(last_error), "No language-specific models");
+        free(router);
+        return NULL;
+    }
+
+    pthread_mutex_init(&router->lock, NULL);
+    return router;
+}
+
+/* Load a route's model next to the base, pin its language and activate it */
+static void* loader_thread(void *arg) {
+    asr_router_t *router = (asr_router_t*)arg;
+    const router_route_t *route = &router->routes[router->load_route];
+
+    /* Keep at most one language-specific model resident */
+    if (router->resident >= 0 && router->resident != router->load_route) {
+        whisper_engine_unload_model(router->engine, router->routes[router->resident].model);
+    }
+
+    bool ok = whisper_engine_load_model(router->engine, route->model) &&
+              whisper_engine_set_model_language(router->engine, route->model, route->language) &&
+              whisper_engine_use_model(router->engine, route->model);
+    if (!ok) {
+        LOG_ERROR("[Router] Failed to route %s to %s: %s\n", route->language, route->model,
+                whisper_engine_get_error());
+        whisper_engine_unload_model(router->engine, route->model);
+    }
+
+    pthread_mutex_lock(&router->lock);
+    router->load_ok = ok;
+    router->load_done = true;
+    pthread_mutex_unlock(&router->lock);
+    return NULL;
+}
+
+static void start_route(asr_router_t *router, int route) {
+    router->load_route = route;
+    router->load_done = false;
+
+    if (pthread_create(&router->loader, NULL, loader_thread, router) != 0) {
+        LOG_ERROR("[Router] Failed to create model loader thread\n");
+        router->routes[route].failed = true;
+        return;
+    }
+    router->loading = true;
+    LOG_INFO("[Router] Preloading %s for %s\n", router->routes[route].model, router->routes[route].language);
+}
+
+/* Returns true once no load is in progress */
+static bool finish_route(asr_router_t *router) {
+    if (!router->loading) return true;
+
+    pthread_mutex_lock(&router->lock);
+    bool done = router->load_done;
+    bool ok = router->load_ok;
+    pthread_mutex_unlock(&router->lock);
+    if (!done) return false;
+
+    pthread_join(router->loader, NULL);
+    router->loading = false;
+
+    router_route_t *route = &router->routes[router->load_route];
+    if (!ok) {
+        route->failed = true;
+        router->resident = -1;
+        return true;
+    }
+
+    router->resident = router->load_route;
+    report(router, "route", route->language, route->model);
+    return true;
+}
+
+void asr_router_update(asr_router_t *router) {
+    if (!router || !finish_route(router)) return;
+
+    /* Only act while the engine runs the base or one of our routes; anything
+     * else was put there by someone else (the governor) */
+    char active[ROUTER_MAX_PATH];
+    whisper_engine_get_model(router->engine, active, sizeof(active));
+    int routed = -1;
+    if (strcmp(active, router->base) != 0) {
+        if (router->resident < 0 || strcmp(active, router->routes[router->resident].model) != 0) {
+            return;
+        }
+        routed = router->resident;
+    }
+
+    /* Fixed language: route straight away */
+    if (router->params.language) {
+        int route = find_route(router, router->params.language);
+        if (route >= 0 && route != routed && !router->routes[route].failed) {
+            start_route(router, route);
+        }
+        return;
+    }
+
+    whisper_engine_stats_t stats;
+    whisper_engine_get_stats(router->engine, &stats);
+    if (stats.detections == router->detections_seen) return;
+    router->detections_seen = stats.detections;
+
+    const char *detected = whisper_engine_get_detected_language(router->engine);
+    if (!detected) return;
+    char language[8];
+    snprintf(language, sizeof(language), "%s", detected);
+
+    if (strcmp(language, router->candidate) == 0) {
+        router->agree++;
+    } else {
+        snprintf(router->candidate, sizeof(router->candidate), "%s", language);
+        router->agree = 1;
+        router->candidate_since_ms = now_ms();
+    }
+
+    if (routed >= 0) {
+        /* Switching back is immediate: the base never leaves memory */
+        if (strcmp(language, router->routes[routed].language) != 0 &&
+            whisper_engine_use_model(router->engine, router->base)) {
+            report(router, "fallback", language, router->base);
+        }
+        return;
+    }
+
+    int route = find_route(router, language);
+    if (route >= 0 && !router->routes[route].failed &&
+        router->agree >= router->params.min_detections &&
+        now_ms() - router->candidate_since_ms >= router->params.hold_ms) {
+        start_route(router, route);
+    }
+}
+
+void asr_router_destroy(asr_router_t *router) {
+    if (!router) return;
+
+    if (router->loading) {
+        pthread_join(router->loader, NULL);
+    }
+    pthread_mutex_destroy(&router->lock);
+    free(router);
+}
+
+const char* asr_router_get_error(void) {
+    return last_error;
+}
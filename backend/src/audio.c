@@ -1,11 +1,117 @@
 #include "audio.h"
+#include "audio_dsp.h"
+#include "cpu_budget.h"
+#include "logger.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+/* Buffers collected more than this many periods apart are late */
+#define AUDIO_LATE_PERIODS 2.0
+
+/* Audio missing from the delivered stream beyond this is a gap */
+#define AUDIO_GAP_THRESHOLD_MS 40.0
+
+/* How fast the gap detector follows drift between device and system clocks */
+#define AUDIO_DRIFT_SMOOTHING 0.01
 
 static char last_error[256] = {0};
 
+/* Validate the source list passed to audio_init() */
+static bool check_sources(const audio_source_t *sources, size_t num_sources, audio_callback_t callback) {
+    if (!callback) {
+        snprintf(last_error, sizeof(last_error), "Invalid callback");
+        return false;
+    }
+    if (!sources || num_sources == 0) {
+        snprintf(last_error, sizeof(last_error), "No audio source");
+        return false;
+    }
+    if (num_sources > AUDIO_MAX_SOURCES) {
+        snprintf(last_error, sizeof(last_error), "Too many audio sources (max %d)", AUDIO_MAX_SOURCES);
+        return false;
+    }
+    return true;
+}
+
+static void copy_label(char *dest, size_t dest_size, const audio_source_t *source) {
+    const char *label = source->label ? source->label : (source->device ? source->device : "default");
+    snprintf(dest, dest_size, "%s", label);
+}
+
+audio_params_t audio_default_params(void) {
+    audio_params_t params;
+    params.realtime = false;
+    params.rt_priority = 20;  /* Above every SCHED_OTHER thread, below the audio server's */
+    params.affinity = NULL;
+    return params;
+}
+
+audio_context_t* audio_init(const audio_source_t *sources, size_t num_sources, audio_callback_t callback) {
+    return audio_init_with_params(sources, num_sources, callback, NULL);
+}
+
+static double audio_now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+
+/* Per-stream capture timing, for audio_stats_t */
+typedef struct {
+    double period_ms;       /* Duration of one buffer */
+    unsigned int rate;      /* Capture rate */
+    double start_ms;        /* Time of the first buffer, 0 before it */
+    double last_ms;         /* Time of the previous buffer */
+    double frames;          /* Frames delivered since the first buffer */
+    double lag_ms;          /* Baseline of wall clock minus delivered audio */
+} capture_monitor_t;
+
+static void monitor_reset(capture_monitor_t *mon, unsigned int rate, size_t period_frames) {
+    memset(mon, 0, sizeof(*mon));
+    mon->rate = rate;
+    mon->period_ms = period_frames * 1000.0 / rate;
+}
+
+/* Start counting afresh, keeping rate and period */
+static void monitor_restart(capture_monitor_t *mon) {
+    mon->start_ms = 0.0;
+    mon->last_ms = 0.0;
+    mon->frames = 0.0;
+    mon->lag_ms = 0.0;
+}
+
+/* Count a buffer and how long the stream waited for it */
+static void monitor_read(capture_monitor_t *mon, audio_stats_t *stats, double now) {
+    stats->reads++;
+    if (mon->last_ms > 0.0) {
+        const double interval = now - mon->last_ms;
+        if (interval > stats->max_stall_ms) stats->max_stall_ms = interval;
+        if (interval > AUDIO_LATE_PERIODS * mon->period_ms) stats->late_reads++;
+    }
+    mon->last_ms = now;
+}
+
+static void monitor_gap(audio_stats_t *stats, double lost_ms) {
+    stats->gaps++;
+    stats->lost_ms += lost_ms;
+    trace_instant("audio_gap", "audio", 0);
+}
+
 /* =================================================================
  * Platform-specific implementations
  * ================================================================= */
@@ -17,11 +123,23 @@ static char last_error[256] = {0};
 
 #define NUM_BUFFERS 3
 
-struct audio_context {
+typedef struct {
+    audio_context_t *ctx;
     AudioQueueRef queue;
     AudioQueueBufferRef buffers[NUM_BUFFERS];
-    audio_callback_t callback;
+    audio_dsp_t *dsp;
     void *user_data;
+    char label[32];
+    capture_monitor_t monitor;
+    Float64 next_sample;          /* Device sample time the next buffer should start at, -1 = unknown */
+    audio_stats_t stats;          /* Guarded by ctx->lock */
+} audio_stream_t;
+
+struct audio_context {
+    audio_stream_t streams[AUDIO_MAX_SOURCES];
+    size_t num_streams;
+    audio_callback_t callback;
+    audio_params_t params;
     bool running;
     pthread_mutex_t lock;
 };
@@ -31,28 +149,33 @@ static void audio_input_callback(void *user_data, AudioQueueRef queue,
                                  const AudioTimeStamp *start_time,
                                  UInt32 num_packets,
                                  const AudioStreamPacketDescription *packet_desc) {
-    (void)start_time;
     (void)packet_desc;
 
-    audio_context_t *ctx = (audio_context_t*)user_data;
+    audio_stream_t *stream = (audio_stream_t*)user_data;
+    audio_context_t *ctx = stream ? stream->ctx : NULL;
     if (!ctx || !ctx->running) return;
 
-    /* Convert int16 PCM to float32 */
-    int16_t *samples_i16 = (int16_t*)buffer->mAudioData;
+    /* Convert int16 PCM to float32 at AUDIO_SAMPLE_RATE (no allocation) */
+    const int16_t *samples_i16 = (const int16_t*)buffer->mAudioData;
     size_t num_samples = buffer->mAudioDataByteSize / sizeof(int16_t);
 
-    float *samples_f32 = malloc(num_samples * sizeof(float));
-    if (samples_f32) {
-        for (size_t i = 0; i < num_samples; i++) {
-            samples_f32[i] = (float)samples_i16[i] / 32768.0f;
-        }
+    const uint64_t span = trace_begin();
+    pthread_mutex_lock(&ctx->lock);
+    monitor_read(&stream->monitor, &stream->stats, audio_now_ms());
 
-        pthread_mutex_lock(&ctx->lock);
-        ctx->callback(samples_f32, num_samples, ctx->user_data);
-        pthread_mutex_unlock(&ctx->lock);
-
-        free(samples_f32);
+    /* Buffers carry their device sample time, so a jump is audio the queue dropped */
+    if (start_time && (start_time->mFlags & kAudioTimeStampSampleTimeValid)) {
+        const Float64 missing = start_time->mSampleTime - stream->next_sample;
+        if (stream->next_sample >= 0 && missing * 1000.0 / stream->monitor.rate > AUDIO_GAP_THRESHOLD_MS) {
+            monitor_gap(&stream->stats, missing * 1000.0 / stream->monitor.rate);
+        }
+        stream->next_sample = start_time->mSampleTime + num_packets;
     }
+    pthread_mutex_unlock(&ctx->lock);
+
+    /* The consumer runs unlocked: a slow one must not hold up the other sources */
+    audio_dsp_push_s16(stream->dsp, samples_i16, num_samples, trace_now_ns(), ctx->callback, stream->user_data);
+    trace_end("capture", "audio", span, 0);
 
     /* Re-enqueue buffer */
     if (ctx->running) {
@@ -60,26 +183,80 @@ static void audio_input_callback(void *user_data, AudioQueueRef queue,
     }
 }
 
-audio_context_t* audio_init(audio_callback_t callback, void *user_data) {
-    if (!callback) {
-        snprintf(last_error, sizeof(last_error), "Invalid callback");
-        return NULL;
+/* Resolve a device UID (NULL = default input) to a CoreAudio device */
+static AudioDeviceID find_input_device(const char *uid) {
+    AudioObjectPropertyAddress addr = {
+        kAudioHardwarePropertyDefaultInputDevice,
+        kAudioObjectPropertyScopeGlobal,
+        0  /* Main element */
+    };
+    AudioDeviceID device = kAudioObjectUnknown;
+    UInt32 size = sizeof(device);
+
+    if (!uid) {
+        if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &addr, 0, NULL, &size, &device) != noErr) {
+            return kAudioObjectUnknown;
+        }
+        return device;
     }
 
-    audio_context_t *ctx = calloc(1, sizeof(audio_context_t));
-    if (!ctx) {
-        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
-        return NULL;
+    CFStringRef cf_uid = CFStringCreateWithCString(NULL, uid, kCFStringEncodingUTF8);
+    if (!cf_uid) return kAudioObjectUnknown;
+    addr.mSelector = kAudioHardwarePropertyTranslateUIDToDevice;
+    if (AudioObjectGetPropertyData(kAudioObjectSystemObject, &addr, sizeof(cf_uid), &cf_uid, &size, &device) != noErr) {
+        device = kAudioObjectUnknown;
     }
+    CFRelease(cf_uid);
+    return device;
+}
 
-    ctx->callback = callback;
-    ctx->user_data = user_data;
-    ctx->running = false;
-    pthread_mutex_init(&ctx->lock, NULL);
+/* Nominal sample rate of a device, so CoreAudio doesn't resample */
+static unsigned int get_device_rate(AudioDeviceID device) {
+    if (device == kAudioObjectUnknown) {
+        return AUDIO_CAPTURE_RATE_DEFAULT;
+    }
+
+    AudioObjectPropertyAddress addr = {
+        kAudioDevicePropertyNominalSampleRate,
+        kAudioObjectPropertyScopeGlobal,
+        0  /* Main element */
+    };
+    Float64 rate = 0;
+    UInt32 size = sizeof(rate);
+    if (AudioObjectGetPropertyData(device, &addr, 0, NULL, &size, &rate) != noErr || rate < 8000.0) {
+        return AUDIO_CAPTURE_RATE_DEFAULT;
+    }
+    return (unsigned int)rate;
+}
+
+static void close_stream(audio_stream_t *stream) {
+    if (stream->queue) {
+        AudioQueueDispose(stream->queue, true);
+        stream->queue = NULL;
+    }
+    audio_dsp_destroy(stream->dsp);
+    stream->dsp = NULL;
+}
 
-    /* Set up audio format (16kHz, mono, 16-bit) */
+static bool open_stream(audio_stream_t *stream, const audio_source_t *source) {
+    AudioDeviceID device = find_input_device(source->device);
+    if (source->device && device == kAudioObjectUnknown) {
+        snprintf(last_error, sizeof(last_error), "Audio device not found: %s", source->device);
+        return false;
+    }
+
+    /* Capture at the device rate and resample ourselves */
+    const unsigned int capture_rate = get_device_rate(device);
+    const UInt32 buffer_frames = capture_rate / 10;  /* 100ms buffers */
+    stream->dsp = audio_dsp_create(capture_rate, buffer_frames);
+    if (!stream->dsp) {
+        snprintf(last_error, sizeof(last_error), "Failed to create audio front-end");
+        return false;
+    }
+
+    /* Set up audio format (native rate, mono, 16-bit) */
     AudioStreamBasicDescription format = {0};
-    format.mSampleRate = AUDIO_SAMPLE_RATE;
+    format.mSampleRate = capture_rate;
     format.mFormatID = kAudioFormatLinearPCM;
     format.mFormatFlags = kLinearPCMFormatFlagIsSignedInteger | kLinearPCMFormatFlagIsPacked;
     format.mBitsPerChannel = 16;
@@ -89,119 +266,378 @@ audio_context_t* audio_init(audio_callback_t callback, void *user_data) {
     format.mBytesPerPacket = format.mBytesPerFrame * format.mFramesPerPacket;
 
     /* Create audio queue */
-    OSStatus status = AudioQueueNewInput(&format, audio_input_callback, ctx,
-                                        NULL, kCFRunLoopCommonModes, 0, &ctx->queue);
+    OSStatus status = AudioQueueNewInput(&format, audio_input_callback, stream,
+                                        NULL, kCFRunLoopCommonModes, 0, &stream->queue);
     if (status != noErr) {
         snprintf(last_error, sizeof(last_error), "Failed to create audio queue: %d", (int)status);
-        free(ctx);
-        return NULL;
+        close_stream(stream);
+        return false;
+    }
+
+    /* Route the queue to the requested device (e.g. a loopback device for system audio) */
+    if (source->device) {
+        CFStringRef cf_uid = CFStringCreateWithCString(NULL, source->device, kCFStringEncodingUTF8);
+        status = cf_uid ? AudioQueueSetProperty(stream->queue, kAudioQueueProperty_CurrentDevice,
+                                                &cf_uid, sizeof(cf_uid)) : -1;
+        if (cf_uid) CFRelease(cf_uid);
+        if (status != noErr) {
+            snprintf(last_error, sizeof(last_error), "Failed to select audio device %s: %d",
+                     source->device, (int)status);
+            close_stream(stream);
+            return false;
+        }
     }
 
-    /* Allocate and enqueue buffers */
-    UInt32 buffer_size = (AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * sizeof(int16_t)) / 10;  /* 100ms buffers */
+    /* Allocate buffers */
+    UInt32 buffer_size = buffer_frames * AUDIO_CHANNELS * sizeof(int16_t);
     for (int i = 0; i < NUM_BUFFERS; i++) {
-        status = AudioQueueAllocateBuffer(ctx->queue, buffer_size, &ctx->buffers[i]);
+        status = AudioQueueAllocateBuffer(stream->queue, buffer_size, &stream->buffers[i]);
         if (status != noErr) {
             snprintf(last_error, sizeof(last_error), "Failed to allocate buffer: %d", (int)status);
-            AudioQueueDispose(ctx->queue, true);
+            close_stream(stream);
+            return false;
+        }
+    }
+
+    monitor_reset(&stream->monitor, capture_rate, buffer_frames);
+    LOG_INFO("[Audio] Opened source '%s' (%u Hz -> %d Hz)\n",
+            stream->label, capture_rate, AUDIO_SAMPLE_RATE);
+    return true;
+}
+
+audio_context_t* audio_init_with_params(const audio_source_t *sources, size_t num_sources,
+                                        audio_callback_t callback, const audio_params_t *params) {
+    if (!check_sources(sources, num_sources, callback)) {
+        return NULL;
+    }
+
+    audio_context_t *ctx = calloc(1, sizeof(audio_context_t));
+    if (!ctx) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    ctx->callback = callback;
+    ctx->params = params ? *params : audio_default_params();
+    ctx->running = false;
+    pthread_mutex_init(&ctx->lock, NULL);
+
+    for (size_t i = 0; i < num_sources; i++) {
+        audio_stream_t *stream = &ctx->streams[i];
+        stream->ctx = ctx;
+        stream->user_data = sources[i].user_data;
+        copy_label(stream->label, sizeof(stream->label), &sources[i]);
+
+        if (!open_stream(stream, &sources[i])) {
+            for (size_t j = 0; j < i; j++) {
+                close_stream(&ctx->streams[j]);
+            }
+            pthread_mutex_destroy(&ctx->lock);
             free(ctx);
             return NULL;
         }
+        ctx->num_streams++;
     }
 
-    fprintf(stderr, "[Audio] Initialized (macOS Core Audio)\n");
+    LOG_INFO("[Audio] Initialized (macOS Core Audio, %zu source(s))\n", ctx->num_streams);
     return ctx;
 }
 
 bool audio_start(audio_context_t *ctx) {
     if (!ctx) return false;
 
-    /* Enqueue all buffers */
-    for (int i = 0; i < NUM_BUFFERS; i++) {
-        AudioQueueEnqueueBuffer(ctx->queue, ctx->buffers[i], 0, NULL);
+    /* AudioQueue callbacks run on Core Audio's own thread, already at elevated priority */
+    if (ctx->params.realtime || ctx->params.affinity) {
+        LOG_INFO("[Audio] Capture priority and affinity are managed by Core Audio on macOS\n");
     }
 
     ctx->running = true;
-    OSStatus status = AudioQueueStart(ctx->queue, NULL);
-    if (status != noErr) {
-        snprintf(last_error, sizeof(last_error), "Failed to start audio queue: %d", (int)status);
-        ctx->running = false;
-        return false;
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        audio_stream_t *stream = &ctx->streams[s];
+        monitor_restart(&stream->monitor);
+        stream->next_sample = -1;
+        memset(&stream->stats, 0, sizeof(stream->stats));
+
+        /* Enqueue all buffers */
+        for (int i = 0; i < NUM_BUFFERS; i++) {
+            AudioQueueEnqueueBuffer(stream->queue, stream->buffers[i], 0, NULL);
+        }
+
+        OSStatus status = AudioQueueStart(stream->queue, NULL);
+        if (status != noErr) {
+            snprintf(last_error, sizeof(last_error), "Failed to start audio queue '%s': %d",
+                     stream->label, (int)status);
+            audio_stop(ctx);
+            return false;
+        }
     }
 
-    fprintf(stderr, "[Audio] Started recording\n");
+    LOG_INFO("[Audio] Started recording\n");
     return true;
 }
 
 void audio_stop(audio_context_t *ctx) {
-    if (!ctx) return;
+    if (!ctx || !ctx->running) return;
 
     ctx->running = false;
-    AudioQueueStop(ctx->queue, true);
-    fprintf(stderr, "[Audio] Stopped recording\n");
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        AudioQueueStop(ctx->streams[s].queue, true);
+    }
+    LOG_INFO("[Audio] Stopped recording\n");
+}
+
+bool audio_get_stats(audio_context_t *ctx, size_t source, audio_stats_t *stats) {
+    if (!ctx || !stats || source >= ctx->num_streams) return false;
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->streams[source].stats;
+    pthread_mutex_unlock(&ctx->lock);
+    return true;
 }
 
 void audio_cleanup(audio_context_t *ctx) {
     if (!ctx) return;
 
     audio_stop(ctx);
-    AudioQueueDispose(ctx->queue, true);
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        close_stream(&ctx->streams[s]);
+    }
     pthread_mutex_destroy(&ctx->lock);
     free(ctx);
-    fprintf(stderr, "[Audio] Cleanup complete\n");
+    LOG_INFO("[Audio] Cleanup complete\n");
 }
 
 #elif defined(PLATFORM_LINUX)
 /* ===== Linux PulseAudio Implementation ===== */
+#include <pulse/pulseaudio.h>
 #include <pulse/simple.h>
 #include <pulse/error.h>
-
-struct audio_context {
+#include <sched.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+typedef struct {
+    audio_context_t *ctx;
     pa_simple *pa;
-    audio_callback_t callback;
+    audio_dsp_t *dsp;
+    int16_t *buffer_i16;
+    size_t buffer_frames;
     void *user_data;
+    char label[32];
     pthread_t thread;
+    bool thread_started;
+    capture_monitor_t monitor;
+    audio_stats_t stats;          /* Guarded by ctx->lock */
+} audio_stream_t;
+
+struct audio_context {
+    audio_stream_t streams[AUDIO_MAX_SOURCES];
+    size_t num_streams;
+    audio_callback_t callback;
+    audio_params_t params;
     bool running;
     pthread_mutex_t lock;
 };
 
-static void* audio_thread(void *arg) {
-    audio_context_t *ctx = (audio_context_t*)arg;
-    const size_t buffer_samples = AUDIO_SAMPLE_RATE / 10;  /* 100ms */
-    int16_t *buffer_i16 = malloc(buffer_samples * sizeof(int16_t));
-    float *buffer_f32 = malloc(buffer_samples * sizeof(float));
+/* Gap detection for blocking reads: audio produced by the device so far is
+ * what was delivered plus what is still buffered (pending_ms). When wall
+ * time runs ahead of that, the server dropped audio. Slow clock drift is
+ * absorbed into the baseline. */
+static void monitor_delivered(capture_monitor_t *mon, audio_stats_t *stats, double now,
+                              size_t frames, double pending_ms) {
+    if (mon->start_ms == 0.0) {
+        mon->start_ms = now - mon->period_ms;  /* The first buffer started a period ago */
+    }
+    mon->frames += frames;
+
+    const double lag = (now - mon->start_ms) - (mon->frames * 1000.0 / mon->rate + pending_ms);
+    if (stats->reads <= 1) {
+        mon->lag_ms = lag;
+    } else if (lag - mon->lag_ms > AUDIO_GAP_THRESHOLD_MS) {
+        monitor_gap(stats, lag - mon->lag_ms);
+        mon->lag_ms = lag;
+    } else {
+        mon->lag_ms += AUDIO_DRIFT_SMOOTHING * (lag - mon->lag_ms);
+    }
+}
 
-    if (!buffer_i16 || !buffer_f32) {
-        free(buffer_i16);
-        free(buffer_f32);
-        return NULL;
+/* Apply the capture priority and affinity to the calling thread. Without
+ * RLIMIT_RTPRIO (or CAP_SYS_NICE) SCHED_FIFO is refused; a raised nice
+ * value is the fallback. */
+static void setup_capture_thread(const audio_stream_t *stream, const audio_params_t *params) {
+    if (params->affinity) {
+        if (cpu_budget_pin_thread(params->affinity)) {
+            LOG_INFO("[Audio] '%s' capture pinned to CPUs %s\n", stream->label, params->affinity);
+        } else {
+            LOG_WARN("[Audio] Cannot pin '%s' capture: %s\n", stream->label, cpu_budget_get_error());
+        }
+    }
+
+    if (!params->realtime) return;
+
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = params->rt_priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (rc == 0) {
+        LOG_INFO("[Audio] '%s' capture runs SCHED_FIFO priority %d\n", stream->label, params->rt_priority);
+        return;
     }
 
+    const pid_t tid = (pid_t)syscall(SYS_gettid);
+    if (setpriority(PRIO_PROCESS, (id_t)tid, -10) == 0) {
+        LOG_WARN("[Audio] SCHED_FIFO refused for '%s' (%s), running at nice -10; "
+               "allow it with 'rtprio' in /etc/security/limits.conf\n", stream->label, strerror(rc));
+    } else {
+        LOG_WARN("[Audio] SCHED_FIFO refused for '%s' (%s), normal priority; "
+               "allow it with 'rtprio' in /etc/security/limits.conf\n", stream->label, strerror(rc));
+    }
+}
+
+static void* audio_thread(void *arg) {
+    audio_stream_t *stream = (audio_stream_t*)arg;
+    audio_context_t *ctx = stream->ctx;
+
+    setup_capture_thread(stream, &ctx->params);
+
+    char name[48];
+    snprintf(name, sizeof(name), "audio:%s", stream->label);
+    trace_thread_name(name);
+
     while (ctx->running) {
         int error;
-        if (pa_simple_read(ctx->pa, buffer_i16, buffer_samples * sizeof(int16_t), &error) < 0) {
-            fprintf(stderr, "[Audio] Read error: %s\n", pa_strerror(error));
+        if (pa_simple_read(stream->pa, stream->buffer_i16, stream->buffer_frames * sizeof(int16_t), &error) < 0) {
+            LOG_ERROR("[Audio] Read error on '%s': %s\n", stream->label, pa_strerror(error));
             break;
         }
 
-        /* Convert to float32 */
-        for (size_t i = 0; i < buffer_samples; i++) {
-            buffer_f32[i] = (float)buffer_i16[i] / 32768.0f;
-        }
+        /* Audio still queued in the server counts as produced, not lost */
+        const double now = audio_now_ms();
+        pa_usec_t latency = pa_simple_get_latency(stream->pa, &error);
+        if (latency == (pa_usec_t)-1) latency = 0;
+
+        /* The last sample read was captured as long ago as the audio still queued */
+        const uint64_t capture_ns = trace_now_ns() - (uint64_t)latency * 1000ull;
 
+        /* Convert to float32 at AUDIO_SAMPLE_RATE */
+        const uint64_t span = trace_begin();
         pthread_mutex_lock(&ctx->lock);
-        ctx->callback(buffer_f32, buffer_samples, ctx->user_data);
+        monitor_read(&stream->monitor, &stream->stats, now);
+        monitor_delivered(&stream->monitor, &stream->stats, now, stream->buffer_frames, latency / 1000.0);
         pthread_mutex_unlock(&ctx->lock);
+
+        /* The consumer runs unlocked: a slow one must not hold up the other sources */
+        audio_dsp_push_s16(stream->dsp, stream->buffer_i16, stream->buffer_frames, capture_ns,
+                           ctx->callback, stream->user_data);
+        trace_end("capture", "audio", span, 0);
     }
 
-    free(buffer_i16);
-    free(buffer_f32);
     return NULL;
 }
 
-audio_context_t* audio_init(audio_callback_t callback, void *user_data) {
-    if (!callback) {
-        snprintf(last_error, sizeof(last_error), "Invalid callback");
+static void close_stream(audio_stream_t *stream) {
+    if (stream->pa) {
+        pa_simple_free(stream->pa);
+        stream->pa = NULL;
+    }
+    audio_dsp_destroy(stream->dsp);
+    stream->dsp = NULL;
+    free(stream->buffer_i16);
+    stream->buffer_i16 = NULL;
+}
+
+static void source_info_cb(pa_context *pc, const pa_source_info *info, int eol, void *user_data) {
+    (void)pc;
+    if (eol == 0 && info) {
+        *(unsigned int *)user_data = info->sample_spec.rate;
+    }
+}
+
+/* Sample rate of a source, so the server doesn't resample; pa_simple has no
+ * introspection, so this takes a short-lived context of its own */
+static unsigned int get_source_rate(const char *device) {
+    unsigned int rate = 0;
+    pa_mainloop *mainloop = pa_mainloop_new();
+    if (!mainloop) {
+        return AUDIO_CAPTURE_RATE_DEFAULT;
+    }
+
+    pa_context *pc = pa_context_new(pa_mainloop_get_api(mainloop), "VisualIA");
+    if (pc && pa_context_connect(pc, NULL, PA_CONTEXT_NOFLAGS, NULL) >= 0) {
+        pa_context_state_t state;
+        while ((state = pa_context_get_state(pc)) != PA_CONTEXT_READY && PA_CONTEXT_IS_GOOD(state)) {
+            if (pa_mainloop_iterate(mainloop, 1, NULL) < 0) break;
+        }
+
+        if (state == PA_CONTEXT_READY) {
+            pa_operation *op = pa_context_get_source_info_by_name(pc, device ? device : "@DEFAULT_SOURCE@",
+                                                                  source_info_cb, &rate);
+            while (op && pa_operation_get_state(op) == PA_OPERATION_RUNNING) {
+                if (pa_mainloop_iterate(mainloop, 1, NULL) < 0) break;
+            }
+            if (op) {
+                pa_operation_unref(op);
+            }
+        }
+        pa_context_disconnect(pc);
+    }
+    if (pc) {
+        pa_context_unref(pc);
+    }
+    pa_mainloop_free(mainloop);
+
+    return rate >= 8000 ? rate : AUDIO_CAPTURE_RATE_DEFAULT;
+}
+
+static bool open_stream(audio_stream_t *stream, const audio_source_t *source) {
+    const unsigned int capture_rate = get_source_rate(source->device);
+    stream->buffer_frames = capture_rate / 10;  /* 100ms */
+    stream->buffer_i16 = malloc(stream->buffer_frames * sizeof(int16_t));
+    stream->dsp = audio_dsp_create(capture_rate, stream->buffer_frames);
+    if (!stream->buffer_i16 || !stream->dsp) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        close_stream(stream);
+        return false;
+    }
+
+    /* PulseAudio sample spec */
+    pa_sample_spec ss = {
+        .format = PA_SAMPLE_S16LE,
+        .rate = capture_rate,
+        .channels = AUDIO_CHANNELS
+    };
+
+    /* Fragments of one read buffer: the server's default fragment can be
+     * seconds long, which delivers audio in bursts */
+    pa_buffer_attr attr;
+    attr.maxlength = (uint32_t)-1;
+    attr.tlength = (uint32_t)-1;
+    attr.prebuf = (uint32_t)-1;
+    attr.minreq = (uint32_t)-1;
+    attr.fragsize = (uint32_t)(stream->buffer_frames * sizeof(int16_t));
+
+    /* device may name any source, including "<sink>.monitor" or "@DEFAULT_MONITOR@" */
+    int error;
+    stream->pa = pa_simple_new(NULL, "VisualIA", PA_STREAM_RECORD, source->device,
+                               stream->label, &ss, NULL, &attr, &error);
+    if (!stream->pa) {
+        snprintf(last_error, sizeof(last_error), "PulseAudio init failed for '%s': %s",
+                 stream->label, pa_strerror(error));
+        close_stream(stream);
+        return false;
+    }
+
+    monitor_reset(&stream->monitor, capture_rate, stream->buffer_frames);
+    LOG_INFO("[Audio] Opened source '%s' (%s, %u Hz -> %d Hz)\n", stream->label,
+            source->device ? source->device : "default", capture_rate, AUDIO_SAMPLE_RATE);
+    return true;
+}
+
+audio_context_t* audio_init_with_params(const audio_source_t *sources, size_t num_sources,
+                                        audio_callback_t callback, const audio_params_t *params) {
+    if (!check_sources(sources, num_sources, callback)) {
         return NULL;
     }
 
@@ -212,27 +648,28 @@ audio_context_t* audio_init(audio_callback_t callback, void *user_data) {
     }
 
     ctx->callback = callback;
-    ctx->user_data = user_data;
+    ctx->params = params ? *params : audio_default_params();
     ctx->running = false;
     pthread_mutex_init(&ctx->lock, NULL);
 
-    /* PulseAudio sample spec */
-    pa_sample_spec ss = {
-        .format = PA_SAMPLE_S16LE,
-        .rate = AUDIO_SAMPLE_RATE,
-        .channels = AUDIO_CHANNELS
-    };
+    for (size_t i = 0; i < num_sources; i++) {
+        audio_stream_t *stream = &ctx->streams[i];
+        stream->ctx = ctx;
+        stream->user_data = sources[i].user_data;
+        copy_label(stream->label, sizeof(stream->label), &sources[i]);
 
-    int error;
-    ctx->pa = pa_simple_new(NULL, "VisualIA", PA_STREAM_RECORD, NULL,
-                           "Audio Capture", &ss, NULL, NULL, &error);
-    if (!ctx->pa) {
-        snprintf(last_error, sizeof(last_error), "PulseAudio init failed: %s", pa_strerror(error));
-        free(ctx);
-        return NULL;
+        if (!open_stream(stream, &sources[i])) {
+            for (size_t j = 0; j < i; j++) {
+                close_stream(&ctx->streams[j]);
+            }
+            pthread_mutex_destroy(&ctx->lock);
+            free(ctx);
+            return NULL;
+        }
+        ctx->num_streams++;
     }
 
-    fprintf(stderr, "[Audio] Initialized (Linux PulseAudio)\n");
+    LOG_INFO("[Audio] Initialized (Linux PulseAudio, %zu source(s))\n", ctx->num_streams);
     return ctx;
 }
 
@@ -240,13 +677,19 @@ bool audio_start(audio_context_t *ctx) {
     if (!ctx) return false;
 
     ctx->running = true;
-    if (pthread_create(&ctx->thread, NULL, audio_thread, ctx) != 0) {
-        snprintf(last_error, sizeof(last_error), "Failed to create thread");
-        ctx->running = false;
-        return false;
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        audio_stream_t *stream = &ctx->streams[s];
+        monitor_restart(&stream->monitor);
+        memset(&stream->stats, 0, sizeof(stream->stats));
+        if (pthread_create(&stream->thread, NULL, audio_thread, stream) != 0) {
+            snprintf(last_error, sizeof(last_error), "Failed to create thread for '%s'", stream->label);
+            audio_stop(ctx);
+            return false;
+        }
+        stream->thread_started = true;
     }
 
-    fprintf(stderr, "[Audio] Started recording\n");
+    LOG_INFO("[Audio] Started recording\n");
     return true;
 }
 
@@ -254,20 +697,39 @@ void audio_stop(audio_context_t *ctx) {
     if (!ctx) return;
 
     ctx->running = false;
-    pthread_join(ctx->thread, NULL);
-    fprintf(stderr, "[Audio] Stopped recording\n");
+    bool stopped = false;
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        audio_stream_t *stream = &ctx->streams[s];
+        if (stream->thread_started) {
+            pthread_join(stream->thread, NULL);
+            stream->thread_started = false;
+            stopped = true;
+        }
+    }
+    if (stopped) {
+        LOG_INFO("[Audio] Stopped recording\n");
+    }
+}
+
+bool audio_get_stats(audio_context_t *ctx, size_t source, audio_stats_t *stats) {
+    if (!ctx || !stats || source >= ctx->num_streams) return false;
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->streams[source].stats;
+    pthread_mutex_unlock(&ctx->lock);
+    return true;
 }
 
 void audio_cleanup(audio_context_t *ctx) {
     if (!ctx) return;
 
     audio_stop(ctx);
-    if (ctx->pa) {
-        pa_simple_free(ctx->pa);
+    for (size_t s = 0; s < ctx->num_streams; s++) {
+        close_stream(&ctx->streams[s]);
     }
     pthread_mutex_destroy(&ctx->lock);
     free(ctx);
-    fprintf(stderr, "[Audio] Cleanup complete\n");
+    LOG_INFO("[Audio] Cleanup complete\n");
 }
 
 #elif defined(PLATFORM_WINDOWS)
@@ -281,10 +743,14 @@ struct audio_context {
     IMMDevice *device;
     IAudioClient *audio_client;
     IAudioCaptureClient *capture_client;
+    audio_dsp_t *dsp;
     audio_callback_t callback;
+    audio_params_t params;
     void *user_data;
     HANDLE thread;
     HANDLE stop_event;
+    capture_monitor_t monitor;
+    audio_stats_t stats;          /* Guarded by lock */
     bool running;
     pthread_mutex_t lock;
 };
@@ -293,8 +759,13 @@ static DWORD WINAPI audio_thread(LPVOID arg) {
     audio_context_t *ctx = (audio_context_t*)arg;
     CoInitialize(NULL);
 
-    const DWORD buffer_samples = AUDIO_SAMPLE_RATE / 10;  /* 100ms */
-    float *buffer_f32 = malloc(buffer_samples * sizeof(float));
+    if (ctx->params.affinity && !cpu_budget_pin_thread(ctx->params.affinity)) {
+        LOG_WARN("[Audio] Cannot pin capture: %s\n", cpu_budget_get_error());
+    }
+    if (ctx->params.realtime && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        LOG_WARN("[Audio] Cannot raise capture thread priority\n");
+    }
+    trace_thread_name("audio");
 
     while (WaitForSingleObject(ctx->stop_event, 0) == WAIT_TIMEOUT) {
         UINT32 packet_length = 0;
@@ -308,15 +779,19 @@ static DWORD WINAPI audio_thread(LPVOID arg) {
             HRESULT hr = ctx->capture_client->lpVtbl->GetBuffer(ctx->capture_client, &data,
                                                                 &num_frames, &flags, NULL, NULL);
             if (SUCCEEDED(hr)) {
-                int16_t *samples_i16 = (int16_t*)data;
-                for (UINT32 i = 0; i < num_frames; i++) {
-                    buffer_f32[i] = (float)samples_i16[i] / 32768.0f;
-                }
-
+                const uint64_t span = trace_begin();
                 pthread_mutex_lock(&ctx->lock);
-                ctx->callback(buffer_f32, num_frames, ctx->user_data);
+                monitor_read(&ctx->monitor, &ctx->stats, audio_now_ms());
+                if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+                    monitor_gap(&ctx->stats, 0.0);  /* WASAPI does not say how much */
+                }
                 pthread_mutex_unlock(&ctx->lock);
 
+                /* The consumer runs unlocked, so audio_get_stats never waits on it */
+                audio_dsp_push_s16(ctx->dsp, (const int16_t*)data, num_frames, trace_now_ns(),
+                                   ctx->callback, ctx->user_data);
+                trace_end("capture", "audio", span, 0);
+
                 ctx->capture_client->lpVtbl->ReleaseBuffer(ctx->capture_client, num_frames);
             }
 
@@ -326,12 +801,17 @@ static DWORD WINAPI audio_thread(LPVOID arg) {
         Sleep(10);
     }
 
-    free(buffer_f32);
     CoUninitialize();
     return 0;
 }
 
-audio_context_t* audio_init(audio_callback_t callback, void *user_data) {
+audio_context_t* audio_init_with_params(const audio_source_t *sources, size_t num_sources,
+                                        audio_callback_t callback, const audio_params_t *params) {
+    (void)params;
+    if (!check_sources(sources, num_sources, callback)) {
+        return NULL;
+    }
+
     /* WASAPI implementation - simplified for brevity */
     snprintf(last_error, sizeof(last_error), "Windows WASAPI not fully implemented yet");
     return NULL;
@@ -344,6 +824,15 @@ bool audio_start(audio_context_t *ctx) {
 void audio_stop(audio_context_t *ctx) {
 }
 
+bool audio_get_stats(audio_context_t *ctx, size_t source, audio_stats_t *stats) {
+    if (!ctx || !stats || source != 0) return false;
+
+    pthread_mutex_lock(&ctx->lock);
+    *stats = ctx->stats;
+    pthread_mutex_unlock(&ctx->lock);
+    return true;
+}
+
 void audio_cleanup(audio_context_t *ctx) {
 }
 
@@ -0,0 +1,309 @@
+#include "audio_dsp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* SIMD selection (compile-time; SSE2 is baseline on x86_64, NEON on arm64) */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define AUDIO_DSP_SSE2 1
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+    #define AUDIO_DSP_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#define DSP_PI 3.14159265358979323846
+
+/* Resampler design: zero crossings per side of the prototype sinc, passband edge
+ * as a fraction of the output Nyquist, and Kaiser window shape */
+#define RESAMPLER_ZERO_CROSSINGS 16
+#define RESAMPLER_ROLLOFF 0.92
+#define RESAMPLER_KAISER_BETA 8.0
+#define RESAMPLER_TAP_ALIGN 8
+
+struct audio_resampler {
+    unsigned int up;        /* Interpolation factor L */
+    unsigned int down;      /* Decimation factor M */
+    size_t taps;            /* Taps per phase (multiple of RESAMPLER_TAP_ALIGN) */
+    size_t max_input;
+    float *coefs;           /* up * taps, time-reversed per phase */
+    float *history;         /* taps - 1 samples of history + max_input new samples */
+    size_t pos;             /* Index in history of the next output's newest input */
+    unsigned int phase;     /* Polyphase branch of the next output */
+};
+
+struct audio_dsp {
+    unsigned int in_rate;
+    size_t max_frames;
+    audio_resampler_t *resampler;  /* NULL when capturing at AUDIO_SAMPLE_RATE */
+    float *converted;              /* max_frames */
+    float *resampled;              /* audio_resampler_max_output(max_frames) */
+};
+
+/* =================================================================
+ * Kernels
+ * ================================================================= */
+
+void audio_dsp_s16_to_f32(const int16_t *src, float *dst, size_t n) {
+    const float scale = 1.0f / 32768.0f;
+    size_t i = 0;
+
+#if defined(AUDIO_DSP_SSE2)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        /* Sign-extend by placing each int16 in the high half and shifting back */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#elif defined(AUDIO_DSP_NEON)
+    for (; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(src + i);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(dst + i, vmulq_n_f32(lo, scale));
+        vst1q_f32(dst + i + 4, vmulq_n_f32(hi, scale));
+    }
+#endif
+
+    for (; i < n; i++) {
+        dst[i] = (float)src[i] * scale;
+    }
+}
+
+/* Inner product of two float vectors; n is a multiple of RESAMPLER_TAP_ALIGN */
+static inline float dot_f32(const float *a, const float *b, size_t n) {
+#if defined(AUDIO_DSP_SSE2)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    return _mm_cvtss_f32(acc0);
+#elif defined(AUDIO_DSP_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float32x2_t sum = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+    float acc = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        acc += a[i] * b[i];
+    }
+    return acc;
+#endif
+}
+
+/* =================================================================
+ * Polyphase resampler
+ * ================================================================= */
+
+static unsigned int gcd_u(unsigned int a, unsigned int b) {
+    while (b != 0) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Zeroth-order modified Bessel function (Kaiser window) */
+static double bessel_i0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+audio_resampler_t* audio_resampler_create(unsigned int in_rate, unsigned int out_rate, size_t max_input) {
+    if (in_rate == 0 || out_rate == 0 || max_input == 0) {
+        return NULL;
+    }
+
+    audio_resampler_t *r = calloc(1, sizeof(audio_resampler_t));
+    if (!r) return NULL;
+
+    unsigned int g = gcd_u(in_rate, out_rate);
+    r->up = out_rate / g;
+    r->down = in_rate / g;
+    r->max_input = max_input;
+
+    /* Prototype runs at in_rate * up; cut off at the lower of the two Nyquist rates */
+    const unsigned int factor = r->up > r->down ? r->up : r->down;
+    size_t taps = (2 * RESAMPLER_ZERO_CROSSINGS * (size_t)factor + r->up - 1) / r->up;
+    taps = (taps + RESAMPLER_TAP_ALIGN - 1) / RESAMPLER_TAP_ALIGN * RESAMPLER_TAP_ALIGN;
+    r->taps = taps;
+
+    const size_t proto_len = (size_t)r->up * taps;
+    r->coefs = malloc(proto_len * sizeof(float));
+    r->history = calloc(taps - 1 + max_input, sizeof(float));
+    double *proto = malloc(proto_len * sizeof(double));
+    if (!r->coefs || !r->history || !proto) {
+        free(proto);
+        audio_resampler_destroy(r);
+        return NULL;
+    }
+
+    /* Kaiser-windowed sinc low-pass */
+    const double fc = RESAMPLER_ROLLOFF * 0.5 / factor;
+    const double center = (double)(proto_len - 1) / 2.0;
+    const double i0_beta = bessel_i0(RESAMPLER_KAISER_BETA);
+    double sum = 0.0;
+    for (size_t n = 0; n < proto_len; n++) {
+        double t = (double)n - center;
+        double x = 2.0 * fc * t;
+        double sinc = (fabs(x) < 1e-12) ? 1.0 : sin(DSP_PI * x) / (DSP_PI * x);
+        double w = (double)n / (double)(proto_len - 1) * 2.0 - 1.0;
+        double window = bessel_i0(RESAMPLER_KAISER_BETA * sqrt(1.0 - w * w)) / i0_beta;
+        proto[n] = 2.0 * fc * sinc * window;
+        sum += proto[n];
+    }
+
+    /* Unity DC gain per output sample, then split into time-reversed phases so
+     * each output is one contiguous dot product over the history buffer */
+    const double gain = (double)r->up / sum;
+    for (unsigned int p = 0; p < r->up; p++) {
+        for (size_t i = 0; i < taps; i++) {
+            r->coefs[p * taps + i] = (float)(proto[p + (taps - 1 - i) * r->up] * gain);
+        }
+    }
+    free(proto);
+
+    audio_resampler_reset(r);
+    return r;
+}
+
+size_t audio_resampler_max_output(const audio_resampler_t *r, size_t num_input) {
+    if (!r) return 0;
+    return (num_input * r->up) / r->down + 2;
+}
+
+size_t audio_resampler_process(audio_resampler_t *r, const float *in, size_t num_input, float *out) {
+    if (!r || !in || !out || num_input == 0) return 0;
+    if (num_input > r->max_input) num_input = r->max_input;
+
+    const size_t keep = r->taps - 1;
+    memcpy(r->history + keep, in, num_input * sizeof(float));
+
+    const size_t end = keep + num_input;
+    size_t pos = r->pos;
+    unsigned int phase = r->phase;
+    size_t n_out = 0;
+
+    while (pos < end) {
+        out[n_out++] = dot_f32(r->coefs + (size_t)phase * r->taps, r->history + pos - keep, r->taps);
+        phase += r->down;
+        pos += phase / r->up;
+        phase %= r->up;
+    }
+
+    /* Slide the filter history for the next block */
+    memmove(r->history, r->history + num_input, keep * sizeof(float));
+    r->pos = pos - num_input;
+    r->phase = phase;
+
+    return n_out;
+}
+
+void audio_resampler_reset(audio_resampler_t *r) {
+    if (!r) return;
+    memset(r->history, 0, (r->taps - 1 + r->max_input) * sizeof(float));
+    r->pos = r->taps - 1;
+    r->phase = 0;
+}
+
+void audio_resampler_destroy(audio_resampler_t *r) {
+    if (!r) return;
+    free(r->coefs);
+    free(r->history);
+    free(r);
+}
+
+/* =================================================================
+ * Capture front-end
+ * ================================================================= */
+
+audio_dsp_t* audio_dsp_create(unsigned int in_rate, size_t max_frames) {
+    if (in_rate == 0 || max_frames == 0) {
+        return NULL;
+    }
+
+    audio_dsp_t *dsp = calloc(1, sizeof(audio_dsp_t));
+    if (!dsp) return NULL;
+
+    dsp->in_rate = in_rate;
+    dsp->max_frames = max_frames;
+    dsp->converted = malloc(max_frames * sizeof(float));
+    if (!dsp->converted) {
+        audio_dsp_destroy(dsp);
+        return NULL;
+    }
+
+    if (in_rate != AUDIO_SAMPLE_RATE) {
+        dsp->resampler = audio_resampler_create(in_rate, AUDIO_SAMPLE_RATE, max_frames);
+        if (!dsp->resampler) {
+            audio_dsp_destroy(dsp);
+            return NULL;
+        }
+        dsp->resampled = malloc(audio_resampler_max_output(dsp->resampler, max_frames) * sizeof(float));
+        if (!dsp->resampled) {
+            audio_dsp_destroy(dsp);
+            return NULL;
+        }
+    }
+
+    return dsp;
+}
+
+void audio_dsp_push_s16(audio_dsp_t *dsp, const int16_t *samples, size_t num_samples, uint64_t capture_ns,
+                        audio_callback_t callback, void *user_data) {
+    if (!dsp || !samples || !callback) return;
+
+    while (num_samples > 0) {
+        size_t n = num_samples < dsp->max_frames ? num_samples : dsp->max_frames;
+
+        /* Blocks split off the front were captured before the last sample */
+        const uint64_t block_ns = capture_ns - (uint64_t)(num_samples - n) * 1000000000ull / dsp->in_rate;
+
+        audio_dsp_s16_to_f32(samples, dsp->converted, n);
+
+        if (dsp->resampler) {
+            size_t n_out = audio_resampler_process(dsp->resampler, dsp->converted, n, dsp->resampled);
+            if (n_out > 0) {
+                callback(dsp->resampled, n_out, block_ns, user_data);
+            }
+        } else {
+            callback(dsp->converted, n, block_ns, user_data);
+        }
+
+        samples += n;
+        num_samples -= n;
+    }
+}
+
+unsigned int audio_dsp_get_input_rate(const audio_dsp_t *dsp) {
+    return dsp ? dsp->in_rate : 0;
+}
+
+void audio_dsp_destroy(audio_dsp_t *dsp) {
+    if (!dsp) return;
+    audio_resampler_destroy(dsp->resampler);
+    free(dsp->converted);
+    free(dsp->resampled);
+    free(dsp);
+}
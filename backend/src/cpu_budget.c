@@ -0,0 +1,296 @@
+#ifdef PLATFORM_LINUX
+    #define _GNU_SOURCE  /* sched_getaffinity, CPU_SET */
+#endif
+
+#include "cpu_budget.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#ifdef PLATFORM_LINUX
+    #include <sched.h>
+#endif
+
+#ifdef PLATFORM_MACOS
+    #include <sys/sysctl.h>
+#endif
+
+static pthread_mutex_t budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool initialized = false;
+static int total_threads = 0;
+static double asr_share = 0.75;
+static int wanted_total[CPU_BUDGET_CLIENTS];  /* Threads asked for by calls in flight */
+static int busy[CPU_BUDGET_CLIENTS];          /* Calls in flight */
+
+static char last_error[256] = {0};
+
+cpu_budget_params_t cpu_budget_default_params(void) {
+    cpu_budget_params_t params;
+    params.threads = 0;
+    params.affinity = NULL;
+    params.asr_share = 0.75;
+    return params;
+}
+
+static int logical_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 4;
+#endif
+}
+
+#ifdef PLATFORM_LINUX
+/* Parse a CPU list ("0-3,8") into a set */
+static bool parse_cpu_list(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) return false;
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) return false;
+            p = end;
+        }
+        if (last >= CPU_SETSIZE) return false;
+        for (long cpu = first; cpu <= last; cpu++) {
+            CPU_SET((int)cpu, set);
+        }
+        if (*p == ',') p++;
+        else if (*p != '\0') return false;
+    }
+    return CPU_COUNT(set) > 0;
+}
+
+static int read_topology(int cpu, const char *field) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, field);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    int value = -1;
+    if (fscanf(f, "%d", &value) != 1) value = -1;
+    fclose(f);
+    return value;
+}
+
+/* Physical cores among the CPUs this process may run on; SMT siblings
+ * share a core's execution units, so ggml gains little from them */
+static int physical_cores(void) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return logical_cpus();
+    }
+
+    int cores[CPU_SETSIZE];
+    int n_cores = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) continue;
+
+        int core = read_topology(cpu, "core_id");
+        int package = read_topology(cpu, "physical_package_id");
+        if (core < 0) return CPU_COUNT(&set);  /* No topology (containers, some VMs) */
+        int id = (package > 0 ? package : 0) * 4096 + core;
+
+        bool seen = false;
+        for (int i = 0; i < n_cores && !seen; i++) {
+            seen = cores[i] == id;
+        }
+        if (!seen) cores[n_cores++] = id;
+    }
+    return n_cores > 0 ? n_cores : CPU_COUNT(&set);
+}
+#elif defined(PLATFORM_MACOS)
+static int physical_cores(void) {
+    int cores = 0;
+    size_t size = sizeof(cores);
+    if (sysctlbyname("hw.physicalcpu", &cores, &size, NULL, 0) != 0 || cores <= 0) {
+        return logical_cpus();
+    }
+    return cores;
+}
+#elif defined(_WIN32)
+static int physical_cores(void) {
+    DWORD size = 0;
+    GetLogicalProcessorInformation(NULL, &size);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = malloc(size);
+    if (!info || !GetLogicalProcessorInformation(info, &size)) {
+        free(info);
+        return logical_cpus();
+    }
+
+    int cores = 0;
+    for (DWORD i = 0; i < size / sizeof(*info); i++) {
+        if (info[i].Relationship == RelationProcessorCore) cores++;
+    }
+    free(info);
+    return cores > 0 ? cores : logical_cpus();
+}
+#else
+static int physical_cores(void) {
+    return logical_cpus();
+}
+#endif
+
+/* Pin the process, or only the calling thread */
+static bool apply_affinity(const char *list, bool thread) {
+#ifdef PLATFORM_LINUX
+    cpu_set_t set;
+    if (!parse_cpu_list(list, &set)) {
+        snprintf(last_error, sizeof(last_error), "Invalid CPU list: %s", list);
+        return false;
+    }
+    /* Linux affinity is per thread; threads created later inherit it */
+    (void)thread;
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        snprintf(last_error, sizeof(last_error), "sched_setaffinity failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0) break;
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        for (long cpu = first; cpu <= last && cpu < (long)(8 * sizeof(mask)); cpu++) {
+            mask |= (DWORD_PTR)1 << cpu;
+        }
+        if (*p == ',') p++;
+        else if (*p != '\0') break;
+    }
+    if (mask == 0 || *p != '\0') {
+        snprintf(last_error, sizeof(last_error), "Invalid CPU list: %s", list);
+        return false;
+    }
+    if (thread ? SetThreadAffinityMask(GetCurrentThread(), mask) == 0
+               : !SetProcessAffinityMask(GetCurrentProcess(), mask)) {
+        snprintf(last_error, sizeof(last_error), "Setting the CPU affinity failed");
+        return false;
+    }
+    return true;
+#else
+    (void)list;
+    (void)thread;
+    snprintf(last_error, sizeof(last_error), "CPU affinity is not supported on this platform");
+    return false;
+#endif
+}
+
+bool cpu_budget_init(const cpu_budget_params_t *params) {
+    cpu_budget_params_t defaults = cpu_budget_default_params();
+    if (!params) params = &defaults;
+
+    bool ok = true;
+    if (params->affinity && params->affinity[0] != '\0') {
+        ok = apply_affinity(params->affinity, false);
+        if (ok) {
+            LOG_INFO("[CPU] Pinned to CPUs %s\n", params->affinity);
+        }
+    }
+
+    /* Cores are counted after pinning, so the budget fits the CPU set */
+    const int cores = physical_cores();
+
+    pthread_mutex_lock(&budget_lock);
+    total_threads = params->threads > 0 ? params->threads : cores;
+    asr_share = params->asr_share;
+    if (asr_share <= 0.0 || asr_share >= 1.0) asr_share = defaults.asr_share;
+    memset(wanted_total, 0, sizeof(wanted_total));
+    memset(busy, 0, sizeof(busy));
+    initialized = true;
+    pthread_mutex_unlock(&budget_lock);
+
+    LOG_INFO("[CPU] Thread budget: %d (%d physical cores, %d logical CPUs), ASR share %.0f%% when shared\n",
+            total_threads, cores, logical_cpus(), asr_share * 100.0);
+    return ok;
+}
+
+int cpu_budget_total(void) {
+    pthread_mutex_lock(&budget_lock);
+    int total = initialized ? total_threads : 0;
+    pthread_mutex_unlock(&budget_lock);
+    return total > 0 ? total : physical_cores();
+}
+
+int cpu_budget_acquire(cpu_budget_client_t client, int wanted) {
+    if (wanted < 1) wanted = 1;
+    if ((int)client < 0 || client >= CPU_BUDGET_CLIENTS) return wanted;
+
+    pthread_mutex_lock(&budget_lock);
+    if (!initialized) {
+        pthread_mutex_unlock(&budget_lock);
+        return wanted;
+    }
+
+    wanted_total[client] += wanted;
+    busy[client]++;
+
+    /* The whole budget while the other engine is idle, its share otherwise */
+    bool shared = false;
+    for (int i = 0; i < CPU_BUDGET_CLIENTS; i++) {
+        if (i != (int)client && busy[i] > 0) shared = true;
+    }
+    int share = total_threads;
+    if (shared) {
+        const int asr = (int)(total_threads * asr_share + 0.5);
+        share = client == CPU_BUDGET_ASR ? asr : total_threads - asr;
+    }
+    if (share < 1) share = 1;
+
+    /* Concurrent calls of one engine split its share in proportion to what they asked for */
+    int granted = wanted;
+    if (wanted_total[client] > share) {
+        granted = wanted * share / wanted_total[client];
+        if (granted < 1) granted = 1;
+    }
+    pthread_mutex_unlock(&budget_lock);
+
+    return granted;
+}
+
+void cpu_budget_release(cpu_budget_client_t client, int wanted) {
+    if (wanted < 1) wanted = 1;
+    if ((int)client < 0 || client >= CPU_BUDGET_CLIENTS) return;
+
+    pthread_mutex_lock(&budget_lock);
+    if (initialized && busy[client] > 0) {
+        wanted_total[client] -= wanted;
+        busy[client]--;
+    }
+    pthread_mutex_unlock(&budget_lock);
+}
+
+bool cpu_budget_pin_thread(const char *cpus) {
+    if (!cpus || cpus[0] == '\0') {
+        snprintf(last_error, sizeof(last_error), "Invalid CPU list");
+        return false;
+    }
+    return apply_affinity(cpus, true);
+}
+
+const char* cpu_budget_get_error(void) {
+    return last_error;
+}
@@ -105,13 +105,32 @@
 // }
 
 #include "ipc.h"
+#include "logger.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <poll.h>
+    #include <unistd.h>
+#endif
+
 /* Simple JSON-RPC implementation using stdio */
 
+/* Longest command line accepted from the frontend; longer ones are skipped */
+#define IPC_MAX_COMMAND 1024
+
+static ipc_command_callback_t command_callback = NULL;
+static void *command_user_data = NULL;
+static char command_line[IPC_MAX_COMMAND];
+static size_t command_len = 0;
+static bool command_overflow = false;  /* Discarding the rest of an overlong line */
+static bool stdin_closed = false;
+
 bool ipc_init(void) {
     /* Set stdout to line buffering for immediate output */
     #ifdef _WIN32
@@ -124,7 +143,7 @@ bool ipc_init(void) {
         setvbuf(stderr, NULL, _IOLBF, 0);
     #endif
 
-    fprintf(stderr, "[IPC] Initialized (stdio mode)\n");
+    LOG_INFO("[IPC] Initialized (stdio mode)\n");
     return true;
 }
 
@@ -133,24 +152,80 @@ static void escape_json_string(const char *src, char *dest, size_t dest_size) {
     for (size_t i = 0; src[i] != '\0' && j < dest_size - 2; i++) {
         if (src[i] == '"' || src[i] == '\\') {
             dest[j++] = '\\';
+        } else if (src[i] == '\n' || src[i] == '\r' || src[i] == '\t') {
+            dest[j++] = '\\';
+            dest[j++] = src[i] == '\n' ? 'n' : src[i] == '\r' ? 'r' : 't';
+            continue;
         }
         dest[j++] = src[i];
     }
     dest[j] = '\0';
 }
 
-bool ipc_send_transcription(const char *text, long timestamp) {
+/* Build the optional ,"source":"..." member (empty when source is NULL) */
+static void format_source_field(const char *source, char *dest, size_t dest_size) {
+    if (!source) {
+        dest[0] = '\0';
+        return;
+    }
+
+    char escaped[64];
+    escape_json_string(source, escaped, sizeof(escaped));
+    snprintf(dest, dest_size, ",\"source\":\"%s\"", escaped);
+}
+
+/* Build the optional ,"audio":{...},"latency_ms":{...} members (empty when
+ * latency is NULL); total runs from the last sample's capture to now */
+static void format_latency_fields(const ipc_latency_t *latency, bool translation, char *dest, size_t dest_size) {
+    if (!latency) {
+        dest[0] = '\0';
+        return;
+    }
+
+    const uint64_t emit_ns = trace_now_ns();
+    const double total_ms = latency->audio_end_ns && emit_ns > latency->audio_end_ns ?
+                            (double)(emit_ns - latency->audio_end_ns) / 1e6 : 0.0;
+
+    char translation_fields[96] = "";
+    if (translation) {
+        snprintf(translation_fields, sizeof(translation_fields), ",\"translation_queue\":%.2f,\"translation\":%.2f",
+                 latency->translation_queue_ms, latency->translation_ms);
+    }
+
+    snprintf(dest, dest_size,
+             ",\"audio\":{\"start_ns\":%llu,\"end_ns\":%llu,\"emit_ns\":%llu},"
+             "\"latency_ms\":{\"capture\":%.2f,\"queue\":%.2f,\"asr\":%.2f,\"reorder\":%.2f%s,\"total\":%.2f}",
+             (unsigned long long)latency->audio_start_ns, (unsigned long long)latency->audio_end_ns,
+             (unsigned long long)emit_ns, latency->capture_ms, latency->queue_ms, latency->asr_ms,
+             latency->reorder_ms, translation_fields, total_ms);
+}
+
+bool ipc_send_transcription(const char *text, const char *source, uint64_t id, long timestamp,
+                            const ipc_latency_t *latency) {
     if (!text) return false;
+    const uint64_t span = trace_begin();
 
     /* Escape special characters in JSON */
     char escaped[4096];
     escape_json_string(text, escaped, sizeof(escaped));
 
+    char source_field[96];
+    format_source_field(source, source_field, sizeof(source_field));
+
+    char id_field[32] = "";
+    if (id) {
+        snprintf(id_field, sizeof(id_field), ",\"id\":%llu", (unsigned long long)id);
+    }
+
+    char latency_fields[320];
+    format_latency_fields(latency, false, latency_fields, sizeof(latency_fields));
+
     /* Send JSON message */
-    printf("{\"type\":\"transcription\",\"data\":{\"text\":\"%s\",\"timestamp\":%ld}}\n",
-           escaped, timestamp);
+    printf("{\"type\":\"transcription\",\"data\":{\"text\":\"%s\"%s%s,\"timestamp\":%ld%s}}\n",
+           escaped, source_field, id_field, timestamp, latency_fields);
     fflush(stdout);
 
+    trace_end("ipc_transcription", "ipc", span, trace_context());
     return true;
 }
 
@@ -178,18 +253,61 @@ bool ipc_send_status(const char *status) {
     return true;
 }
 
-bool ipc_send_translation(const char *translated_text, const char *original_text, long timestamp) {
-    if (!translated_text || !original_text) return false;
+bool ipc_send_translation(const ipc_translation_t *translations, size_t num_translations, const char *original_text,
+                          const char *source, const ipc_fragments_t *fragments, long timestamp,
+                          const ipc_latency_t *latency) {
+    if (!translations || num_translations == 0 || !original_text) return false;
+    const uint64_t span = trace_begin();
+
+    /* "translations":{"fr":"...","de":"..."}, first target also as "text" */
+    char escaped_first[4096];
+    char targets[4 * 4096 + 256];  /* Room for four long translations */
+    size_t len = 0;
+    targets[0] = '\0';
+    for (size_t i = 0; i < num_translations; i++) {
+        if (!translations[i].lang || !translations[i].text) return false;
+
+        char escaped_lang[32];
+        char escaped_text[4096];
+        escape_json_string(translations[i].lang, escaped_lang, sizeof(escaped_lang));
+        escape_json_string(translations[i].text, escaped_text, sizeof(escaped_text));
+        if (i == 0) memcpy(escaped_first, escaped_text, sizeof(escaped_first));
+
+        int n = snprintf(targets + len, sizeof(targets) - len, "%s\"%s\":\"%s\"",
+                         i > 0 ? "," : "", escaped_lang, escaped_text);
+        if (n < 0 || (size_t)n >= sizeof(targets) - len) {
+            targets[len] = '\0';  /* Drop targets that don't fit */
+            break;
+        }
+        len += (size_t)n;
+    }
+
+    char escaped_first_lang[32];
+    escape_json_string(translations[0].lang, escaped_first_lang, sizeof(escaped_first_lang));
 
-    char escaped_translation[4096];
     char escaped_original[4096];
-    escape_json_string(translated_text, escaped_translation, sizeof(escaped_translation));
     escape_json_string(original_text, escaped_original, sizeof(escaped_original));
 
-    printf("{\"type\":\"translation\",\"data\":{\"text\":\"%s\",\"original\":\"%s\",\"timestamp\":%ld}}\n",
-           escaped_translation, escaped_original, timestamp);
+    char source_field[96];
+    format_source_field(source, source_field, sizeof(source_field));
+
+    /* ,"fragments":[first,last]: the transcription ids the original spans */
+    char fragments_field[64] = "";
+    if (fragments && fragments->first) {
+        snprintf(fragments_field, sizeof(fragments_field), ",\"fragments\":[%llu,%llu]",
+                 (unsigned long long)fragments->first, (unsigned long long)fragments->last);
+    }
+
+    char latency_fields[320];
+    format_latency_fields(latency, true, latency_fields, sizeof(latency_fields));
+
+    printf("{\"type\":\"translation\",\"data\":{\"text\":\"%s\",\"target\":\"%s\",\"translations\":{%s},"
+           "\"original\":\"%s\"%s%s,\"timestamp\":%ld%s}}\n",
+           escaped_first, escaped_first_lang, targets, escaped_original, source_field, fragments_field, timestamp,
+           latency_fields);
     fflush(stdout);
 
+    trace_end("ipc_translation", "ipc", span, trace_context());
     return true;
 }
 
@@ -205,14 +323,140 @@ bool ipc_send_language_detected(const char *language) {
     return true;
 }
 
+bool ipc_send_governor(const char *action, const char *knob, const char *model, int beam_size,
+                       bool temperature_fallback, int chunk_ms, double rtf, double load, long timestamp) {
+    if (!action || !knob || !model) return false;
+
+    char escaped_model[1024];
+    escape_json_string(model, escaped_model, sizeof(escaped_model));
+
+    printf("{\"type\":\"governor\",\"data\":{\"action\":\"%s\",\"knob\":\"%s\",\"model\":\"%s\","
+           "\"beam_size\":%d,\"temperature_fallback\":%s,\"chunk_ms\":%d,\"rtf\":%.3f,\"load\":%.3f,"
+           "\"timestamp\":%ld}}\n",
+           action, knob, escaped_model, beam_size, temperature_fallback ? "true" : "false",
+           chunk_ms, rtf, load, timestamp);
+    fflush(stdout);
+
+    return true;
+}
+
+bool ipc_send_startup(const char *phase, double ms, long timestamp) {
+    if (!phase) return false;
+
+    printf("{\"type\":\"startup\",\"data\":{\"phase\":\"%s\",\"ms\":%.1f,\"timestamp\":%ld}}\n",
+           phase, ms, timestamp);
+    fflush(stdout);
+
+    return true;
+}
+
+bool ipc_send_memory(const char *phase, double rss_mb, double huge_mb,
+                     unsigned long minor_faults, unsigned long major_faults, long timestamp) {
+    if (!phase) return false;
+
+    printf("{\"type\":\"memory\",\"data\":{\"phase\":\"%s\",\"rss_mb\":%.1f,\"huge_mb\":%.1f,"
+           "\"minor_faults\":%lu,\"major_faults\":%lu,\"timestamp\":%ld}}\n",
+           phase, rss_mb, huge_mb, minor_faults, major_faults, timestamp);
+    fflush(stdout);
+
+    return true;
+}
+
+bool ipc_send_stats(const char *metrics_json, long timestamp) {
+    if (!metrics_json) return false;
+
+    printf("{\"type\":\"stats\",\"data\":{\"metrics\":%s,\"timestamp\":%ld}}\n", metrics_json, timestamp);
+    fflush(stdout);
+
+    return true;
+}
+
+bool ipc_send_metrics(const char *text) {
+    if (!text) return false;
+
+    /* Exposition text is mostly newlines and names; escaping adds little */
+    static char escaped[40960];
+    escape_json_string(text, escaped, sizeof(escaped));
+
+    printf("{\"type\":\"metrics\",\"data\":{\"format\":\"prometheus\",\"text\":\"%s\"}}\n", escaped);
+    fflush(stdout);
+
+    return true;
+}
+
+void ipc_set_command_callback(ipc_command_callback_t callback, void *user_data) {
+    command_callback = callback;
+    command_user_data = user_data;
+}
+
+/* Read whatever the frontend has written so far without blocking */
+static long read_stdin(char *buf, size_t size) {
+#ifdef _WIN32
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    DWORD available = 0;
+    if (!PeekNamedPipe(input, NULL, 0, NULL, &available, NULL)) return -1;  /* Closed, or not a pipe */
+    if (available == 0) return 0;
+
+    DWORD n = 0;
+    if (!ReadFile(input, buf, available < size ? available : (DWORD)size, &n, NULL)) return -1;
+    return (long)n;
+#else
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, 0) <= 0) return 0;
+
+    ssize_t n = read(STDIN_FILENO, buf, size);
+    return n > 0 ? (long)n : -1;  /* Ready but empty: the frontend closed our stdin */
+#endif
+}
+
+/* Hand the "type" of one JSON command line to the callback */
+static bool handle_command(const char *line) {
+    const char *key = strstr(line, "\"type\"");
+    if (!key) return false;
+    const char *value = strchr(key + 6, '"');
+    if (!value) return false;
+    value++;
+    const char *end = strchr(value, '"');
+    if (!end || end - value >= 64) return false;
+
+    char type[64];
+    memcpy(type, value, (size_t)(end - value));
+    type[end - value] = '\0';
+
+    LOG_DEBUG("[IPC] Command: %s\n", type);
+    if (command_callback) command_callback(type, command_user_data);
+    return true;
+}
+
 bool ipc_poll(void) {
-    /* For now, we don't expect messages from frontend */
-    /* This can be extended to handle control commands */
-    return false;
+    if (stdin_closed) return false;
+
+    char buf[512];
+    bool handled = false;
+    long n;
+    while ((n = read_stdin(buf, sizeof(buf))) > 0) {
+        for (long i = 0; i < n; i++) {
+            if (buf[i] == '\n') {
+                command_line[command_len] = '\0';
+                if (!command_overflow && command_len > 0 && handle_command(command_line)) handled = true;
+                command_len = 0;
+                command_overflow = false;
+            } else if (command_len + 1 < sizeof(command_line)) {
+                command_line[command_len++] = buf[i];
+            } else {
+                command_overflow = true;
+            }
+        }
+    }
+    if (n < 0) {
+        stdin_closed = true;
+        LOG_DEBUG("[IPC] Frontend closed stdin; no more commands\n");
+    }
+    return handled;
 }
 
 void ipc_cleanup(void) {
     fflush(stdout);
     fflush(stderr);
-    fprintf(stderr, "[IPC] Cleanup complete\n");
+    LOG_INFO("[IPC] Cleanup complete\n");
 }
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "logger.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Ring size and longest message (longer ones are cut, newline kept) */
+#define LOGGER_SLOTS 1024
+#define LOGGER_MESSAGE_MAX 512
+
+/* Writer poll interval while the ring is empty */
+#define LOGGER_IDLE_US 5000
+
+/* Bytes per write to stderr */
+#define LOGGER_BATCH_BYTES 16384
+
+/* Bounded multi-producer ring: a slot whose sequence equals the enqueue
+ * position is free, one past it holds a message for the writer */
+typedef struct {
+    size_t seq;
+    char text[LOGGER_MESSAGE_MAX];
+} log_slot_t;
+
+static log_slot_t ring[LOGGER_SLOTS];
+static size_t enqueue_pos = 0;
+static size_t dequeue_pos = 0;          /* Writer thread only */
+static unsigned long dropped = 0;
+static int min_level = LOG_LEVEL_INFO;
+static bool running = false;            /* Writer thread owns the ring */
+static bool stopping = false;
+static pthread_t writer;
+
+static void write_all(const char *buf, size_t len) {
+    if (len > 0) {
+        fwrite(buf, 1, len, stderr);
+        fflush(stderr);
+    }
+}
+
+/* Write out everything queued; returns the number of messages */
+static size_t drain(void) {
+    static char batch[LOGGER_BATCH_BYTES];
+    size_t len = 0;
+    size_t count = 0;
+
+    while (true) {
+        log_slot_t *slot = &ring[dequeue_pos % LOGGER_SLOTS];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != dequeue_pos + 1) break;
+
+        const size_t n = strlen(slot->text);
+        if (len + n > sizeof(batch)) {
+            write_all(batch, len);
+            len = 0;
+        }
+        memcpy(batch + len, slot->text, n);
+        len += n;
+        count++;
+
+        __atomic_store_n(&slot->seq, dequeue_pos + LOGGER_SLOTS, __ATOMIC_RELEASE);
+        dequeue_pos++;
+    }
+    write_all(batch, len);
+    return count;
+}
+
+/* Say how many messages were lost since the last report */
+static void report_dropped(unsigned long *reported) {
+    const unsigned long lost = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+    if (lost != *reported) {
+        fprintf(stderr, "[Log] %lu messages dropped (ring full)\n", lost - *reported);
+        *reported = lost;
+    }
+}
+
+static void* writer_thread(void *arg) {
+    (void)arg;
+    unsigned long reported = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        const size_t n = drain();
+        report_dropped(&reported);
+        if (n == 0) usleep(LOGGER_IDLE_US);
+    }
+    drain();
+    report_dropped(&reported);
+    return NULL;
+}
+
+bool logger_start(void) {
+    if (running) return true;
+
+    for (size_t i = 0; i < LOGGER_SLOTS; i++) {
+        ring[i].seq = i;
+    }
+    enqueue_pos = 0;
+    dequeue_pos = 0;
+    stopping = false;
+
+    if (pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+        return false;
+    }
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void logger_shutdown(void) {
+    if (!running) return;
+
+    __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+
+    /* Messages that raced with the last drain */
+    drain();
+}
+
+void logger_set_level(log_level_t level) {
+    __atomic_store_n(&min_level, (int)level, __ATOMIC_RELAXED);
+}
+
+bool logger_parse_level(const char *name, log_level_t *level) {
+    static const char *names[] = { "debug", "info", "warn", "error", "off" };
+    for (int i = 0; i <= LOG_LEVEL_OFF; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *level = (log_level_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool logger_enabled(log_level_t level) {
+    return (int)level >= VISUALIA_LOG_MIN_LEVEL && level != LOG_LEVEL_OFF &&
+           (int)level >= __atomic_load_n(&min_level, __ATOMIC_RELAXED);
+}
+
+void logger_write(log_level_t level, const char *fmt, ...) {
+    if (!logger_enabled(level)) return;
+
+    va_list args;
+    va_start(args, fmt);
+
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        vfprintf(stderr, fmt, args);
+        va_end(args);
+        return;
+    }
+
+    /* Claim a slot */
+    log_slot_t *slot;
+    size_t pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+    while (true) {
+        slot = &ring[pos % LOGGER_SLOTS];
+        const size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            va_end(args);
+            return;
+        } else {
+            pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    const int n = vsnprintf(slot->text, sizeof(slot->text), fmt, args);
+    va_end(args);
+    if (n < 0) {
+        slot->text[0] = '\0';
+    } else if ((size_t)n >= sizeof(slot->text) && fmt[0] != '\0' && fmt[strlen(fmt) - 1] == '\n') {
+        slot->text[sizeof(slot->text) - 2] = '\n';
+    }
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+unsigned long logger_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
@@ -1,37 +1,159 @@
 #include "audio.h"
 #include "whisper_engine.h"
+#include "asr_governor.h"
+#include "asr_router.h"
 #include "translation_engine.h"
+#include "sentence_buffer.h"
+#include "cpu_budget.h"
+#include "alloc_counter.h"
 #include "ipc.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
 #include <time.h>
+#include <pthread.h>
 
 /* Global state */
 static audio_context_t *g_audio = NULL;
 static whisper_engine_t *g_whisper = NULL;
-static translation_engine_t *g_translator = NULL;
+static asr_governor_t *g_governor = NULL;
+static asr_router_t *g_router = NULL;
+static translation_engine_t *g_translator = NULL;  /* Set once loaded; guarded by g_translator_lock */
+static pthread_mutex_t g_translator_lock = PTHREAD_MUTEX_INITIALIZER;
 static volatile sig_atomic_t g_running = 1;
 
-/* Translation settings */
-static const char *g_target_lang = NULL;
+/* Translation settings: every transcript is translated into all targets at once */
+static const char *g_target_langs[TRANSLATION_MAX_TARGETS];
+static size_t g_num_targets = 0;
 static const char *g_source_lang = NULL;
 
 /* Language detection state */
 static char g_last_detected_lang[8] = {0};
 static time_t g_last_lang_check = 0;
 
+/* Capture health reporting */
+#define AUDIO_HEALTH_INTERVAL_S 5
+static time_t g_last_audio_check = 0;
+
+/* Heap allocations made inside the audio, transcription and translation
+ * callbacks once every model is up (counted with VISUALIA_ALLOC_COUNTER) */
+static volatile int g_steady = 0;
+static unsigned long long g_hot_path_allocs = 0;
+static unsigned long long g_hot_path_reported = 0;
+static unsigned long long g_steady_total = 0;  /* Process-wide count when steady state began */
+
+/* Runtime metrics (see metrics.h): the figures other modules keep as
+ * totals are copied into the registry before each report */
+#define STATS_INTERVAL_S 5
+static time_t g_last_stats = 0;
+static struct {
+    metrics_counter_t *audio_gaps;
+    metrics_counter_t *audio_lost_ms;
+    metrics_counter_t *audio_late_reads;
+    metrics_counter_t *whisper_dropped;
+    metrics_gauge_t *whisper_rtf;
+    metrics_gauge_t *whisper_load;
+    metrics_gauge_t *whisper_queue_depth;
+    metrics_gauge_t *rss_mb;
+} g_metrics;
+static char g_metrics_text[16384];
+
 /* Configuration */
 #define DEFAULT_MODEL_PATH "models/whisper-base.gguf"
 #define DEFAULT_TRANSLATION_MODEL "models/mt5-small.gguf"
 #define DEFAULT_LANGUAGE NULL  /* Auto-detect language */
-#define AUDIO_CHUNK_SIZE (AUDIO_SAMPLE_RATE * 3)  /* 3 seconds */
 
-/* Audio buffer for accumulation */
-static float audio_buffer[AUDIO_CHUNK_SIZE];
-static size_t audio_buffer_pos = 0;
+/* Audio kept per source while Whisper loads; the engine only queues a few
+ * chunks per stream, so older audio would be dropped anyway */
+#define STARTUP_BUFFER_MS 10000
+#define STARTUP_BUFFER_SAMPLES ((size_t)AUDIO_SAMPLE_RATE * STARTUP_BUFFER_MS / 1000)
+
+/* Per-source capture stream and its Whisper stream (which does the chunking).
+ * Capture starts before Whisper is loaded; until then audio goes to backlog. */
+typedef struct {
+    const char *label;
+    const char *device;
+    whisper_stream_t *asr;        /* NULL until Whisper is ready; guarded by lock */
+    sentence_buffer_t *sentences; /* Joins transcripts into sentences to translate, NULL = translate each */
+    uint64_t transcripts;         /* Transcripts sent so far, which numbers them; Whisper delivery only */
+    pthread_mutex_t lock;
+    float *backlog;               /* Ring of the latest STARTUP_BUFFER_SAMPLES */
+    size_t backlog_start;
+    size_t backlog_len;
+    uint64_t backlog_end_ns;      /* Capture time of the newest sample in backlog */
+    audio_stats_t reported;       /* Capture counters at the last health report */
+} capture_stream_t;
+
+/* A model loading (and warming up) on a background thread */
+typedef struct {
+    pthread_t thread;
+    bool started;
+    bool done;                    /* Guarded by g_startup_lock */
+    void *engine;                 /* whisper_engine_t or translation_engine_t, NULL on failure */
+    double load_ms;
+    double warmup_ms;
+    model_memory_usage_t before;  /* Loader thread's faults around the load */
+    model_memory_usage_t after;
+} model_loader_t;
+
+static pthread_mutex_t g_startup_lock = PTHREAD_MUTEX_INITIALIZER;
+static model_loader_t g_whisper_loader;
+static model_loader_t g_translation_loader;
+
+/* Loader arguments, fixed after argument parsing */
+static const char *g_model_path = DEFAULT_MODEL_PATH;
+static const char *g_translation_model_path = DEFAULT_TRANSLATION_MODEL;
+static whisper_engine_params_t g_whisper_params;
+static translation_params_t g_translation_params;
+
+static capture_stream_t g_streams[AUDIO_MAX_SOURCES];
+static size_t g_num_streams = 0;
+
+/* Translation request context, owned until on_translation(). Jobs come
+ * from a fixed pool: one per queued request plus the one being translated. */
+#define TRANSLATION_TEXT_MAX 4096
+typedef struct {
+    bool in_use;                      /* Guarded by g_translation_jobs_lock */
+    char text[TRANSLATION_TEXT_MAX];  /* Copy of the original text */
+    const char *source;               /* Label of the stream it came from */
+    whisper_timing_t asr;             /* Timeline of the transcription */
+    ipc_fragments_t fragments;        /* Transcripts the text spans */
+} translation_job_t;
+
+static translation_job_t g_translation_jobs[TRANSLATION_MAX_PENDING + 1];
+static pthread_mutex_t g_translation_jobs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static translation_job_t* acquire_translation_job(void) {
+    translation_job_t *job = NULL;
+    pthread_mutex_lock(&g_translation_jobs_lock);
+    for (size_t i = 0; i < TRANSLATION_MAX_PENDING + 1 && !job; i++) {
+        if (!g_translation_jobs[i].in_use) {
+            job = &g_translation_jobs[i];
+            job->in_use = true;
+        }
+    }
+    pthread_mutex_unlock(&g_translation_jobs_lock);
+    return job;
+}
+
+static void release_translation_job(translation_job_t *job) {
+    pthread_mutex_lock(&g_translation_jobs_lock);
+    job->in_use = false;
+    pthread_mutex_unlock(&g_translation_jobs_lock);
+}
+
+/* Add the allocations the calling thread made since 'before' to the hot
+ * path count, if the pipeline has reached steady state */
+static void count_hot_path(unsigned long long before) {
+    if (g_steady) {
+        __atomic_fetch_add(&g_hot_path_allocs, alloc_counter_thread() - before, __ATOMIC_RELAXED);
+    }
+}
 
 /* Signal handler for graceful shutdown */
 static void signal_handler(int sig) {
@@ -40,69 +162,529 @@ static void signal_handler(int sig) {
     g_running = 0;
 }
 
-/* Translation callback - called when translation is ready */
-static void on_translation(const char *translated_text, void *user_data) {
-    const char *original_text = (const char *)user_data;
+/* Milliseconds from one timeline point to a later one (0 if either is unknown) */
+static double span_ms(uint64_t from_ns, uint64_t to_ns) {
+    return from_ns && to_ns > from_ns ? (double)(to_ns - from_ns) / 1e6 : 0.0;
+}
+
+/* Per-stage latency of a transcription for IPC */
+static void fill_latency(ipc_latency_t *latency, const whisper_timing_t *asr) {
+    memset(latency, 0, sizeof(*latency));
+    latency->audio_start_ns = asr->audio_start_ns;
+    latency->audio_end_ns = asr->audio_end_ns;
+    latency->capture_ms = span_ms(asr->audio_end_ns, asr->queued_ns);
+    latency->queue_ms = span_ms(asr->queued_ns, asr->started_ns);
+    latency->asr_ms = span_ms(asr->started_ns, asr->done_ns);
+    latency->reorder_ms = span_ms(asr->done_ns, asr->delivered_ns);
+}
+
+/* Translation callback - called when every target's translation is ready */
+static void on_translation(const translation_output_t *outputs, size_t num_outputs,
+                           const translation_timing_t *timing, void *user_data) {
+    translation_job_t *job = (translation_job_t *)user_data;
+    if (!job) return;
+
+    const unsigned long long allocs = alloc_counter_thread();
+    if (outputs && num_outputs > 0) {
+        ipc_translation_t translations[TRANSLATION_MAX_TARGETS];
+        if (num_outputs > TRANSLATION_MAX_TARGETS) num_outputs = TRANSLATION_MAX_TARGETS;
+        for (size_t i = 0; i < num_outputs; i++) {
+            LOG_DEBUG("[Translation] [%s] %s → %s: %s\n", job->source, job->text, outputs[i].target_lang,
+                      outputs[i].text);
+            translations[i].lang = outputs[i].target_lang;
+            translations[i].text = outputs[i].text;
+        }
 
-    if (translated_text && original_text) {
-        fprintf(stderr, "[Translation] %s → %s\n", original_text, translated_text);
+        ipc_latency_t latency;
+        fill_latency(&latency, &job->asr);
+        if (timing) {
+            latency.translation_queue_ms = span_ms(timing->queued_ns, timing->started_ns);
+            latency.translation_ms = span_ms(timing->started_ns, timing->done_ns);
+        }
 
         /* Send to frontend via IPC */
         time_t now = time(NULL);
-        ipc_send_translation(translated_text, original_text, (long)now);
+        ipc_send_translation(translations, num_outputs, job->text, job->source, &job->fragments, (long)now, &latency);
     }
 
-    /* Free the original text copy */
-    if (original_text) {
-        free((void *)original_text);
+    release_translation_job(job);
+    count_hot_path(allocs);
+}
+
+/* Queue text for translation into every target (the model may still be loading);
+ * first_id/last_id are the transcripts it spans, 0 if unnumbered */
+static void translate_text(const char *text, const char *source, const whisper_timing_t *timing,
+                           uint64_t first_id, uint64_t last_id) {
+    pthread_mutex_lock(&g_translator_lock);
+    translation_engine_t *translator = g_translator;
+    pthread_mutex_unlock(&g_translator_lock);
+
+    if (!translator || g_num_targets == 0) return;
+
+    /* Copy the text for the translation callback; if every job is
+     * taken the translator is behind and this line is skipped */
+    translation_job_t *job = acquire_translation_job();
+    if (job) {
+        snprintf(job->text, sizeof(job->text), "%s", text);
+        job->source = source;
+        job->asr = *timing;
+        job->fragments.first = first_id;
+        job->fragments.last = last_id;
+        const char *source_lang = g_source_lang ? g_source_lang : "auto";
+        if (!translation_translate(translator, job->text, source_lang, g_target_langs, g_num_targets, job)) {
+            release_translation_job(job);
+        }
+    } else {
+        LOG_WARN("[Main] Translation backlog full, not translating: %s\n", text);
     }
 }
 
 /* Transcription callback - called when Whisper has results */
-static void on_transcription(const char *text, void *user_data) {
-    (void)user_data;
+static void on_transcription(const char *text, const whisper_timing_t *timing, void *user_data) {
+    capture_stream_t *stream = (capture_stream_t *)user_data;
+    const char *source = stream ? stream->label : NULL;
+    const unsigned long long allocs = alloc_counter_thread();
 
     if (text && strlen(text) > 0) {
-        fprintf(stderr, "[Transcription] %s\n", text);
+        LOG_DEBUG("[Transcription] [%s] %s\n", source ? source : "-", text);
 
-        /* Send to frontend via IPC */
+        ipc_latency_t latency;
+        fill_latency(&latency, timing);
+
+        /* Send to frontend via IPC; translations name the transcripts they cover by id */
+        const uint64_t id = stream ? ++stream->transcripts : 0;
         time_t now = time(NULL);
-        ipc_send_transcription(text, (long)now);
-
-        /* If translation is enabled, translate the text */
-        if (g_translator && g_target_lang) {
-            /* Make a copy of the text for the translation callback */
-            char *text_copy = strdup(text);
-            if (text_copy) {
-                const char *source_lang = g_source_lang ? g_source_lang : "auto";
-                translation_translate(g_translator, text_copy, source_lang, g_target_lang, text_copy);
+        ipc_send_transcription(text, source, id, (long)now, &latency);
+
+        /* If translation is enabled, translate whole sentences once complete */
+        if (g_num_targets > 0) {
+            if (stream && stream->sentences) {
+                sentence_buffer_push(stream->sentences, text, timing, id);
+            } else {
+                translate_text(text, source, timing, id, id);
             }
         }
     }
+
+    count_hot_path(allocs);
+}
+
+/* Sentence callback - called when a stream's sentence buffer commits text */
+static void on_sentence(const char *sentence, const whisper_timing_t *timing,
+                        uint64_t first_id, uint64_t last_id, void *user_data) {
+    const capture_stream_t *stream = (const capture_stream_t *)user_data;
+    translate_text(sentence, stream->label, timing, first_id, last_id);
 }
 
-/* Audio callback - called when audio data is available */
-static void on_audio_data(const float *samples, size_t num_samples, void *user_data) {
+/* Governor callback - called for every real-time quality/speed decision */
+static void on_governor(const asr_governor_decision_t *decision, void *user_data) {
     (void)user_data;
 
-    /* Accumulate audio in buffer */
+    time_t now = time(NULL);
+    ipc_send_governor(decision->action, decision->knob, decision->model, decision->beam_size,
+                      decision->temperature_fallback, decision->chunk_ms, decision->rtf, decision->load,
+                      (long)now);
+}
+
+/* Router callback - called when the engine switches to or from a language-specific model */
+static void on_route(const asr_router_decision_t *decision, void *user_data) {
+    (void)user_data;
+
+    char status_msg[640];
+    if (strcmp(decision->action, "route") == 0) {
+        snprintf(status_msg, sizeof(status_msg), "Detected language: %s - using %s",
+                 decision->language, decision->model);
+    } else {
+        snprintf(status_msg, sizeof(status_msg), "Detected language: %s - back to multilingual %s",
+                 decision->language, decision->model);
+    }
+    ipc_send_status(status_msg);
+}
+
+/* Append to a stream's startup ring, overwriting the oldest audio (stream->lock held) */
+static void buffer_audio(capture_stream_t *stream, const float *samples, size_t num_samples, uint64_t capture_ns) {
+    if (!stream->backlog) {
+        stream->backlog = malloc(STARTUP_BUFFER_SAMPLES * sizeof(float));
+        if (!stream->backlog) return;
+    }
+    stream->backlog_end_ns = capture_ns;
+
     for (size_t i = 0; i < num_samples; i++) {
-        audio_buffer[audio_buffer_pos++] = samples[i];
+        stream->backlog[(stream->backlog_start + stream->backlog_len) % STARTUP_BUFFER_SAMPLES] = samples[i];
+        if (stream->backlog_len < STARTUP_BUFFER_SAMPLES) {
+            stream->backlog_len++;
+        } else {
+            stream->backlog_start = (stream->backlog_start + 1) % STARTUP_BUFFER_SAMPLES;
+        }
+    }
+}
 
-        /* Process when buffer is full (3 seconds) */
-        if (audio_buffer_pos >= AUDIO_CHUNK_SIZE) {
-            /* Process with Whisper */
-            if (g_whisper) {
-                whisper_engine_process(g_whisper, audio_buffer, audio_buffer_pos);
-            }
+/* Audio callback - called when audio data is available on one source */
+static void on_audio_data(const float *samples, size_t num_samples, uint64_t capture_ns, void *user_data) {
+    capture_stream_t *stream = (capture_stream_t *)user_data;
+    const unsigned long long allocs = alloc_counter_thread();
+
+    /* Whisper cuts 3 s chunks with 1 s overlap and queues them on its pool */
+    pthread_mutex_lock(&stream->lock);
+    if (stream->asr) {
+        whisper_engine_stream_push(g_whisper, stream->asr, samples, num_samples, capture_ns);
+    } else {
+        buffer_audio(stream, samples, num_samples, capture_ns);
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    count_hot_path(allocs);
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+/* Load Whisper and run a silent chunk through every state */
+static void* whisper_loader_thread(void *arg) {
+    const char *language = (const char *)arg;
+    model_memory_usage_t before, after;
+    trace_thread_name("loader:whisper");
+    model_memory_usage(&before, true);
+    double t_start = now_ms();
+    uint64_t span = trace_begin();
+    whisper_engine_t *engine = whisper_engine_init_with_params(g_model_path, language, &g_whisper_params,
+                                                               on_transcription, NULL);
+    double t_loaded = now_ms();
+    trace_end("whisper_load", "startup", span, 0);
+    model_memory_usage(&after, true);
+    span = trace_begin();
+    if (engine && !whisper_engine_warm_up(engine)) {
+        LOG_ERROR("[Main] Whisper warm-up failed: %s\n", whisper_engine_get_error());
+    }
+    trace_end("whisper_warmup", "startup", span, 0);
+    double t_warm = now_ms();
+
+    pthread_mutex_lock(&g_startup_lock);
+    g_whisper_loader.engine = engine;
+    g_whisper_loader.load_ms = t_loaded - t_start;
+    g_whisper_loader.warmup_ms = engine ? t_warm - t_loaded : 0.0;
+    g_whisper_loader.before = before;
+    g_whisper_loader.after = after;
+    g_whisper_loader.done = true;
+    pthread_mutex_unlock(&g_startup_lock);
+    return NULL;
+}
+
+/* Load the translation model and run one sentence through it */
+static void* translation_loader_thread(void *arg) {
+    (void)arg;
+    model_memory_usage_t before, after;
+    trace_thread_name("loader:translation");
+    model_memory_usage(&before, true);
+    double t_start = now_ms();
+    uint64_t span = trace_begin();
+    translation_engine_t *engine = translation_init_with_params(g_translation_model_path, &g_translation_params,
+                                                                on_translation, NULL);
+    double t_loaded = now_ms();
+    trace_end("translation_load", "startup", span, 0);
+    model_memory_usage(&after, true);
+    span = trace_begin();
+    if (engine && !translation_warm_up(engine)) {
+        LOG_ERROR("[Main] Translation warm-up failed\n");
+    }
+    trace_end("translation_warmup", "startup", span, 0);
+    double t_warm = now_ms();
+
+    pthread_mutex_lock(&g_startup_lock);
+    g_translation_loader.engine = engine;
+    g_translation_loader.load_ms = t_loaded - t_start;
+    g_translation_loader.warmup_ms = engine ? t_warm - t_loaded : 0.0;
+    g_translation_loader.before = before;
+    g_translation_loader.after = after;
+    g_translation_loader.done = true;
+    pthread_mutex_unlock(&g_startup_lock);
+    return NULL;
+}
+
+static bool start_loader(model_loader_t *loader, void *(*fn)(void *), void *arg) {
+    if (pthread_create(&loader->thread, NULL, fn, arg) != 0) {
+        return false;
+    }
+    loader->started = true;
+    return true;
+}
+
+/* Join a loader once it has finished; returns true if it was joined now */
+static bool join_loader(model_loader_t *loader, bool wait) {
+    if (!loader->started) return false;
+
+    pthread_mutex_lock(&g_startup_lock);
+    bool done = loader->done;
+    pthread_mutex_unlock(&g_startup_lock);
+    if (!done && !wait) return false;
+
+    pthread_join(loader->thread, NULL);
+    loader->started = false;
+    return true;
+}
+
+/* Report a startup phase over IPC and on stderr */
+static void report_phase(const char *phase, double ms) {
+    LOG_INFO("[Main] Startup %s: %.0f ms\n", phase, ms);
+    ipc_send_startup(phase, ms, (long)time(NULL));
+}
+
+/* Report what loading a model cost in memory and page faults */
+static void report_memory(const char *phase, const model_loader_t *loader) {
+    unsigned long minor = loader->after.minor_faults - loader->before.minor_faults;
+    unsigned long major = loader->after.major_faults - loader->before.major_faults;
+    LOG_INFO("[Main] Memory after %s: %.0f MB resident (%.0f MB huge pages), %lu minor / %lu major faults\n",
+            phase, loader->after.rss_mb, loader->after.huge_mb, minor, major);
+    ipc_send_memory(phase, loader->after.rss_mb, loader->after.huge_mb, minor, major, (long)time(NULL));
+}
+
+/* Report capture gaps and late reads since the last check; the final
+ * report summarises the whole session */
+static void check_audio_health(bool final) {
+    for (size_t i = 0; i < g_num_streams; i++) {
+        capture_stream_t *stream = &g_streams[i];
+        audio_stats_t stats;
+        if (!audio_get_stats(g_audio, i, &stats)) continue;
+
+        if (final) {
+            LOG_INFO("[Main] Audio '%s': %lu buffers, %lu late, %lu gaps (%.0f ms lost), longest stall %.0f ms\n",
+                    stream->label, stats.reads, stats.late_reads, stats.gaps, stats.lost_ms, stats.max_stall_ms);
+            continue;
+        }
+
+        const unsigned long gaps = stats.gaps - stream->reported.gaps;
+        const unsigned long late = stats.late_reads - stream->reported.late_reads;
+        if (gaps == 0 && late == 0) continue;
+
+        char message[160];
+        snprintf(message, sizeof(message), "Audio '%s': %lu gaps (%.0f ms lost), %lu late reads in the last %d s",
+                 stream->label, gaps, stats.lost_ms - stream->reported.lost_ms, late, AUDIO_HEALTH_INTERVAL_S);
+        LOG_WARN("[Main] %s\n", message);
+        ipc_send_status(message);
+        stream->reported = stats;
+    }
+}
+
+/* Log heap allocations made on the hot path since the last report (only
+ * when counting is built in); the final report covers the whole session
+ * and returns false if the path allocated at all */
+static bool check_allocations(bool final) {
+    if (!g_steady || !alloc_counter_available()) return true;
+
+    const unsigned long long hot = __atomic_load_n(&g_hot_path_allocs, __ATOMIC_RELAXED);
+    const unsigned long long total = alloc_counter_total() - g_steady_total;
+    if (final) {
+        if (hot > 0) {
+            LOG_ERROR("[Main] Heap allocations since steady state: %llu on the audio/result path, expected 0 (%llu process-wide)\n",
+                    hot, total);
+            return false;
+        }
+        LOG_INFO("[Main] Heap allocations since steady state: 0 on the audio/result path (%llu process-wide)\n",
+                total);
+    } else if (hot != g_hot_path_reported) {
+        LOG_WARN("[Main] Warning: %llu heap allocations on the audio/result path in the last %d s (%llu process-wide since steady state)\n",
+                hot - g_hot_path_reported, AUDIO_HEALTH_INTERVAL_S, total);
+    }
+    g_hot_path_reported = hot;
+    return true;
+}
+
+static void register_metrics(void) {
+    g_metrics.audio_gaps = metrics_counter("audio_gaps_total", "Capture discontinuities, all sources");
+    g_metrics.audio_lost_ms = metrics_counter("audio_lost_ms_total", "Audio lost in capture gaps, all sources");
+    g_metrics.audio_late_reads = metrics_counter("audio_late_reads_total", "Buffers collected late, all sources");
+    g_metrics.whisper_dropped = metrics_counter("whisper_dropped_chunks_total",
+                                                "Chunks discarded because inference fell behind");
+    g_metrics.whisper_rtf = metrics_gauge("whisper_rtf", "Rolling real-time factor of Whisper inference");
+    g_metrics.whisper_load = metrics_gauge("whisper_load", "Whisper RTF x streams / pool size");
+    g_metrics.whisper_queue_depth = metrics_gauge("whisper_queue_depth", "Chunks waiting for a Whisper state");
+    g_metrics.rss_mb = metrics_gauge("rss_mb", "Resident set size");
+}
+
+/* Copy the audio, Whisper and memory totals into the registry */
+static void update_metrics(void) {
+    unsigned long gaps = 0, late = 0;
+    double lost_ms = 0.0;
+    for (size_t i = 0; g_audio && i < g_num_streams; i++) {
+        audio_stats_t stats;
+        if (!audio_get_stats(g_audio, i, &stats)) continue;
+        gaps += stats.gaps;
+        late += stats.late_reads;
+        lost_ms += stats.lost_ms;
+    }
+    metrics_counter_set(g_metrics.audio_gaps, gaps);
+    metrics_counter_set(g_metrics.audio_lost_ms, (uint64_t)(lost_ms + 0.5));
+    metrics_counter_set(g_metrics.audio_late_reads, late);
+
+    if (g_whisper) {
+        whisper_engine_stats_t stats;
+        whisper_engine_get_stats(g_whisper, &stats);
+        metrics_counter_set(g_metrics.whisper_dropped, stats.dropped);
+        metrics_gauge_set(g_metrics.whisper_rtf, stats.rtf);
+        metrics_gauge_set(g_metrics.whisper_load, stats.load);
+        metrics_gauge_set(g_metrics.whisper_queue_depth, (double)stats.queued);
+    }
+
+    model_memory_usage_t usage;
+    model_memory_usage(&usage, false);
+    metrics_gauge_set(g_metrics.rss_mb, usage.rss_mb);
+}
+
+/* Periodic "stats" message */
+static void publish_stats(void) {
+    update_metrics();
+    metrics_format_json(g_metrics_text, sizeof(g_metrics_text));
+    ipc_send_stats(g_metrics_text, (long)time(NULL));
+}
 
-            /* Overlap: keep last 1 second for context */
-            const size_t overlap = AUDIO_SAMPLE_RATE;
-            memmove(audio_buffer, audio_buffer + audio_buffer_pos - overlap,
-                   overlap * sizeof(float));
-            audio_buffer_pos = overlap;
+/* Commands from frontend (see ipc_poll) */
+static void on_command(const char *type, void *user_data) {
+    (void)user_data;
+
+    if (strcmp(type, "get_metrics") == 0) {
+        update_metrics();
+        metrics_format_prometheus(g_metrics_text, sizeof(g_metrics_text));
+        ipc_send_metrics(g_metrics_text);
+    } else {
+        LOG_WARN("[Main] Unknown command from frontend: %s\n", type);
+    }
+}
+
+/* Whisper has loaded: create one stream per source, feed it the audio
+ * captured meanwhile, then start the governor and router */
+static bool start_transcription(const char *language, bool use_governor, const asr_governor_params_t *governor_params,
+                                bool use_router, asr_router_params_t *router_params) {
+    g_whisper = (whisper_engine_t *)g_whisper_loader.engine;
+    if (!g_whisper) {
+        LOG_ERROR("[Main] Failed to initialize Whisper: %s\n", whisper_engine_get_error());
+        ipc_send_error("Failed to initialize Whisper");
+        return false;
+    }
+
+    /* One Whisper state per source, all sharing the loaded model */
+    size_t buffered = 0;
+    for (size_t i = 0; i < g_num_streams; i++) {
+        capture_stream_t *stream = &g_streams[i];
+        whisper_stream_t *asr = whisper_engine_stream_create(g_whisper, stream);
+        if (!asr) {
+            LOG_ERROR("[Main] Failed to create Whisper stream '%s': %s\n",
+                    stream->label, whisper_engine_get_error());
+            ipc_send_error("Failed to initialize Whisper");
+            return false;
+        }
+
+        /* The ring's oldest audio first */
+        pthread_mutex_lock(&stream->lock);
+        if (stream->backlog_len > 0) {
+            size_t first = STARTUP_BUFFER_SAMPLES - stream->backlog_start;
+            if (first > stream->backlog_len) first = stream->backlog_len;
+            const size_t second = stream->backlog_len - first;
+            const uint64_t first_end_ns = stream->backlog_end_ns -
+                                          (uint64_t)second * 1000000000ull / AUDIO_SAMPLE_RATE;
+            whisper_engine_stream_push(g_whisper, asr, stream->backlog + stream->backlog_start, first, first_end_ns);
+            whisper_engine_stream_push(g_whisper, asr, stream->backlog, second, stream->backlog_end_ns);
+            if (stream->backlog_len > buffered) buffered = stream->backlog_len;
+            stream->backlog_len = 0;
+        }
+        stream->asr = asr;
+        pthread_mutex_unlock(&stream->lock);
+    }
+    if (buffered > 0) {
+        LOG_INFO("[Main] Transcribing %.1f s captured during startup\n",
+                (double)buffered / AUDIO_SAMPLE_RATE);
+    }
+
+    /* Trade quality for speed when transcription falls behind */
+    if (use_governor) {
+        g_governor = asr_governor_create(g_whisper, governor_params, on_governor, NULL);
+        if (!g_governor) {
+            LOG_WARN("[Main] Warning: Governor disabled: %s\n", asr_governor_get_error());
+        }
+    }
+
+    /* Switch to faster language-specific models once the language is known */
+    if (use_router) {
+        router_params->language = language;
+        g_router = asr_router_create(g_whisper, router_params, on_route, NULL);
+        if (!g_router) {
+            LOG_WARN("[Main] Language routing off: %s\n", asr_router_get_error());
+        }
+    }
+
+    return true;
+}
+
+/* The translation loader finished: publish the engine, or turn translation off */
+static void finish_translation_startup(void) {
+    translation_engine_t *engine = (translation_engine_t *)g_translation_loader.engine;
+    if (!engine) {
+        LOG_WARN("[Main] Warning: Failed to initialize translation engine\n");
+        LOG_INFO("[Main] Translation will be disabled. Continuing without translation...\n");
+        ipc_send_status("Translation unavailable - continuing with transcription only");
+        g_num_targets = 0;  /* Disable translation */
+        return;
+    }
+
+    report_phase("translation_load", g_translation_loader.load_ms);
+    report_memory("translation_load", &g_translation_loader);
+    report_phase("translation_warmup", g_translation_loader.warmup_ms);
+
+    pthread_mutex_lock(&g_translator_lock);
+    g_translator = engine;
+    pthread_mutex_unlock(&g_translator_lock);
+
+    LOG_INFO("[Main] Translation engine ready\n");
+    ipc_send_status("Translation engine ready");
+}
+
+/* Parse a -t argument: one or more comma-separated language codes */
+static bool set_targets(char *spec) {
+    g_num_targets = 0;
+    for (char *lang = strtok(spec, ","); lang; lang = strtok(NULL, ",")) {
+        if (g_num_targets >= TRANSLATION_MAX_TARGETS) {
+            fprintf(stderr, "Too many target languages (max %d)\n", TRANSLATION_MAX_TARGETS);
+            return false;
         }
+        g_target_langs[g_num_targets++] = lang;
     }
+    return g_num_targets > 0;
+}
+
+/* Parse a -s argument: "mic", "system", "LABEL=DEVICE" or a bare device name */
+static bool add_source(char *spec) {
+    if (g_num_streams >= AUDIO_MAX_SOURCES) {
+        fprintf(stderr, "Too many audio sources (max %d)\n", AUDIO_MAX_SOURCES);
+        return false;
+    }
+
+    capture_stream_t *stream = &g_streams[g_num_streams];
+    char *eq = strchr(spec, '=');
+
+    if (eq) {
+        *eq = '\0';
+        stream->label = spec;
+        stream->device = eq + 1;
+    } else if (strcmp(spec, "mic") == 0) {
+        stream->label = "mic";
+        stream->device = NULL;  /* Default input */
+    } else if (strcmp(spec, "system") == 0) {
+#ifdef AUDIO_DEVICE_DEFAULT_MONITOR
+        stream->label = "system";
+        stream->device = AUDIO_DEVICE_DEFAULT_MONITOR;
+#else
+        fprintf(stderr, "'system' needs a loopback device on this platform: use -s system=DEVICE\n");
+        return false;
+#endif
+    } else {
+        stream->label = spec;
+        stream->device = spec;
+    }
+
+    g_num_streams++;
+    return true;
 }
 
 static void print_usage(const char *prog) {
@@ -110,8 +692,40 @@ static void print_usage(const char *prog) {
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  -m MODEL    Path to Whisper model (default: %s)\n", DEFAULT_MODEL_PATH);
     fprintf(stderr, "  -l LANG     Language code (en, fr, es, etc.) or 'auto' for auto-detect (default: auto)\n");
-    fprintf(stderr, "  -t LANG     Target language for translation (optional, e.g., en, fr, es)\n");
+    fprintf(stderr, "  -t LANGS    Target language(s) for translation, comma-separated (optional, e.g., fr or fr,de,es;\n");
+    fprintf(stderr, "              max %d, translated together by one model)\n", TRANSLATION_MAX_TARGETS);
     fprintf(stderr, "  -T MODEL    Path to translation model (default: %s)\n", DEFAULT_TRANSLATION_MODEL);
+    fprintf(stderr, "  -S MS       Translate whole sentences, committing pending text after at most MS\n");
+    fprintf(stderr, "              (0 = translate each transcript as it arrives, default: %d)\n",
+            sentence_buffer_default_params().max_latency_ms);
+    fprintf(stderr, "  -W N        Keep the last N translated sentences as context per target (max %d, default: 0)\n",
+            TRANSLATION_MAX_CONTEXT);
+    fprintf(stderr, "  --context-tokens N  Token budget of that context (default: %d)\n",
+            translation_default_params().context_tokens);
+    fprintf(stderr, "  -P N        Whisper decoder states run in parallel (max %d, default: auto)\n",
+            WHISPER_MAX_POOL_SIZE);
+    fprintf(stderr, "  -j N        Compute threads per Whisper state (default: auto)\n");
+    fprintf(stderr, "  -A N        Encoder context step in 20 ms positions, 0 = full 30 s window (default: %d)\n",
+            WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT);
+    fprintf(stderr, "  -p          Overlap each chunk's decoder with the next chunk's encoder (greedy only)\n");
+    fprintf(stderr, "  -b N        Beam search width, 1 = greedy (default: 1)\n");
+    fprintf(stderr, "  -c N        Compute threads shared by Whisper and translation (default: physical cores)\n");
+    fprintf(stderr, "  -C LIST     Pin to these CPUs, e.g. 0-3,8 (Linux, Windows)\n");
+    fprintf(stderr, "  -F          Real-time priority for audio capture (SCHED_FIFO, needs rtprio limit)\n");
+    fprintf(stderr, "  -a LIST     Pin audio capture threads to these CPUs, e.g. 0 (keep them out of -C)\n");
+    fprintf(stderr, "  -N          Read model files instead of memory-mapping them\n");
+    fprintf(stderr, "  -L          Lock loaded models in RAM (mlock, needs RLIMIT_MEMLOCK)\n");
+    fprintf(stderr, "  -H MODE     Huge pages for model weights: off, thp, collapse (Linux, default: off)\n");
+    fprintf(stderr, "  -M MODEL    Smaller Whisper model to fall back to under load, repeatable (max %d)\n",
+            ASR_GOVERNOR_MAX_MODELS - 1);
+    fprintf(stderr, "  -g          Disable the real-time governor\n");
+    fprintf(stderr, "  -R L=MODEL  Model to switch to once language L is detected, repeatable (max %d)\n",
+            ASR_ROUTER_MAX_ROUTES);
+    fprintf(stderr, "  -r          Disable language-specific model routing\n");
+    fprintf(stderr, "  -s SOURCE   Audio source, repeatable (max %d): mic, system, LABEL=DEVICE (default: mic)\n",
+            AUDIO_MAX_SOURCES);
+    fprintf(stderr, "  -V LEVEL    Log level: debug, info, warn, error, off (default: info)\n");
+    fprintf(stderr, "  --trace FILE  Record per-stage spans, written to FILE as Chrome trace JSON on exit\n");
     fprintf(stderr, "  -h          Show this help\n");
 }
 
@@ -120,6 +734,19 @@ int main(int argc, char *argv[]) {
     const char *language = DEFAULT_LANGUAGE;
     const char *translation_model_path = DEFAULT_TRANSLATION_MODEL;
     const char *target_lang = NULL;
+    static char target_spec[64];  /* -t value split in place; g_target_langs point into it */
+    whisper_engine_params_t whisper_params = whisper_engine_default_params();
+    const double t_startup = now_ms();
+    asr_governor_params_t governor_params = asr_governor_default_params();
+    bool use_governor = true;
+    asr_router_params_t router_params = asr_router_default_params();
+    bool use_router = true;
+    cpu_budget_params_t cpu_params = cpu_budget_default_params();
+    audio_params_t audio_params = audio_default_params();
+    sentence_buffer_params_t sentence_params = sentence_buffer_default_params();
+    translation_params_t translation_params = translation_default_params();
+    log_level_t log_level = LOG_LEVEL_INFO;
+    const char *trace_path = NULL;
 
     /* Parse command line arguments */
     for (int i = 1; i < argc; i++) {
@@ -132,8 +759,78 @@ int main(int argc, char *argv[]) {
             }
         } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
             target_lang = argv[++i];
+            snprintf(target_spec, sizeof(target_spec), "%s", target_lang);
+            if (!set_targets(target_spec)) {
+                fprintf(stderr, "Invalid target languages: %s\n", target_lang);
+                return 1;
+            }
         } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
             translation_model_path = argv[++i];
+        } else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc) {
+            sentence_params.max_latency_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-W") == 0 && i + 1 < argc) {
+            translation_params.context_sentences = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--context-tokens") == 0 && i + 1 < argc) {
+            translation_params.context_tokens = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            whisper_params.pool_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            whisper_params.threads_per_state = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-A") == 0 && i + 1 < argc) {
+            whisper_params.audio_ctx_granularity = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            whisper_params.pipeline = true;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            whisper_params.beam_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cpu_params.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-C") == 0 && i + 1 < argc) {
+            cpu_params.affinity = argv[++i];
+        } else if (strcmp(argv[i], "-F") == 0) {
+            audio_params.realtime = true;
+        } else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+            audio_params.affinity = argv[++i];
+        } else if (strcmp(argv[i], "-N") == 0) {
+            whisper_params.memory.mmap = false;
+        } else if (strcmp(argv[i], "-L") == 0) {
+            whisper_params.memory.mlock = true;
+        } else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+            if (!model_memory_parse_huge_pages(argv[++i], &whisper_params.memory.huge_pages)) {
+                fprintf(stderr, "Invalid huge page mode: %s (off, thp, collapse)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc) {
+            if (governor_params.num_models >= ASR_GOVERNOR_MAX_MODELS - 1) {
+                fprintf(stderr, "Too many fallback models (max %d)\n", ASR_GOVERNOR_MAX_MODELS - 1);
+                return 1;
+            }
+            governor_params.models[governor_params.num_models++] = argv[++i];
+        } else if (strcmp(argv[i], "-g") == 0) {
+            use_governor = false;
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            char *spec = argv[++i];
+            char *eq = strchr(spec, '=');
+            if (!eq || router_params.num_routes >= ASR_ROUTER_MAX_ROUTES) {
+                fprintf(stderr, "Invalid or too many routes (LANG=MODEL, max %d)\n", ASR_ROUTER_MAX_ROUTES);
+                return 1;
+            }
+            *eq = '\0';
+            router_params.routes[router_params.num_routes].language = spec;
+            router_params.routes[router_params.num_routes].model = eq + 1;
+            router_params.num_routes++;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            use_router = false;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (!add_source(argv[++i])) {
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-V") == 0 && i + 1 < argc) {
+            if (!logger_parse_level(argv[++i], &log_level)) {
+                fprintf(stderr, "Invalid log level: %s (debug, info, warn, error, off)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
         } else if (strcmp(argv[i], "-h") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -144,84 +841,168 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    /* Capture the default input when no source is given */
+    if (g_num_streams == 0) {
+        char mic[] = "mic";
+        add_source(mic);
+    }
+
     /* Store translation settings in global variables */
-    g_target_lang = target_lang;
     g_source_lang = language;
 
     /* Set up signal handlers */
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
 
-    fprintf(stderr, "=== VisualIA Backend ===\n");
-    fprintf(stderr, "[Main] Starting up...\n");
+    /* Log lines go through a ring drained by a background thread, so the
+     * audio and inference threads never block on stderr */
+    logger_set_level(log_level);
+    logger_start();
+
+    /* Before any thread starts, so startup is in the trace too */
+    if (trace_path && trace_start(trace_path)) {
+        trace_thread_name("main");
+    }
+
+    LOG_INFO("=== VisualIA Backend ===\n");
+    LOG_INFO("[Main] Starting up...\n");
+
+    /* Before any thread starts, so they all inherit the CPU affinity */
+    if (!cpu_budget_init(&cpu_params)) {
+        LOG_WARN("[Main] Warning: %s\n", cpu_budget_get_error());
+    }
 
     /* Initialize IPC */
     if (!ipc_init()) {
-        fprintf(stderr, "[Main] Failed to initialize IPC\n");
+        LOG_ERROR("[Main] Failed to initialize IPC\n");
+        trace_stop();
+        logger_shutdown();
         return 1;
     }
+    register_metrics();
+    ipc_set_command_callback(on_command, NULL);
 
-    ipc_send_status("Initializing Whisper...");
+    /* Load both models in parallel, in the background */
+    g_model_path = model_path;
+    g_translation_model_path = translation_model_path;
+    g_whisper_params = whisper_params;
+    translation_params.memory = whisper_params.memory;
+    g_translation_params = translation_params;
 
-    /* Initialize Whisper */
-    g_whisper = whisper_engine_init(model_path, language, on_transcription, NULL);
-    if (!g_whisper) {
-        fprintf(stderr, "[Main] Failed to initialize Whisper: %s\n", whisper_engine_get_error());
+    ipc_send_status("Initializing Whisper...");
+    if (!start_loader(&g_whisper_loader, whisper_loader_thread, (void *)language)) {
+        LOG_ERROR("[Main] Failed to start Whisper loader thread\n");
         ipc_send_error("Failed to initialize Whisper");
         ipc_cleanup();
+        trace_stop();
+        logger_shutdown();
         return 1;
     }
 
-    /* Initialize translation engine if target language is specified */
-    if (target_lang) {
+    if (g_num_targets > 0) {
         ipc_send_status("Initializing translation engine...");
-        fprintf(stderr, "[Main] Initializing translation: %s → %s\n",
+        LOG_INFO("[Main] Initializing translation: %s → %s\n",
                 language ? language : "auto", target_lang);
-
-        g_translator = translation_init(translation_model_path, on_translation, NULL);
-        if (!g_translator) {
-            fprintf(stderr, "[Main] Warning: Failed to initialize translation engine\n");
-            fprintf(stderr, "[Main] Translation will be disabled. Continuing without translation...\n");
-            ipc_send_status("Translation unavailable - continuing with transcription only");
-            g_target_lang = NULL;  /* Disable translation */
-        } else {
-            fprintf(stderr, "[Main] Translation engine ready\n");
-            ipc_send_status("Translation engine ready");
+        if (!start_loader(&g_translation_loader, translation_loader_thread, NULL)) {
+            LOG_WARN("[Main] Warning: Failed to start translation loader thread\n");
+            g_num_targets = 0;
         }
     }
 
+    /* Capture right away; audio is buffered until Whisper is ready */
     ipc_send_status("Initializing audio capture...");
+    double t_audio = now_ms();
 
-    /* Initialize audio capture */
-    g_audio = audio_init(on_audio_data, NULL);
-    if (!g_audio) {
-        fprintf(stderr, "[Main] Failed to initialize audio: %s\n", audio_get_error());
-        ipc_send_error("Failed to initialize audio capture");
-        whisper_engine_cleanup(g_whisper);
-        ipc_cleanup();
-        return 1;
+    audio_source_t sources[AUDIO_MAX_SOURCES];
+    for (size_t i = 0; i < g_num_streams; i++) {
+        pthread_mutex_init(&g_streams[i].lock, NULL);
+        sources[i].device = g_streams[i].device;
+        sources[i].label = g_streams[i].label;
+        sources[i].user_data = &g_streams[i];
+
+        /* Whisper's fragments are cut at chunk edges and repeat the overlap */
+        if (g_num_targets > 0 && sentence_params.max_latency_ms > 0) {
+            g_streams[i].sentences = sentence_buffer_create(&sentence_params, on_sentence, &g_streams[i]);
+            if (!g_streams[i].sentences) {
+                LOG_WARN("[Main] Translating transcripts unassembled: %s\n", sentence_buffer_get_error());
+            }
+        }
     }
 
-    /* Start audio capture */
-    if (!audio_start(g_audio)) {
-        fprintf(stderr, "[Main] Failed to start audio: %s\n", audio_get_error());
+    int exit_code = 0;
+    g_audio = audio_init_with_params(sources, g_num_streams, on_audio_data, &audio_params);
+    if (!g_audio) {
+        LOG_ERROR("[Main] Failed to initialize audio: %s\n", audio_get_error());
+        ipc_send_error("Failed to initialize audio capture");
+        exit_code = 1;
+    } else if (!audio_start(g_audio)) {
+        LOG_ERROR("[Main] Failed to start audio: %s\n", audio_get_error());
         ipc_send_error("Failed to start audio capture");
-        audio_cleanup(g_audio);
-        whisper_engine_cleanup(g_whisper);
-        ipc_cleanup();
-        return 1;
+        exit_code = 1;
+    } else {
+        report_phase("audio", now_ms() - t_audio);
     }
 
-    ipc_send_status("Running - listening for audio...");
-    fprintf(stderr, "[Main] Running (press Ctrl+C to stop)\n");
-
     /* Main loop */
-    while (g_running) {
+    while (g_running && exit_code == 0) {
         /* Poll for IPC messages */
         ipc_poll();
 
-        /* Check for language detection changes (every second) */
+        /* Whisper ready: hand it the buffered audio and go live */
+        if (!g_whisper && join_loader(&g_whisper_loader, false)) {
+            if (!start_transcription(language, use_governor, &governor_params,
+                                     use_router, &router_params)) {
+                exit_code = 1;
+                break;
+            }
+            report_phase("whisper_load", g_whisper_loader.load_ms);
+            report_memory("whisper_load", &g_whisper_loader);
+            report_phase("whisper_warmup", g_whisper_loader.warmup_ms);
+            report_phase("ready", now_ms() - t_startup);
+            ipc_send_status("Running - listening for audio...");
+            LOG_INFO("[Main] Running (press Ctrl+C to stop)\n");
+        }
+
+        /* Translation ready (or failed): start translating new transcriptions */
+        if (join_loader(&g_translation_loader, false)) {
+            finish_translation_startup();
+        }
+
+        /* Sentences the speaker left unfinished */
+        for (size_t i = 0; i < g_num_streams; i++) {
+            sentence_buffer_poll(g_streams[i].sentences, trace_now_ns());
+        }
+
+        /* Both models up: from here on the callbacks should not allocate */
+        if (!g_steady && g_whisper && (g_translator || g_num_targets == 0)) {
+            g_steady_total = alloc_counter_total();
+            g_steady = 1;
+        }
+
+        /* Audio lost to a starved capture thread or an overflowing server buffer */
         time_t now = time(NULL);
+        if (now - g_last_audio_check >= AUDIO_HEALTH_INTERVAL_S) {
+            g_last_audio_check = now;
+            check_audio_health(false);
+            check_allocations(false);
+        }
+
+        /* Latency, queue and resource figures for the frontend */
+        if (now - g_last_stats >= STATS_INTERVAL_S) {
+            g_last_stats = now;
+            publish_stats();
+        }
+
+        if (!g_whisper) {
+            usleep(100000);
+            continue;
+        }
+
+        /* Adapt model, decoding and chunk length to the measured load */
+        asr_governor_update(g_governor);
+        asr_router_update(g_router);
+
+        /* Check for language detection changes (every second) */
         if (now - g_last_lang_check >= 1) {
             g_last_lang_check = now;
 
@@ -229,7 +1010,7 @@ int main(int argc, char *argv[]) {
             if (detected_lang && strlen(detected_lang) > 0) {
                 /* Check if language has changed */
                 if (strcmp(g_last_detected_lang, detected_lang) != 0) {
-                    fprintf(stderr, "[Main] Language changed: %s → %s\n",
+                    LOG_INFO("[Main] Language changed: %s → %s\n",
                             g_last_detected_lang[0] ? g_last_detected_lang : "none",
                             detected_lang);
 
@@ -238,13 +1019,6 @@ int main(int argc, char *argv[]) {
 
                     /* Send language detection to frontend */
                     ipc_send_language_detected(detected_lang);
-
-                    /* TODO: Reload Whisper with language-specific model */
-                    char status_msg[128];
-                    snprintf(status_msg, sizeof(status_msg),
-                            "Detected language: %s - Consider using language-specific model",
-                            detected_lang);
-                    ipc_send_status(status_msg);
                 }
             }
         }
@@ -254,21 +1028,56 @@ int main(int argc, char *argv[]) {
     }
 
     /* Cleanup */
-    fprintf(stderr, "[Main] Shutting down...\n");
+    LOG_INFO("[Main] Shutting down...\n");
     ipc_send_status("Shutting down...");
 
-    audio_stop(g_audio);
-    audio_cleanup(g_audio);
+    if (g_audio) {
+        audio_stop(g_audio);
+        check_audio_health(true);
+        if (!check_allocations(true)) {
+            exit_code = 1;  /* Counting builds hold the audio/result path to zero allocations */
+        }
+        audio_cleanup(g_audio);
+    }
+
+    /* A model still loading finishes first */
+    if (join_loader(&g_whisper_loader, true) && !g_whisper) {
+        g_whisper = (whisper_engine_t *)g_whisper_loader.engine;
+    }
+    if (join_loader(&g_translation_loader, true)) {
+        pthread_mutex_lock(&g_translator_lock);
+        g_translator = (translation_engine_t *)g_translation_loader.engine;
+        pthread_mutex_unlock(&g_translator_lock);
+    }
+
+    /* Transcribe the audio captured before the stop, so the last utterance
+     * reaches the sentence buffers instead of being discarded by cleanup */
+    whisper_engine_drain(g_whisper);
+
+    asr_router_destroy(g_router);
+    asr_governor_destroy(g_governor);
     whisper_engine_cleanup(g_whisper);
 
+    /* Whatever is still pending, including fragments the Whisper drain just
+     * delivered, is translated before the worker drains its queue */
+    for (size_t i = 0; i < g_num_streams; i++) {
+        sentence_buffer_flush(g_streams[i].sentences);
+    }
+
     if (g_translator) {
         translation_cleanup(g_translator);
     }
 
+    for (size_t i = 0; i < g_num_streams; i++) {
+        sentence_buffer_destroy(g_streams[i].sentences);
+        free(g_streams[i].backlog);
+        pthread_mutex_destroy(&g_streams[i].lock);
+    }
+
     ipc_cleanup();
+    trace_stop();
 
-    fprintf(stderr, "[Main] Goodbye!\n");
-    return 0;
+    LOG_INFO("[Main] Goodbye!\n");
+    logger_shutdown();
+    return exit_code;
 }
-message.txt
-10 Ko
\ No newline at end of file
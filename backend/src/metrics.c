@@ -0,0 +1,251 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define METRICS_MAX 48
+#define METRICS_NAME_MAX 64
+#define METRICS_HELP_MAX 128
+#define METRICS_PREFIX "visualia_"
+
+/* Log-linear buckets over microseconds: values below 2^SUB_BITS get one
+ * bucket each, every later power of two is split into 2^SUB_BITS buckets */
+#define SUB_BITS 5
+#define SUB_BUCKETS (1 << SUB_BITS)
+#define MAX_EXPONENT 40         /* 2^40 us, about 12 days */
+#define HISTOGRAM_BUCKETS (SUB_BUCKETS + (MAX_EXPONENT - SUB_BITS + 1) * SUB_BUCKETS)
+
+typedef enum {
+    METRIC_HISTOGRAM,
+    METRIC_COUNTER,
+    METRIC_GAUGE
+} metric_kind_t;
+
+struct metrics_histogram {
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+};
+
+struct metrics_counter {
+    uint64_t value;
+};
+
+struct metrics_gauge {
+    double value;
+};
+
+typedef struct {
+    metric_kind_t kind;
+    char name[METRICS_NAME_MAX];
+    char help[METRICS_HELP_MAX];
+    void *metric;
+} metric_entry_t;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static metric_entry_t registry[METRICS_MAX];
+static int num_metrics = 0;     /* Entries are only appended, so readers need the lock for this alone */
+
+static void* lookup(metric_kind_t kind, const char *name, const char *help, size_t size) {
+    if (!name) return NULL;
+
+    void *metric = NULL;
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < num_metrics; i++) {
+        if (strcmp(registry[i].name, name) == 0) {
+            metric = registry[i].kind == kind ? registry[i].metric : NULL;
+            pthread_mutex_unlock(&registry_lock);
+            return metric;
+        }
+    }
+
+    if (num_metrics < METRICS_MAX) {
+        metric = calloc(1, size);
+        if (metric) {
+            metric_entry_t *entry = &registry[num_metrics];
+            entry->kind = kind;
+            snprintf(entry->name, sizeof(entry->name), "%s", name);
+            snprintf(entry->help, sizeof(entry->help), "%s", help ? help : "");
+            entry->metric = metric;
+            num_metrics++;
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return metric;
+}
+
+metrics_histogram_t* metrics_histogram(const char *name, const char *help) {
+    return lookup(METRIC_HISTOGRAM, name, help, sizeof(metrics_histogram_t));
+}
+
+metrics_counter_t* metrics_counter(const char *name, const char *help) {
+    return lookup(METRIC_COUNTER, name, help, sizeof(metrics_counter_t));
+}
+
+metrics_gauge_t* metrics_gauge(const char *name, const char *help) {
+    return lookup(METRIC_GAUGE, name, help, sizeof(metrics_gauge_t));
+}
+
+static int bucket_index(uint64_t us) {
+    if (us < SUB_BUCKETS) return (int)us;
+
+    int exponent = 63 - __builtin_clzll(us);
+    if (exponent > MAX_EXPONENT) return HISTOGRAM_BUCKETS - 1;
+    const int sub = (int)((us >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+    return SUB_BUCKETS + (exponent - SUB_BITS) * SUB_BUCKETS + sub;
+}
+
+/* Midpoint of a bucket, in microseconds */
+static double bucket_value(int index) {
+    if (index < SUB_BUCKETS) return (double)index;
+
+    const int exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BITS;
+    const int sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    const double width = (double)(1ull << (exponent - SUB_BITS));
+    return (double)(1ull << exponent) + (sub + 0.5) * width;
+}
+
+void metrics_observe(metrics_histogram_t *histogram, double ms) {
+    if (!histogram) return;
+    const uint64_t us = ms > 0.0 ? (uint64_t)(ms * 1000.0 + 0.5) : 0;
+
+    __atomic_fetch_add(&histogram->buckets[bucket_index(us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sum_us, us, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&histogram->max_us, &max, us, true,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void metrics_histogram_summary(const metrics_histogram_t *histogram, metrics_summary_t *summary) {
+    memset(summary, 0, sizeof(*summary));
+    if (!histogram) return;
+
+    /* Bucket counts are read one by one while others record, so derive the
+     * total from them rather than from count */
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        counts[i] = __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+        total += counts[i];
+    }
+
+    summary->count = total;
+    summary->sum = (double)__atomic_load_n(&histogram->sum_us, __ATOMIC_RELAXED) / 1000.0;
+    summary->max = (double)__atomic_load_n(&histogram->max_us, __ATOMIC_RELAXED) / 1000.0;
+    if (total == 0) return;
+
+    const double quantiles[3] = { 0.5, 0.9, 0.99 };
+    double *out[3] = { &summary->p50, &summary->p90, &summary->p99 };
+    uint64_t seen = 0;
+    int q = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS && q < 3; i++) {
+        seen += counts[i];
+        while (q < 3 && (double)seen >= quantiles[q] * (double)total) {
+            double value = bucket_value(i) / 1000.0;
+            *out[q++] = value < summary->max ? value : summary->max;
+        }
+    }
+}
+
+void metrics_counter_add(metrics_counter_t *counter, uint64_t n) {
+    if (counter) __atomic_fetch_add(&counter->value, n, __ATOMIC_RELAXED);
+}
+
+void metrics_counter_set(metrics_counter_t *counter, uint64_t value) {
+    if (counter) __atomic_store_n(&counter->value, value, __ATOMIC_RELAXED);
+}
+
+void metrics_gauge_set(metrics_gauge_t *gauge, double value) {
+    if (gauge) __atomic_store(&gauge->value, &value, __ATOMIC_RELAXED);
+}
+
+static double gauge_value(const metrics_gauge_t *gauge) {
+    double value;
+    __atomic_load(&gauge->value, &value, __ATOMIC_RELAXED);
+    return value;
+}
+
+/* snprintf that appends and never overruns */
+static void append(char *buf, size_t size, size_t *len, const char *fmt, ...) {
+    if (*len >= size) return;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + *len, size - *len, fmt, args);
+    va_end(args);
+    if (n > 0) *len += (size_t)n;
+    if (*len >= size) *len = size - 1;
+}
+
+static int snapshot(metric_entry_t *entries) {
+    pthread_mutex_lock(&registry_lock);
+    const int n = num_metrics;
+    memcpy(entries, registry, (size_t)n * sizeof(metric_entry_t));
+    pthread_mutex_unlock(&registry_lock);
+    return n;
+}
+
+size_t metrics_format_json(char *buf, size_t size) {
+    if (!buf || size == 0) return 0;
+    buf[0] = '\0';
+
+    metric_entry_t entries[METRICS_MAX];
+    const int n = snapshot(entries);
+
+    size_t len = 0;
+    append(buf, size, &len, "{");
+    for (int i = 0; i < n; i++) {
+        const metric_entry_t *e = &entries[i];
+        append(buf, size, &len, "%s\"%s\":", i > 0 ? "," : "", e->name);
+        if (e->kind == METRIC_HISTOGRAM) {
+            metrics_summary_t s;
+            metrics_histogram_summary(e->metric, &s);
+            append(buf, size, &len, "{\"count\":%llu,\"mean\":%.2f,\"p50\":%.2f,\"p90\":%.2f,\"p99\":%.2f,\"max\":%.2f}",
+                   (unsigned long long)s.count, s.count ? s.sum / (double)s.count : 0.0, s.p50, s.p90, s.p99, s.max);
+        } else if (e->kind == METRIC_COUNTER) {
+            append(buf, size, &len, "%llu",
+                   (unsigned long long)__atomic_load_n(&((metrics_counter_t *)e->metric)->value, __ATOMIC_RELAXED));
+        } else {
+            append(buf, size, &len, "%.3f", gauge_value(e->metric));
+        }
+    }
+    append(buf, size, &len, "}");
+    return len;
+}
+
+size_t metrics_format_prometheus(char *buf, size_t size) {
+    if (!buf || size == 0) return 0;
+    buf[0] = '\0';
+
+    metric_entry_t entries[METRICS_MAX];
+    const int n = snapshot(entries);
+    static const char *kinds[] = { "summary", "counter", "gauge" };
+
+    size_t len = 0;
+    for (int i = 0; i < n; i++) {
+        const metric_entry_t *e = &entries[i];
+        append(buf, size, &len, "# HELP " METRICS_PREFIX "%s %s\n", e->name, e->help);
+        append(buf, size, &len, "# TYPE " METRICS_PREFIX "%s %s\n", e->name, kinds[e->kind]);
+        if (e->kind == METRIC_HISTOGRAM) {
+            metrics_summary_t s;
+            metrics_histogram_summary(e->metric, &s);
+            append(buf, size, &len, METRICS_PREFIX "%s{quantile=\"0.5\"} %.3f\n", e->name, s.p50);
+            append(buf, size, &len, METRICS_PREFIX "%s{quantile=\"0.9\"} %.3f\n", e->name, s.p90);
+            append(buf, size, &len, METRICS_PREFIX "%s{quantile=\"0.99\"} %.3f\n", e->name, s.p99);
+            append(buf, size, &len, METRICS_PREFIX "%s_sum %.3f\n", e->name, s.sum);
+            append(buf, size, &len, METRICS_PREFIX "%s_count %llu\n", e->name, (unsigned long long)s.count);
+        } else if (e->kind == METRIC_COUNTER) {
+            append(buf, size, &len, METRICS_PREFIX "%s %llu\n", e->name,
+                   (unsigned long long)__atomic_load_n(&((metrics_counter_t *)e->metric)->value, __ATOMIC_RELAXED));
+        } else {
+            append(buf, size, &len, METRICS_PREFIX "%s %.3f\n", e->name, gauge_value(e->metric));
+        }
+    }
+    return len;
+}
@@ -0,0 +1,274 @@
+#include "model_memory.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/resource.h>
+#endif
+
+#ifdef PLATFORM_LINUX
+    /* Older kernel headers */
+    #ifndef MADV_HUGEPAGE
+        #define MADV_HUGEPAGE 14
+    #endif
+    #ifndef MADV_COLLAPSE
+        #define MADV_COLLAPSE 25
+    #endif
+#endif
+
+struct model_file {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+};
+
+static char last_error[256] = {0};
+
+model_memory_params_t model_memory_default_params(void) {
+    model_memory_params_t params;
+    params.mmap = true;
+    params.mlock = false;
+    params.huge_pages = MODEL_HUGE_PAGES_OFF;
+    return params;
+}
+
+bool model_memory_parse_huge_pages(const char *name, model_huge_pages_t *mode) {
+    if (!name || !mode) return false;
+
+    if (strcmp(name, "off") == 0) {
+        *mode = MODEL_HUGE_PAGES_OFF;
+    } else if (strcmp(name, "thp") == 0) {
+        *mode = MODEL_HUGE_PAGES_TRANSPARENT;
+    } else if (strcmp(name, "collapse") == 0) {
+        *mode = MODEL_HUGE_PAGES_COLLAPSE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+model_file_t* model_file_open(const char *path) {
+#ifdef _WIN32
+    (void)path;
+    snprintf(last_error, sizeof(last_error), "Memory-mapped loading is not supported on this platform");
+    return NULL;
+#else
+    if (!path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(last_error, sizeof(last_error), "Failed to open %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        snprintf(last_error, sizeof(last_error), "Failed to stat %s", path);
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  /* The mapping keeps the file open */
+    if (data == MAP_FAILED) {
+        snprintf(last_error, sizeof(last_error), "Failed to map %s: %s", path, strerror(errno));
+        return NULL;
+    }
+
+    /* Read the whole file ahead of the parser, in order */
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    posix_madvise(data, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+    model_file_t *file = calloc(1, sizeof(model_file_t));
+    if (!file) {
+        munmap(data, (size_t)st.st_size);
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return file;
+#endif
+}
+
+size_t model_file_read(model_file_t *file, void *out, size_t size) {
+    if (!file || !out) return 0;
+
+    size_t left = file->size - file->offset;
+    if (size > left) size = left;
+    memcpy(out, file->data + file->offset, size);
+    file->offset += size;
+    return size;
+}
+
+bool model_file_eof(const model_file_t *file) {
+    return !file || file->offset >= file->size;
+}
+
+void model_file_close(model_file_t *file) {
+    if (!file) return;
+#ifndef _WIN32
+    munmap((void *)file->data, file->size);
+#endif
+    free(file);
+}
+
+#ifdef PLATFORM_LINUX
+/* Weight regions: large anonymous read-write mappings (ggml's buffers) and
+ * mappings of model files (llama.cpp maps GGUF weights in place) */
+static bool is_weight_mapping(const char *perms, const char *path, size_t size, size_t min_bytes) {
+    if (size < min_bytes || perms[0] != 'r') return false;
+    if (path[0] == '\0') return perms[1] == 'w';
+    return strstr(path, ".gguf") != NULL || strstr(path, ".bin") != NULL;
+}
+
+static bool apply_huge_pages(model_huge_pages_t mode, size_t min_bytes) {
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (!maps) {
+        snprintf(last_error, sizeof(last_error), "Cannot read /proc/self/maps");
+        return false;
+    }
+
+    char line[1024];
+    size_t advised = 0, collapsed = 0, failed = 0;
+    while (fgets(line, sizeof(line), maps)) {
+        unsigned long start, end;
+        char perms[8] = {0};
+        char path[768] = {0};
+        if (sscanf(line, "%lx-%lx %7s %*s %*s %*s %767[^\n]", &start, &end, perms, path) < 3) continue;
+        if (!is_weight_mapping(perms, path, end - start, min_bytes)) continue;
+
+        if (madvise((void *)start, end - start, MADV_HUGEPAGE) != 0) {
+            failed++;
+            continue;
+        }
+        advised += end - start;
+        if (mode == MODEL_HUGE_PAGES_COLLAPSE && madvise((void *)start, end - start, MADV_COLLAPSE) == 0) {
+            collapsed += end - start;
+        }
+    }
+    fclose(maps);
+
+    if (mode == MODEL_HUGE_PAGES_COLLAPSE) {
+        LOG_INFO("[Memory] Huge pages requested for %.0f MB, collapsed %.0f MB\n",
+                 advised / (1024.0 * 1024.0), collapsed / (1024.0 * 1024.0));
+    } else {
+        LOG_INFO("[Memory] Huge pages requested for %.0f MB\n", advised / (1024.0 * 1024.0));
+    }
+
+    if (failed > 0 && advised == 0) {
+        snprintf(last_error, sizeof(last_error), "madvise(MADV_HUGEPAGE) failed: transparent huge pages unavailable?");
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool model_memory_apply(const model_memory_params_t *params, size_t min_bytes) {
+    if (!params) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    bool ok = true;
+    if (params->huge_pages != MODEL_HUGE_PAGES_OFF) {
+#ifdef PLATFORM_LINUX
+        ok = apply_huge_pages(params->huge_pages, min_bytes) && ok;
+#else
+        (void)min_bytes;
+        snprintf(last_error, sizeof(last_error), "Huge pages are only supported on Linux");
+        ok = false;
+#endif
+    }
+
+    if (params->mlock) {
+#if defined(_WIN32) || !defined(MCL_CURRENT)
+        snprintf(last_error, sizeof(last_error), "mlock is not supported on this platform");
+        ok = false;
+#else
+        if (mlockall(MCL_CURRENT) != 0) {
+            snprintf(last_error, sizeof(last_error), "mlockall failed: %s (raise RLIMIT_MEMLOCK, ulimit -l)",
+                     strerror(errno));
+            ok = false;
+        }
+#endif
+    }
+
+    return ok;
+}
+
+#ifdef PLATFORM_LINUX
+/* Sum the kB values of the given smaps_rollup fields */
+static double read_smaps_mb(const char *const *fields, int n_fields) {
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return 0.0;
+
+    char line[256];
+    double kb = 0.0;
+    while (fgets(line, sizeof(line), f)) {
+        for (int i = 0; i < n_fields; i++) {
+            size_t len = strlen(fields[i]);
+            if (strncmp(line, fields[i], len) == 0) {
+                kb += strtod(line + len, NULL);
+            }
+        }
+    }
+    fclose(f);
+    return kb / 1024.0;
+}
+#endif
+
+void model_memory_usage(model_memory_usage_t *usage, bool thread) {
+    if (!usage) return;
+    memset(usage, 0, sizeof(*usage));
+
+#ifndef _WIN32
+    struct rusage ru;
+    int who = RUSAGE_SELF;
+#ifdef RUSAGE_THREAD
+    if (thread) who = RUSAGE_THREAD;
+#else
+    (void)thread;
+#endif
+    if (getrusage(who, &ru) == 0) {
+        usage->minor_faults = (unsigned long)ru.ru_minflt;
+        usage->major_faults = (unsigned long)ru.ru_majflt;
+#ifdef PLATFORM_MACOS
+        usage->rss_mb = (double)ru.ru_maxrss / (1024.0 * 1024.0);  /* Bytes */
+#else
+        usage->rss_mb = (double)ru.ru_maxrss / 1024.0;             /* kB */
+#endif
+    }
+#else
+    (void)thread;
+#endif
+
+#ifdef PLATFORM_LINUX
+    /* Current rather than peak RSS */
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        unsigned long pages_total, pages_resident;
+        if (fscanf(statm, "%lu %lu", &pages_total, &pages_resident) == 2) {
+            usage->rss_mb = (double)pages_resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+        }
+        fclose(statm);
+    }
+
+    static const char *const huge_fields[] = { "AnonHugePages:", "FilePmdMapped:", "ShmemPmdMapped:" };
+    usage->huge_mb = read_smaps_mb(huge_fields, 3);
+#endif
+}
+
+const char* model_memory_get_error(void) {
+    return last_error;
+}
@@ -0,0 +1,378 @@
+#include "sentence_buffer.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
+
+/* Previous fragment kept for overlap matching */
+#define SENTENCE_PREV_MAX 512
+#define SENTENCE_PREV_WORDS (SENTENCE_PREV_MAX / 2)
+
+/* A word of a fragment: a run of non-space bytes */
+typedef struct {
+    const char *start;
+    size_t len;
+} word_t;
+
+struct sentence_buffer {
+    sentence_buffer_params_t params;
+    sentence_buffer_callback_t callback;
+    void *user_data;
+    pthread_mutex_t lock;
+
+    /* Text waiting for the end of its sentence */
+    char pending[SENTENCE_BUFFER_MAX_TEXT];
+    size_t pending_len;
+    bool tentative;               /* Pending text ends with a terminator nothing has followed yet */
+    whisper_timing_t first;       /* Fragment the pending text starts in */
+    whisper_timing_t last;        /* Latest fragment in the pending text */
+    uint64_t first_id;            /* Their ids */
+    uint64_t last_id;
+    uint64_t pending_since_ns;    /* When the oldest pending words arrived */
+    uint64_t last_push_ns;        /* When the latest fragment arrived */
+    uint64_t last_audio_end_ns;   /* Capture time of the latest fragment's last sample */
+
+    char prev[SENTENCE_PREV_MAX]; /* Previous fragment, "" after a pause */
+
+    /* Statistics */
+    unsigned long fragments;
+    unsigned long sentences;
+    unsigned long repeated_words;
+    metrics_counter_t *fragment_metric;
+    metrics_counter_t *sentence_metric;
+    metrics_counter_t *repeated_metric;
+};
+
+static char last_error[256] = {0};
+
+sentence_buffer_params_t sentence_buffer_default_params(void) {
+    sentence_buffer_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.pause_ms = 800;
+    params.idle_ms = 3500;       /* Above the default 2 s between fragments, with room for jitter */
+    params.max_latency_ms = 5000;
+    params.max_overlap_words = 8;
+    return params;
+}
+
+/* Split text into words at whitespace; returns the count (at most max) */
+static size_t split_words(const char *text, word_t *words, size_t max) {
+    size_t n = 0;
+    const char *p = text;
+    while (n < max) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        words[n].start = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        words[n].len = (size_t)(p - words[n].start);
+        n++;
+    }
+    return n;
+}
+
+/* Words are equal ignoring ASCII case and punctuation ("Store." matches "store") */
+static bool same_word(const word_t *a, const word_t *b) {
+    size_t i = 0, j = 0;
+    while (true) {
+        while (i < a->len && ispunct((unsigned char)a->start[i])) i++;
+        while (j < b->len && ispunct((unsigned char)b->start[j])) j++;
+        if (i == a->len || j == b->len) return i == a->len && j == b->len;
+        if (tolower((unsigned char)a->start[i]) != tolower((unsigned char)b->start[j])) return false;
+        i++;
+        j++;
+    }
+}
+
+/* Letters and digits in a word (every byte of a multi-byte character counts) */
+static size_t word_letters(const word_t *word) {
+    size_t n = 0;
+    for (size_t i = 0; i < word->len; i++) {
+        const unsigned char c = (unsigned char)word->start[i];
+        if (isalnum(c) || c >= 0x80) n++;
+    }
+    return n;
+}
+
+/* Number of leading words of text that repeat the end of the previous
+ * fragment (the audio both chunks covered); rest receives the text after them */
+static size_t find_overlap(const sentence_buffer_t *buffer, const char *text, const char **rest) {
+    word_t prev[SENTENCE_PREV_WORDS];
+    word_t next[SENTENCE_BUFFER_MAX_OVERLAP + 1];
+    *rest = text;
+
+    const size_t n_prev = split_words(buffer->prev, prev, SENTENCE_PREV_WORDS);
+    const size_t n_next = split_words(text, next, SENTENCE_BUFFER_MAX_OVERLAP + 1);
+    size_t max = (size_t)buffer->params.max_overlap_words;
+    if (max > n_prev) max = n_prev;
+    if (max > n_next) max = n_next;
+
+    /* Longest match first; a single repeated word only counts if it is not
+     * a short one a speaker could well say twice ("the the", "I ... I") */
+    for (size_t k = max; k > 0; k--) {
+        bool match = true;
+        for (size_t i = 0; i < k && match; i++) {
+            match = same_word(&prev[n_prev - k + i], &next[i]);
+        }
+        if (match && (k > 1 || word_letters(&next[0]) >= 4)) {
+            const char *p = next[k - 1].start + next[k - 1].len;
+            while (isspace((unsigned char)*p)) p++;
+            *rest = p;
+            return k;
+        }
+    }
+    return 0;
+}
+
+/* A fragment that is only a non-speech marker, e.g. "[BLANK_AUDIO]" or "(music)" */
+static bool is_non_speech(const char *text, size_t len) {
+    if (len < 2) return false;
+    return (text[0] == '[' && text[len - 1] == ']') || (text[0] == '(' && text[len - 1] == ')');
+}
+
+/* Length of the sentence terminator at p, 0 if none; cjk is set for full-width
+ * ones, which need no space after them */
+static size_t terminator_len(const char *p, bool *cjk) {
+    *cjk = false;
+    if (*p == '.' || *p == '!' || *p == '?') return 1;
+    if (strncmp(p, "\xE2\x80\xA6", 3) == 0) return 3;  /* … */
+    if (strncmp(p, "\xE3\x80\x82", 3) == 0 ||           /* 。 */
+        strncmp(p, "\xEF\xBC\x81", 3) == 0 ||           /* ！ */
+        strncmp(p, "\xEF\xBC\x9F", 3) == 0) {           /* ？ */
+        *cjk = true;
+        return 3;
+    }
+    return 0;
+}
+
+/* A full stop after an initial ("J. Smith"), a title ("Dr. Smith") or a
+ * dotted abbreviation ("e.g.") that does not end the sentence */
+static bool is_abbreviation(const char *text, size_t dot) {
+    static const char *titles[] = { "Mr", "Mrs", "Ms", "Dr", "Prof", "St", "Jr", "Sr", "vs" };
+
+    size_t start = dot;
+    while (start > 0 && !isspace((unsigned char)text[start - 1])) start--;
+    const size_t len = dot - start;
+    if (len == 1 && isalpha((unsigned char)text[start])) return true;
+    if (memchr(text + start, '.', len)) return true;
+    for (size_t i = 0; i < sizeof(titles) / sizeof(titles[0]); i++) {
+        if (strlen(titles[i]) == len && strncmp(text + start, titles[i], len) == 0) return true;
+    }
+    return false;
+}
+
+/* End of the last sentence in the pending text that something has followed
+ * (just past its terminator and closing quotes), 0 if none; sets tentative
+ * when the text ends with a terminator (buffer->lock held) */
+static size_t find_sentence_end(sentence_buffer_t *buffer) {
+    const char *text = buffer->pending;
+    size_t end = 0;
+    buffer->tentative = false;
+
+    for (size_t i = 0; i < buffer->pending_len;) {
+        bool cjk;
+        const size_t n = terminator_len(text + i, &cjk);
+        if (n == 0 || (text[i] == '.' && is_abbreviation(text, i))) {
+            i++;
+            continue;
+        }
+
+        size_t j = i + n;
+        while (text[j] == '"' || text[j] == '\'' || text[j] == ')' || text[j] == ']') j++;
+        if (j >= buffer->pending_len) {
+            buffer->tentative = true;
+        } else if (cjk || isspace((unsigned char)text[j])) {
+            end = j;
+        }
+        i = j;
+    }
+    return end;
+}
+
+/* Last clause boundary (",", ";" or ":" before a space) in the second half
+ * of the pending text, else the whole text (buffer->lock held) */
+static size_t find_clause_end(const sentence_buffer_t *buffer) {
+    for (size_t i = buffer->pending_len - 1; i > buffer->pending_len / 2; i--) {
+        const char c = buffer->pending[i - 1];
+        if ((c == ',' || c == ';' || c == ':') && isspace((unsigned char)buffer->pending[i])) {
+            return i;
+        }
+    }
+    return buffer->pending_len;
+}
+
+/* Hand pending[0, end) to the callback and keep the rest (buffer->lock held) */
+static void commit(sentence_buffer_t *buffer, size_t end, const char *reason) {
+    char *text = buffer->pending;
+
+    whisper_timing_t timing = buffer->last;
+    timing.audio_start_ns = buffer->first.audio_start_ns;
+
+    /* Terminate in place for the callback */
+    const char saved = text[end];
+    text[end] = '\0';
+    LOG_DEBUG("[Sentence] %s: %s\n", reason, text);
+    if (buffer->callback) {
+        buffer->callback(text, &timing, buffer->first_id, buffer->last_id, buffer->user_data);
+    }
+    text[end] = saved;
+    buffer->sentences++;
+    metrics_counter_add(buffer->sentence_metric, 1);
+
+    /* The rest starts a new sentence, in the latest fragment */
+    size_t rest = end;
+    while (rest < buffer->pending_len && isspace((unsigned char)text[rest])) rest++;
+    memmove(text, text + rest, buffer->pending_len - rest + 1);
+    buffer->pending_len -= rest;
+    if (buffer->pending_len == 0) {
+        buffer->tentative = false;
+    } else {
+        buffer->first = buffer->last;
+        buffer->first_id = buffer->last_id;
+        buffer->pending_since_ns = buffer->last_push_ns;
+    }
+}
+
+sentence_buffer_t* sentence_buffer_create(const sentence_buffer_params_t *params,
+                                          sentence_buffer_callback_t callback, void *user_data) {
+    sentence_buffer_t *buffer = calloc(1, sizeof(sentence_buffer_t));
+    if (!buffer) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+
+    buffer->params = params ? *params : sentence_buffer_default_params();
+    if (buffer->params.max_overlap_words < 0) buffer->params.max_overlap_words = 0;
+    if (buffer->params.max_overlap_words > SENTENCE_BUFFER_MAX_OVERLAP) {
+        buffer->params.max_overlap_words = SENTENCE_BUFFER_MAX_OVERLAP;
+    }
+    buffer->callback = callback;
+    buffer->user_data = user_data;
+    buffer->fragment_metric = metrics_counter("sentence_fragments_total", "Transcribed fragments given to the sentence buffer");
+    buffer->sentence_metric = metrics_counter("sentences_total", "Sentences committed for translation");
+    buffer->repeated_metric = metrics_counter("sentence_repeated_words_total",
+                                              "Words dropped because the chunk overlap repeated them");
+    pthread_mutex_init(&buffer->lock, NULL);
+    return buffer;
+}
+
+void sentence_buffer_push(sentence_buffer_t *buffer, const char *text, const whisper_timing_t *timing, uint64_t id) {
+    if (!buffer || !text) return;
+    const uint64_t now = trace_now_ns();
+
+    while (isspace((unsigned char)*text)) text++;
+    size_t len = strlen(text);
+    while (len > 0 && isspace((unsigned char)text[len - 1])) len--;
+
+    pthread_mutex_lock(&buffer->lock);
+    buffer->fragments++;
+    metrics_counter_add(buffer->fragment_metric, 1);
+
+    /* A gap in the audio is a pause, or chunks dropped under load: either
+     * way the sentence has ended and this fragment shares no overlap */
+    const uint64_t pause_ns = (uint64_t)buffer->params.pause_ms * 1000000ull;
+    if (timing && buffer->last_audio_end_ns && timing->audio_start_ns > buffer->last_audio_end_ns + pause_ns) {
+        if (buffer->pending_len > 0) commit(buffer, buffer->pending_len, "pause");
+        buffer->prev[0] = '\0';
+    }
+    if (timing) buffer->last_audio_end_ns = timing->audio_end_ns;
+    buffer->last_push_ns = now;
+
+    if (is_non_speech(text, len)) {
+        if (buffer->pending_len > 0) commit(buffer, buffer->pending_len, "pause");
+        buffer->prev[0] = '\0';
+        pthread_mutex_unlock(&buffer->lock);
+        return;
+    }
+
+    /* Drop the words the previous fragment already ended with */
+    const char *rest;
+    const size_t repeated = find_overlap(buffer, text, &rest);
+    if (repeated > 0) {
+        buffer->repeated_words += repeated;
+        metrics_counter_add(buffer->repeated_metric, repeated);
+    }
+    len -= (size_t)(rest - text);
+    snprintf(buffer->prev, sizeof(buffer->prev), "%.*s", (int)(rest - text + len), text);
+    if (len == 0) {
+        pthread_mutex_unlock(&buffer->lock);
+        return;
+    }
+
+    /* Whisper closes a sentence wherever a chunk ends; a full stop the next
+     * fragment carries on from in lowercase was only the chunk edge */
+    if (buffer->tentative && islower((unsigned char)rest[0]) && buffer->pending_len > 1 &&
+        buffer->pending[buffer->pending_len - 1] == '.' && buffer->pending[buffer->pending_len - 2] != '.') {
+        buffer->pending[--buffer->pending_len] = '\0';
+    }
+
+    if (buffer->pending_len > 0 && buffer->pending_len + 1 + len >= SENTENCE_BUFFER_MAX_TEXT) {
+        commit(buffer, buffer->pending_len, "full");
+    }
+    if (buffer->pending_len == 0) {
+        if (timing) {
+            buffer->first = *timing;
+        } else {
+            memset(&buffer->first, 0, sizeof(buffer->first));
+        }
+        buffer->first_id = id;
+        buffer->pending_since_ns = now;
+    } else {
+        buffer->pending[buffer->pending_len++] = ' ';
+    }
+    if (timing) buffer->last = *timing;
+    buffer->last_id = id;
+
+    if (len > SENTENCE_BUFFER_MAX_TEXT - 1 - buffer->pending_len) {
+        len = SENTENCE_BUFFER_MAX_TEXT - 1 - buffer->pending_len;
+    }
+    memcpy(buffer->pending + buffer->pending_len, rest, len);
+    buffer->pending_len += len;
+    buffer->pending[buffer->pending_len] = '\0';
+
+    const size_t end = find_sentence_end(buffer);
+    if (end > 0) commit(buffer, end, "sentence");
+    pthread_mutex_unlock(&buffer->lock);
+}
+
+void sentence_buffer_poll(sentence_buffer_t *buffer, uint64_t now_ns) {
+    if (!buffer) return;
+
+    pthread_mutex_lock(&buffer->lock);
+    if (buffer->pending_len > 0) {
+        const uint64_t idle_ns = (uint64_t)buffer->params.idle_ms * 1000000ull;
+        const uint64_t latency_ns = (uint64_t)buffer->params.max_latency_ms * 1000000ull;
+        if (now_ns > buffer->last_push_ns && now_ns - buffer->last_push_ns >= idle_ns) {
+            commit(buffer, buffer->pending_len, "idle");
+        } else if (now_ns > buffer->pending_since_ns && now_ns - buffer->pending_since_ns >= latency_ns) {
+            commit(buffer, find_clause_end(buffer), "latency");
+        }
+    }
+    pthread_mutex_unlock(&buffer->lock);
+}
+
+void sentence_buffer_flush(sentence_buffer_t *buffer) {
+    if (!buffer) return;
+
+    pthread_mutex_lock(&buffer->lock);
+    if (buffer->pending_len > 0) {
+        commit(buffer, buffer->pending_len, "flush");
+    }
+    pthread_mutex_unlock(&buffer->lock);
+}
+
+void sentence_buffer_destroy(sentence_buffer_t *buffer) {
+    if (!buffer) return;
+
+    LOG_INFO("[Sentence] %lu fragments → %lu sentences, %lu repeated words dropped\n",
+            buffer->fragments, buffer->sentences, buffer->repeated_words);
+    pthread_mutex_destroy(&buffer->lock);
+    free(buffer);
+}
+
+const char* sentence_buffer_get_error(void) {
+    return last_error;
+}
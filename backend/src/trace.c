@@ -0,0 +1,186 @@
+#include "trace.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Events kept per trace (about 48 bytes each); later ones are dropped */
+#define TRACE_MAX_EVENTS (1 << 18)
+#define TRACE_MAX_THREADS 64
+#define TRACE_THREAD_NAME 32
+#define TRACE_MAX_PATH 512
+
+typedef struct {
+    const char *name;
+    const char *category;
+    uint64_t ts;                /* ns */
+    uint64_t dur;               /* ns, spans only */
+    uint64_t id;
+    uint32_t tid;
+    char phase;                 /* 'X' span, 'i' instant */
+    char committed;             /* Written last, so a half-filled event is skipped */
+} trace_event_t;
+
+int trace_active = 0;
+
+static trace_event_t *events = NULL;
+static size_t next_event = 0;
+static unsigned long dropped = 0;
+static uint64_t next_id = 0;
+static uint64_t t_origin = 0;
+static char trace_path[TRACE_MAX_PATH];
+
+static pthread_mutex_t names_lock = PTHREAD_MUTEX_INITIALIZER;
+static char thread_names[TRACE_MAX_THREADS][TRACE_THREAD_NAME];
+static uint32_t next_tid = 0;
+
+static _Thread_local uint32_t thread_tid = 0;
+static _Thread_local uint64_t thread_context = 0;
+
+uint64_t trace_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t current_tid(void) {
+    if (thread_tid == 0) {
+        thread_tid = __atomic_add_fetch(&next_tid, 1, __ATOMIC_RELAXED);
+    }
+    return thread_tid;
+}
+
+bool trace_start(const char *path) {
+    if (trace_active || !path) return false;
+
+    /* Kept after trace_stop(): a thread may still be finishing an event */
+    if (events) {
+        memset(events, 0, TRACE_MAX_EVENTS * sizeof(trace_event_t));
+    } else {
+        events = calloc(TRACE_MAX_EVENTS, sizeof(trace_event_t));
+    }
+    if (!events) {
+        LOG_ERROR("[Trace] Cannot allocate the event buffer\n");
+        return false;
+    }
+    snprintf(trace_path, sizeof(trace_path), "%s", path);
+    next_event = 0;
+    dropped = 0;
+    t_origin = trace_now_ns();
+
+    __atomic_store_n(&trace_active, 1, __ATOMIC_RELEASE);
+    LOG_INFO("[Trace] Recording to %s\n", trace_path);
+    return true;
+}
+
+/* Write a JSON string body (names are ours, but thread names come from device labels) */
+static void write_json_string(FILE *f, const char *s) {
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) fputc(*s, f);
+    }
+}
+
+bool trace_stop(void) {
+    if (!__atomic_exchange_n(&trace_active, 0, __ATOMIC_ACQ_REL)) return false;
+
+    FILE *f = fopen(trace_path, "w");
+    if (!f) {
+        LOG_ERROR("[Trace] Cannot write %s\n", trace_path);
+        return false;
+    }
+
+    size_t count = __atomic_load_n(&next_event, __ATOMIC_ACQUIRE);
+    if (count > TRACE_MAX_EVENTS) count = TRACE_MAX_EVENTS;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"visualia\"}}");
+
+    pthread_mutex_lock(&names_lock);
+    for (uint32_t tid = 1; tid <= next_tid && tid <= TRACE_MAX_THREADS; tid++) {
+        if (thread_names[tid - 1][0] == '\0') continue;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", tid);
+        write_json_string(f, thread_names[tid - 1]);
+        fprintf(f, "\"}}");
+    }
+    pthread_mutex_unlock(&names_lock);
+
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        const trace_event_t *e = &events[i];
+        if (!__atomic_load_n(&e->committed, __ATOMIC_ACQUIRE)) continue;
+
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f",
+                e->name, e->category, e->phase, e->tid, (double)(e->ts - t_origin) / 1000.0);
+        if (e->phase == 'X') {
+            fprintf(f, ",\"dur\":%.3f", (double)e->dur / 1000.0);
+        } else {
+            fprintf(f, ",\"s\":\"t\"");
+        }
+        if (e->id != 0) {
+            fprintf(f, ",\"args\":{\"id\":%llu}", (unsigned long long)e->id);
+        }
+        fprintf(f, "}");
+        written++;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    if (dropped > 0) {
+        LOG_WARN("[Trace] Wrote %zu events to %s (%lu dropped: buffer full)\n", written, trace_path, dropped);
+    } else {
+        LOG_INFO("[Trace] Wrote %zu events to %s\n", written, trace_path);
+    }
+    return true;
+}
+
+static void record(char phase, const char *name, const char *category, uint64_t ts, uint64_t dur, uint64_t id) {
+    const size_t slot = __atomic_fetch_add(&next_event, 1, __ATOMIC_RELAXED);
+    if (slot >= TRACE_MAX_EVENTS) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    trace_event_t *e = &events[slot];
+    e->name = name;
+    e->category = category;
+    e->ts = ts;
+    e->dur = dur;
+    e->id = id;
+    e->tid = current_tid();
+    e->phase = phase;
+    __atomic_store_n(&e->committed, 1, __ATOMIC_RELEASE);
+}
+
+void trace_end(const char *name, const char *category, uint64_t start, uint64_t id) {
+    if (start == 0 || !__atomic_load_n(&trace_active, __ATOMIC_ACQUIRE)) return;
+    record('X', name, category, start, trace_now_ns() - start, id);
+}
+
+void trace_instant(const char *name, const char *category, uint64_t id) {
+    if (!__atomic_load_n(&trace_active, __ATOMIC_ACQUIRE)) return;
+    record('i', name, category, trace_now_ns(), 0, id);
+}
+
+void trace_thread_name(const char *name) {
+    const uint32_t tid = current_tid();
+    if (tid > TRACE_MAX_THREADS) return;
+
+    pthread_mutex_lock(&names_lock);
+    snprintf(thread_names[tid - 1], TRACE_THREAD_NAME, "%s", name);
+    pthread_mutex_unlock(&names_lock);
+}
+
+uint64_t trace_new_id(void) {
+    return __atomic_add_fetch(&next_id, 1, __ATOMIC_RELAXED);
+}
+
+void trace_set_context(uint64_t id) {
+    thread_context = id;
+}
+
+uint64_t trace_context(void) {
+    return thread_context;
+}
@@ -1,13 +1,17 @@
 #include "translation_engine.h"
+#include "cpu_budget.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
 #include "llama.h"
 #include <string>
 #include <vector>
 #include <cstring>
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <utility>
+#include <algorithm>
 #include <condition_variable>
-#include <iostream>
 #include <chrono>
 
 /**
@@ -15,39 +19,184 @@
  *
  * T5 is a text-to-text model that frames all NLP tasks as text generation.
  * For translation: Input format is "translate English to French: <text>"
+ *
+ * Models without an encoder are run as instruction-tuned chat models instead,
+ * through the chat template in their metadata. The system prompt and the
+ * start of the user turn are the same for every request: they are decoded
+ * once at load time into a sequence of their own, and each request copies
+ * that sequence's KV cells instead of decoding the prefix again.
+ *
+ * With context on (translation_params_t), a target's previous sentences stay
+ * in its sequence as earlier chat turns: a request only decodes its own turn
+ * and reply, and the oldest turns are cut out of the cache to stay within
+ * the budget. A T5 encoder reads its whole input at once, so its output can't
+ * be extended: there the previous sentences are encoded again with the new
+ * one and their translations are prefilled into the decoder in one call.
  */
 
+// Smallest mapping model_memory_apply treats as weights
+static const size_t TRANSLATION_WEIGHTS_MIN_BYTES = (size_t)16 << 20;
+
+// Most prompt tokens a request can have, all targets together, and the
+// decoder context each target's sequence gets
+static const int TRANSLATION_N_CTX = 512;
+
+// Generated tokens per target
+static const int TRANSLATION_MAX_TOKENS = 256;
+
+// Decoder-only models: the sequence holding the resident prompt prefix,
+// after the targets' sequences
+static const llama_seq_id TRANSLATION_PREFIX_SEQ = TRANSLATION_MAX_TARGETS;
+
+// Instructions for decoder-only models; the languages and the text follow
+// in the user turn (see build_chat_prompt)
+static const char *TRANSLATION_SYSTEM_PROMPT =
+    "You translate live speech captions. Each message starts with a line naming the languages, "
+    "like \"English to French:\" or just \"French:\" when the source language is unknown, followed by "
+    "the text. Reply with the translation of the text only, without notes, quotes or explanations.";
+
+// Stand in for the user's text and the model's reply while the chat template
+// is split into the resident prefix, the per-request suffix and the text
+// between a reply and the next user turn
+static const char *TRANSLATION_TEXT_MARKER = "<<<VISUALIA_TEXT>>>";
+static const char *TRANSLATION_REPLY_MARKER = "<<<VISUALIA_REPLY>>>";
+
+// Capacity reserved up front for each request's text and for the prompt and
+// result; longer ones grow a buffer once and keep it
+static const size_t TRANSLATION_TEXT_RESERVE = 1024;
+static const size_t TRANSLATION_RESULT_RESERVE = 2048;
+
 struct translation_request {
     std::string text;
     std::string source_lang;
-    std::string target_lang;
+    std::string target_langs[TRANSLATION_MAX_TARGETS];
+    size_t num_targets;
     void *user_data;  // Per-request user data for callback
+    bool warm_up;     // Internal request from translation_warm_up(), no callback
+    uint64_t trace_id;      // Chunk id of the transcription it came from, for trace spans
+    uint64_t trace_queued;  // trace_begin() when queued
+    translation_timing_t timing;
+
+    translation_request()
+        : num_targets(0), user_data(nullptr), warm_up(false), trace_id(0), trace_queued(0), timing() {
+        text.reserve(TRANSLATION_TEXT_RESERVE);
+        source_lang.reserve(8);
+        for (std::string &target_lang : target_langs) {
+            target_lang.reserve(8);
+        }
+    }
+};
+
+// Turns a target holds: the window, plus the newest sentence until the
+// next request trims it
+static const size_t TRANSLATION_CONTEXT_RING = TRANSLATION_MAX_CONTEXT + 1;
+
+// One translated sentence kept as context for the sentences after it
+struct context_turn {
+    std::string source;  // Source text (T5 encodes it again)
+    std::string target;  // Its translation (T5 prefills it into the decoder)
+    int n_tokens;        // Context budget it takes
+    int n_sep;           // Decoder-only: chat separator tokens it starts with (0 right after the prefix)
+    llama_pos start;     // Decoder-only: first of its cells in the target's sequence
+
+    context_turn() : n_tokens(0), n_sep(0), start(0) {
+        source.reserve(TRANSLATION_TEXT_RESERVE);
+        target.reserve(TRANSLATION_TEXT_RESERVE);
+    }
+};
+
+// A target sequence's context: the languages it is in and its latest turns
+struct target_context {
+    std::string source_lang;
+    std::string target_lang;                      // Empty: the sequence starts over
+    context_turn turns[TRANSLATION_CONTEXT_RING];  // Ring, oldest at first
+    size_t first;
+    size_t count;
+    int n_tokens;
+    llama_pos end;  // Decoder-only: end of the sequence's cells (prefix + turns)
+
+    target_context() : first(0), count(0), n_tokens(0), end(0) {
+        source_lang.reserve(8);
+        target_lang.reserve(8);
+    }
 };
 
 struct translation_engine_t {
     // llama.cpp context
     llama_model *model;
     llama_context *ctx;
+    int n_threads;  // Threads asked of the CPU budget per call
+
+    // Decoder-only chat model (no encoder in the model metadata): the prompt
+    // prefix stays decoded in TRANSLATION_PREFIX_SEQ
+    bool decoder_only;
+    int n_prefix;                // Tokens of the resident prefix
+    std::string chat_suffix;     // Template text between the user's text and the reply
+    std::vector<llama_token> chat_separator;  // Template tokens between a reply and the next user turn
+
+    // Context window (see translation_params_t), one per target sequence
+    int context_sentences;
+    int context_tokens;
+    bool can_shift;  // Decoder-only: cells can move down once older turns are cut out
+    target_context contexts[TRANSLATION_MAX_TARGETS];
 
     // Callback
     translation_callback_t callback;
     void *user_data;
 
-    // Thread-safe queue
-    std::queue<translation_request> request_queue;
+    // Thread-safe ring of preallocated requests; the worker swaps the head
+    // with its own request, so buffers move instead of being copied
+    std::vector<translation_request> slots;
+    size_t queue_head;
+    size_t queue_count;
     std::mutex queue_mutex;
     std::condition_variable queue_cv;
     std::thread worker_thread;
     bool shutdown;
 
+    // Warm-up handshake (see translation_warm_up)
+    std::condition_variable warm_up_cv;
+    bool warming;
+
+    // Worker scratch, sized once: the batch holds every target's prompt for
+    // the encoder, then one token per unfinished target for the decoder
+    translation_request current;
+    std::string prompt;
+    llama_batch batch;
+    std::string results[TRANSLATION_MAX_TARGETS];
+    std::string context_text;                             // T5: previous translations, joined
+    std::vector<llama_token> forced[TRANSLATION_MAX_TARGETS];  // T5: their tokens
+
+    // Metrics (see metrics.h)
+    metrics_histogram_t *latency_metric;
+    metrics_histogram_t *token_metric;
+    metrics_gauge_t *depth_metric;
+
     translation_engine_t()
-        : model(nullptr), ctx(nullptr),
+        : model(nullptr), ctx(nullptr), n_threads(1),
+          decoder_only(false), n_prefix(0),
+          context_sentences(0), context_tokens(0), can_shift(false),
           callback(nullptr), user_data(nullptr),
-          shutdown(false) {}
+          slots(TRANSLATION_MAX_PENDING), queue_head(0), queue_count(0),
+          shutdown(false), warming(false),
+          batch(),
+          latency_metric(metrics_histogram("transcript_to_translation_ms",
+                                           "Transcript queued for translation to its translation delivered")),
+          token_metric(metrics_histogram("translation_token_ms", "One decoder step of the translation model")),
+          depth_metric(metrics_gauge("translation_queue_depth", "Transcripts waiting for the translation worker")) {
+        prompt.reserve(TRANSLATION_TEXT_RESERVE + 64);
+        for (std::string &result : results) {
+            result.reserve(TRANSLATION_RESULT_RESERVE);
+        }
+        context_text.reserve(TRANSLATION_RESULT_RESERVE);
+        for (std::vector<llama_token> &tokens : forced) {
+            tokens.resize(TRANSLATION_N_CTX);
+        }
+    }
 };
 
 // Language code to language name mapping for T5 prompts
-static std::string get_language_name(const char *lang_code) {
+static const char* get_language_name(const char *lang_code) {
     if (strcmp(lang_code, "en") == 0) return "English";
     if (strcmp(lang_code, "fr") == 0) return "French";
     if (strcmp(lang_code, "es") == 0) return "Spanish";
@@ -66,171 +215,657 @@ static std::string get_language_name(const char *lang_code) {
     return "English";  // Default
 }
 
-// Build T5 translation prompt
-static std::string build_t5_prompt(const char *text, const char *source_lang, const char *target_lang) {
-    std::string source_name = get_language_name(source_lang);
-    std::string target_name = get_language_name(target_lang);
-
+// Build T5 translation prompt into prompt (its capacity is reused), the
+// context's sentences before the text
+static void build_t5_prompt(std::string &prompt, const std::string &text, const std::string &source_lang,
+                            const std::string &target_lang, const target_context &context) {
     // T5 format: "translate English to French: <text>"
-    return "translate " + source_name + " to " + target_name + ": " + std::string(text);
+    prompt.clear();
+    prompt.append("translate ");
+    prompt.append(get_language_name(source_lang.c_str()));
+    prompt.append(" to ");
+    prompt.append(get_language_name(target_lang.c_str()));
+    prompt.append(": ");
+    for (size_t i = 0; i < context.count; i++) {
+        prompt.append(context.turns[(context.first + i) % TRANSLATION_CONTEXT_RING].source);
+        prompt.append(" ");
+    }
+    prompt.append(text);
 }
 
-// Worker thread that processes translation requests
-static void translation_worker(translation_engine_t *engine) {
-    while (true) {
-        translation_request req;
+// The context's translations, joined like their sources in the T5 prompt
+static void build_t5_context(std::string &out, const target_context &context) {
+    out.clear();
+    for (size_t i = 0; i < context.count; i++) {
+        out.append(context.turns[(context.first + i) % TRANSLATION_CONTEXT_RING].target);
+        out.append(" ");
+    }
+}
 
-        {
-            std::unique_lock<std::mutex> lock(engine->queue_mutex);
-            engine->queue_cv.wait(lock, [engine] {
-                return !engine->request_queue.empty() || engine->shutdown;
-            });
+// Build a decoder-only model's user turn for one target: the languages,
+// the text, and the template up to the start of the reply
+static void build_chat_prompt(std::string &prompt, const std::string &text, const std::string &source_lang,
+                              const std::string &target_lang, const std::string &chat_suffix) {
+    prompt.clear();
+    if (source_lang != "auto") {
+        prompt.append(get_language_name(source_lang.c_str()));
+        prompt.append(" to ");
+    }
+    prompt.append(get_language_name(target_lang.c_str()));
+    prompt.append(":\n");
+    prompt.append(text);
+    prompt.append(chat_suffix);
+}
 
-            if (engine->shutdown && engine->request_queue.empty()) {
-                break;
-            }
+// Start target t's context over; decoder-only models go back to a copy of
+// the resident prefix
+static void context_reset(translation_engine_t *engine, size_t t) {
+    target_context &context = engine->contexts[t];
+    context.first = 0;
+    context.count = 0;
+    context.n_tokens = 0;
+    context.end = engine->n_prefix;
 
-            req = engine->request_queue.front();
-            engine->request_queue.pop();
+    if (engine->decoder_only) {
+        llama_memory_t mem = llama_get_memory(engine->ctx);
+        llama_memory_seq_rm(mem, (llama_seq_id)t, -1, -1);
+        llama_memory_seq_cp(mem, TRANSLATION_PREFIX_SEQ, (llama_seq_id)t, -1, -1);
+    }
+}
+
+// Drop target t's oldest turn; decoder-only models cut its cells out and
+// move the later ones down, or start over if the cache can't shift
+static void context_evict(translation_engine_t *engine, size_t t) {
+    target_context &context = engine->contexts[t];
+    const context_turn &oldest = context.turns[context.first];
+    int n_cut = oldest.n_tokens;
+
+    if (engine->decoder_only) {
+        if (!engine->can_shift) {
+            context_reset(engine, t);
+            return;
         }
 
-        // Build T5 prompt
-        auto start_time = std::chrono::steady_clock::now();
-        std::string prompt = build_t5_prompt(req.text.c_str(),
-                                             req.source_lang.c_str(),
-                                             req.target_lang.c_str());
+        // The prefix ends with a user turn's opening, so the next turn's
+        // separator (end of the reply, opening of the user turn) goes too
+        if (context.count > 1) {
+            context_turn &next = context.turns[(context.first + 1) % TRANSLATION_CONTEXT_RING];
+            n_cut += next.n_sep;
+            next.n_tokens -= next.n_sep;
+            next.n_sep = 0;
+            next.start = oldest.start + n_cut;  // Moved down by n_cut below
+        }
 
-        std::cerr << "[Translation] [START] Prompt: " << prompt << std::endl;
+        llama_memory_t mem = llama_get_memory(engine->ctx);
+        const llama_pos end = oldest.start + n_cut;
+        llama_memory_seq_rm(mem, (llama_seq_id)t, oldest.start, end);
+        llama_memory_seq_add(mem, (llama_seq_id)t, end, -1, -n_cut);
+        for (size_t i = 1; i < context.count; i++) {
+            context.turns[(context.first + i) % TRANSLATION_CONTEXT_RING].start -= n_cut;
+        }
+        context.end -= n_cut;
+    }
 
-        // Tokenize
-        std::cerr << "[Translation] [TOKENIZE] Starting tokenization..." << std::endl;
-        std::vector<llama_token> tokens;
-        tokens.resize(prompt.size() + 128);  // Extra space
+    context.n_tokens -= n_cut;
+    context.first = (context.first + 1) % TRANSLATION_CONTEXT_RING;
+    context.count--;
+}
 
-        // Get vocab from model
-        const struct llama_vocab * vocab = llama_model_get_vocab(engine->model);
+// Ready target t's sequence for a request: with context on and the same
+// languages it keeps its turns, less the oldest beyond the window and the
+// budget; otherwise it starts over
+static void context_prepare(translation_engine_t *engine, size_t t, const std::string &source_lang,
+                            const std::string &target_lang) {
+    target_context &context = engine->contexts[t];
+    if (engine->context_sentences == 0 || context.source_lang != source_lang || context.target_lang != target_lang) {
+        context_reset(engine, t);
+        context.source_lang.assign(source_lang);
+        context.target_lang.assign(target_lang);
+        return;
+    }
 
-        int n_tokens = llama_tokenize(
-            vocab,
-            prompt.c_str(),
-            prompt.size(),
-            tokens.data(),
-            tokens.size(),
-            true,  // add_special (BOS token)
-            false  // parse_special
-        );
+    while (context.count > 0 &&
+           (context.count > (size_t)engine->context_sentences || context.n_tokens > engine->context_tokens)) {
+        context_evict(engine, t);
+    }
+}
 
-        if (n_tokens < 0) {
-            std::cerr << "[Translation] [ERROR] Tokenization failed" << std::endl;
-            if (engine->callback) {
-                engine->callback("[Translation Error]", engine->user_data);
-            }
-            continue;
+// Keep a finished sentence as target t's newest turn; for decoder-only
+// models its cells run from the end of the context for n_tokens, starting
+// with the separator when it follows an earlier turn (see start_chat)
+static void context_add(translation_engine_t *engine, size_t t, const std::string &source,
+                        const std::string &target, int n_tokens) {
+    target_context &context = engine->contexts[t];
+    context_turn &turn = context.turns[(context.first + context.count) % TRANSLATION_CONTEXT_RING];
+    turn.source.assign(source);
+    turn.target.assign(target);
+    turn.n_tokens = n_tokens;
+    turn.n_sep = engine->decoder_only && context.count > 0 ? (int)engine->chat_separator.size() : 0;
+    turn.start = context.end;
+    context.count++;
+    context.n_tokens += n_tokens;
+    if (engine->decoder_only) {
+        context.end += n_tokens;
+    }
+}
+
+// Forget every target's context, so the next request starts over (after
+// the warm-up, or when a sequence's cells no longer match its turns)
+static void context_forget(translation_engine_t *engine, size_t t) {
+    engine->contexts[t].source_lang.clear();
+    engine->contexts[t].target_lang.clear();
+}
+
+static void clear_contexts(translation_engine_t *engine) {
+    if (!engine->decoder_only) {
+        llama_memory_clear(llama_get_memory(engine->ctx), true);
+    }
+    for (size_t t = 0; t < TRANSLATION_MAX_TARGETS; t++) {
+        context_reset(engine, t);
+        context_forget(engine, t);
+    }
+}
+
+// Copy a request into the next free slot (engine->queue_mutex held)
+static bool push_request(translation_engine_t *engine, const char *text, const char *source_lang,
+                         const char *const *target_langs, size_t num_targets, void *user_data, bool warm_up) {
+    if (engine->queue_count >= engine->slots.size()) {
+        return false;
+    }
+
+    translation_request &slot = engine->slots[(engine->queue_head + engine->queue_count) % engine->slots.size()];
+    slot.text.assign(text);
+    slot.source_lang.assign(source_lang);
+    for (size_t t = 0; t < num_targets; t++) {
+        slot.target_langs[t].assign(target_langs[t]);
+    }
+    slot.num_targets = num_targets;
+    slot.user_data = user_data;
+    slot.warm_up = warm_up;
+    slot.trace_id = trace_context() ? trace_context() : trace_new_id();
+    slot.trace_queued = trace_begin();
+    slot.timing.queued_ns = trace_now_ns();
+    slot.timing.started_ns = 0;
+    slot.timing.done_ns = 0;
+    engine->queue_count++;
+    metrics_gauge_set(engine->depth_metric, (double)engine->queue_count);
+    return true;
+}
+
+// Hand a finished request's translations to the callback, or end a warm-up
+// request; error replaces every target's text when set
+static void deliver(translation_engine_t *engine, translation_request &req, const char *error) {
+    if (req.warm_up) {
+        // Leave no trace of the warm-up sentence in the context
+        clear_contexts(engine);
+
+        std::lock_guard<std::mutex> lock(engine->queue_mutex);
+        engine->warming = false;
+        engine->warm_up_cv.notify_all();
+        return;
+    }
+
+    req.timing.done_ns = trace_now_ns();
+    metrics_observe(engine->latency_metric, (double)(req.timing.done_ns - req.timing.queued_ns) / 1e6);
+
+    if (engine->callback) {
+        translation_output_t outputs[TRANSLATION_MAX_TARGETS];
+        for (size_t t = 0; t < req.num_targets; t++) {
+            outputs[t].target_lang = req.target_langs[t].c_str();
+            outputs[t].text = error ? error : engine->results[t].c_str();
         }
 
-        tokens.resize(n_tokens);
-        std::cerr << "[Translation] [TOKENIZE] Success - " << n_tokens << " tokens" << std::endl;
+        const uint64_t span = trace_begin();
+        trace_set_context(req.trace_id);
+        engine->callback(outputs, req.num_targets, &req.timing, req.user_data);
+        trace_set_context(0);
+        trace_end("translation_callback", "mt", span, req.trace_id);
+    }
+}
 
-        // Prepare batch for encoder
-        std::cerr << "[Translation] [ENCODE] Preparing batch with " << n_tokens << " tokens..." << std::endl;
-        llama_batch batch = llama_batch_get_one(tokens.data(), n_tokens);
+// Run the encoder or one decoder step with the threads the CPU budget grants
+// now, so translation yields cores to Whisper while both are busy
+static int32_t run_model(translation_engine_t *engine, llama_batch batch, bool encode) {
+    const int n_threads = cpu_budget_acquire(CPU_BUDGET_TRANSLATION, engine->n_threads);
+    llama_set_n_threads(engine->ctx, n_threads, n_threads);
+    int32_t rc;
+    if (encode) {
+        rc = llama_encode(engine->ctx, batch);
+    } else {
+        auto start = std::chrono::steady_clock::now();
+        rc = llama_decode(engine->ctx, batch);
+        if (!engine->current.warm_up) {
+            metrics_observe(engine->token_metric, std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start).count());
+        }
+    }
+    cpu_budget_release(CPU_BUDGET_TRANSLATION, engine->n_threads);
+    return rc;
+}
 
-        // Encode the input prompt (MT5 is encoder-decoder model)
-        std::cerr << "[Translation] [ENCODE] Starting encoder..." << std::endl;
-        if (llama_encode(engine->ctx, batch) != 0) {
-            std::cerr << "[Translation] [ERROR] Encoding failed" << std::endl;
-            if (engine->callback) {
-                engine->callback("[Translation Error]", engine->user_data);
-            }
-            continue;
+// Append one token of sequence seq to batch
+static void batch_add(llama_batch &batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+    batch.token[batch.n_tokens] = token;
+    batch.pos[batch.n_tokens] = pos;
+    batch.n_seq_id[batch.n_tokens] = 1;
+    batch.seq_id[batch.n_tokens][0] = seq;
+    batch.logits[batch.n_tokens] = logits;
+    batch.n_tokens++;
+}
+
+// Token with the highest logit (greedy sampling)
+static llama_token argmax_token(const float *logits, int n_vocab) {
+    llama_token best = 0;
+    float max_logit = logits[0];
+    for (int i = 1; i < n_vocab; i++) {
+        if (logits[i] > max_logit) {
+            max_logit = logits[i];
+            best = i;
         }
-        std::cerr << "[Translation] [ENCODE] Encoding success" << std::endl;
+    }
+    return best;
+}
 
-        // Start decoder with decoder start token (for T5/MT5 encoder-decoder models)
-        std::cerr << "[Translation] [DECODE] Initializing decoder..." << std::endl;
-        llama_token decoder_start_token = llama_model_decoder_start_token(engine->model);
+// Encoder-decoder models: encode every target's T5 prompt in one call and
+// put each target's decoder start token in batch, followed by the
+// translations of its context. Returns false once the request has been
+// answered with an error.
+static bool start_t5(translation_engine_t *engine, translation_request &req, llama_pos *next_pos) {
+    llama_batch &batch = engine->batch;
+    const struct llama_vocab *vocab = llama_model_get_vocab(engine->model);
 
-        if (decoder_start_token < 0) {
-            std::cerr << "[Translation] [ERROR] No decoder start token found for this model" << std::endl;
-            if (engine->callback) {
-                engine->callback("[Translation Error: Invalid model]", req.user_data);
+    // Each target's prompt and prefilled translations get an equal share of
+    // the encoder batch and must leave its decoder room to generate
+    const int share = TRANSLATION_N_CTX / (int)req.num_targets;
+    const int max_forced = std::min(share, TRANSLATION_N_CTX - TRANSLATION_MAX_TOKENS) - 1;
+    int n_forced[TRANSLATION_MAX_TARGETS] = {0};
+
+    // Tokenize each target's T5 prompt into one encoder batch
+    uint64_t span = trace_begin();
+    batch.n_tokens = 0;
+    for (size_t t = 0; t < req.num_targets; t++) {
+        target_context &context = engine->contexts[t];
+        const int offset = batch.n_tokens;
+        int n_tokens;
+        while (true) {
+            build_t5_prompt(engine->prompt, req.text, req.source_lang, req.target_langs[t], context);
+            n_tokens = llama_tokenize(
+                vocab,
+                engine->prompt.c_str(),
+                engine->prompt.size(),
+                batch.token + offset,
+                TRANSLATION_N_CTX - offset,
+                true,  // add_special (BOS token)
+                false  // parse_special
+            );
+            if (context.count == 0) {
+                break;
             }
-            continue;
+
+            build_t5_context(engine->context_text, context);
+            n_forced[t] = llama_tokenize(
+                vocab,
+                engine->context_text.c_str(),
+                engine->context_text.size(),
+                engine->forced[t].data(),
+                (int32_t)engine->forced[t].size(),
+                false,  // add_special: follows the decoder start token
+                false   // parse_special
+            );
+            if (n_tokens >= 0 && n_tokens <= share && n_forced[t] >= 0 && n_forced[t] <= max_forced) {
+                break;
+            }
+
+            // Too long with the whole window: shorten it from the oldest end
+            context_evict(engine, t);
+            n_forced[t] = 0;
+        }
+        LOG_DEBUG("[Translation] [START] Prompt: %s\n", engine->prompt.c_str());
+
+        if (n_tokens < 0) {
+            trace_end("tokenize", "mt", span, req.trace_id);
+            LOG_ERROR("[Translation] [ERROR] Tokenization failed (prompts longer than %d tokens)\n", TRANSLATION_N_CTX);
+            deliver(engine, req, "[Translation Error]");
+            return false;
+        }
+        for (int i = 0; i < n_tokens; i++) {
+            batch_add(batch, batch.token[offset + i], i, (llama_seq_id)t, false);
+        }
+    }
+    trace_end("tokenize", "mt", span, req.trace_id);
+    LOG_DEBUG("[Translation] [TOKENIZE] %d tokens for %zu target(s)\n", batch.n_tokens, req.num_targets);
+
+    // Encode all prompts in one call (MT5 is encoder-decoder model)
+    span = trace_begin();
+    const int32_t encoded = run_model(engine, batch, true);
+    trace_end("llama_encode", "mt", span, req.trace_id);
+    if (encoded != 0) {
+        LOG_ERROR("[Translation] [ERROR] Encoding failed\n");
+        deliver(engine, req, "[Translation Error]");
+        return false;
+    }
+
+    // Start decoder with decoder start token (for T5/MT5 encoder-decoder models)
+    llama_token decoder_start_token = llama_model_decoder_start_token(engine->model);
+    if (decoder_start_token < 0) {
+        LOG_ERROR("[Translation] [ERROR] No decoder start token found for this model\n");
+        deliver(engine, req, "[Translation Error: Invalid model]");
+        return false;
+    }
+
+    // The context's translations are forced decoder input, read in the
+    // same call as the start token
+    batch.n_tokens = 0;
+    for (size_t t = 0; t < req.num_targets; t++) {
+        batch_add(batch, decoder_start_token, 0, (llama_seq_id)t, n_forced[t] == 0);
+        for (int i = 0; i < n_forced[t]; i++) {
+            batch_add(batch, engine->forced[t][i], 1 + i, (llama_seq_id)t, i == n_forced[t] - 1);
+        }
+        next_pos[t] = 1 + n_forced[t];
+    }
+    return true;
+}
+
+// Decoder-only models: put each target's user turn in batch after its copy
+// of the resident prefix and its context's turns, with logits for its last
+// token only. Returns false once the request has been answered with an error.
+static bool start_chat(translation_engine_t *engine, translation_request &req, llama_pos *next_pos) {
+    llama_batch &batch = engine->batch;
+    const struct llama_vocab *vocab = llama_model_get_vocab(engine->model);
+
+    uint64_t span = trace_begin();
+    batch.n_tokens = 0;
+    for (size_t t = 0; t < req.num_targets; t++) {
+        const target_context &context = engine->contexts[t];
+        build_chat_prompt(engine->prompt, req.text, req.source_lang, req.target_langs[t], engine->chat_suffix);
+        LOG_DEBUG("[Translation] [START] Prompt: %s\n", engine->prompt.c_str());
+
+        // After an earlier turn, close its reply and open this user turn
+        const int offset = batch.n_tokens;
+        const int n_sep = context.count > 0 ? (int)engine->chat_separator.size() : 0;
+        if (n_sep > 0 && n_sep < TRANSLATION_N_CTX - offset) {
+            std::copy(engine->chat_separator.begin(), engine->chat_separator.end(), batch.token + offset);
+        }
+        int n_tokens = n_sep < TRANSLATION_N_CTX - offset ? llama_tokenize(
+            vocab,
+            engine->prompt.c_str(),
+            engine->prompt.size(),
+            batch.token + offset + n_sep,
+            TRANSLATION_N_CTX - offset - n_sep,
+            false,  // add_special: the prefix has the BOS token
+            true    // parse_special: the suffix holds the template's turn markers
+        ) : -1;
+        if (n_tokens > 0) {
+            n_tokens += n_sep;
         }
+        if (n_tokens <= 0) {
+            trace_end("tokenize", "mt", span, req.trace_id);
+            LOG_ERROR("[Translation] [ERROR] Tokenization failed (prompts longer than %d tokens)\n", TRANSLATION_N_CTX);
+            deliver(engine, req, "[Translation Error]");
+            return false;
+        }
+        for (int i = 0; i < n_tokens; i++) {
+            batch_add(batch, batch.token[offset + i], context.end + i, (llama_seq_id)t, i == n_tokens - 1);
+        }
+        next_pos[t] = context.end + n_tokens;
+    }
+    trace_end("tokenize", "mt", span, req.trace_id);
+    LOG_DEBUG("[Translation] [TOKENIZE] %d tokens for %zu target(s) after the %d-token prefix\n",
+              batch.n_tokens, req.num_targets, engine->n_prefix);
+    return true;
+}
 
-        std::cerr << "[Translation] [DECODE] Using decoder start token: " << decoder_start_token << std::endl;
-        batch = llama_batch_get_one(&decoder_start_token, 1);
-        if (llama_decode(engine->ctx, batch) != 0) {
-            std::cerr << "[Translation] [ERROR] Initial decoder step failed" << std::endl;
-            if (engine->callback) {
-                engine->callback("[Translation Error]", req.user_data);
+// Worker thread that processes translation requests
+static void translation_worker(translation_engine_t *engine) {
+    translation_request &req = engine->current;
+    llama_batch &batch = engine->batch;
+    const struct llama_vocab *vocab = llama_model_get_vocab(engine->model);
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+
+    trace_thread_name("translation");
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(engine->queue_mutex);
+            engine->queue_cv.wait(lock, [engine] {
+                return engine->queue_count > 0 || engine->shutdown;
+            });
+
+            if (engine->shutdown && engine->queue_count == 0) {
+                break;
             }
+
+            // Take the request's buffers and leave ours in the slot
+            std::swap(req, engine->slots[engine->queue_head]);
+            engine->queue_head = (engine->queue_head + 1) % engine->slots.size();
+            engine->queue_count--;
+            metrics_gauge_set(engine->depth_metric, (double)engine->queue_count);
+        }
+        trace_end("translation_queue_wait", "mt", req.trace_queued, req.trace_id);
+        req.timing.started_ns = trace_now_ns();
+        auto start_time = std::chrono::steady_clock::now();
+
+        // Every target is its own sequence: its decoder only attends to its
+        // own prompt, its own context and its own tokens
+        if (!engine->decoder_only) {
+            llama_memory_clear(llama_get_memory(engine->ctx), true);
+        }
+        for (size_t t = 0; t < req.num_targets; t++) {
+            context_prepare(engine, t, req.source_lang, req.target_langs[t]);
+        }
+
+        // The first decoder call: each target's start token or user turn;
+        // the logits of target step_targets[i] are at batch index step_rows[i]
+        llama_pos next_pos[TRANSLATION_MAX_TARGETS];
+        if (!(engine->decoder_only ? start_chat(engine, req, next_pos) : start_t5(engine, req, next_pos))) {
             continue;
         }
-        std::cerr << "[Translation] [DECODE] Decoder initialized" << std::endl;
+        size_t step_targets[TRANSLATION_MAX_TARGETS];
+        int32_t step_rows[TRANSLATION_MAX_TARGETS];
+        for (size_t t = 0, row = 0; t < req.num_targets; t++) {
+            while (!batch.logits[row]) row++;
+            step_targets[t] = t;
+            step_rows[t] = (int32_t)row++;
+        }
+        int n_rows = (int)req.num_targets;
 
-        // Generate translation (max 256 tokens)
-        std::cerr << "[Translation] [GENERATE] Starting generation (max 256 tokens)..." << std::endl;
-        std::string result;
-        int n_generated = 0;
-        const int max_tokens = 256;
+        // Decode the targets side by side: each decoder call carries one
+        // token of every target still generating, so the weights are read
+        // once per step for all of them
+        uint64_t span = trace_begin();
+        int n_generated[TRANSLATION_MAX_TARGETS] = {0};
+        for (size_t t = 0; t < req.num_targets; t++) {
+            engine->results[t].clear();
+        }
 
-        while (n_generated < max_tokens) {
-            if (n_generated % 10 == 0 && n_generated > 0) {
-                std::cerr << "[Translation] [GENERATE] Progress: " << n_generated << " tokens generated" << std::endl;
+        bool finished[TRANSLATION_MAX_TARGETS] = {false};
+        bool failed = false;
+        int n_steps = 0;
+        int n_total = 0;
+        while (n_rows > 0) {
+            if (run_model(engine, batch, false) != 0) {
+                LOG_ERROR("[Translation] [ERROR] Decode step failed at step %d\n", n_steps);
+                failed = true;
+                break;
             }
-            // Get logits and sample next token (greedy sampling)
-            float * logits = llama_get_logits_ith(engine->ctx, -1);
-            int n_vocab = llama_vocab_n_tokens(vocab);
-
-            // Find token with highest probability (greedy)
-            llama_token new_token = 0;
-            float max_logit = logits[0];
-            for (int i = 1; i < n_vocab; i++) {
-                if (logits[i] > max_logit) {
-                    max_logit = logits[i];
-                    new_token = i;
+            n_steps++;
+
+            // Finished targets drop out of the next step
+            size_t next_targets[TRANSLATION_MAX_TARGETS];
+            batch.n_tokens = 0;
+            for (int row = 0; row < n_rows; row++) {
+                const size_t t = step_targets[row];
+                const llama_token new_token =
+                    argmax_token(llama_get_logits_ith(engine->ctx, step_rows[row]), n_vocab);
+
+                // Check for EOS
+                if (llama_vocab_is_eog(vocab, new_token)) {
+                    finished[t] = true;
+                    continue;
                 }
-            }
 
-            // Check for EOS
-            if (llama_vocab_is_eog(vocab, new_token)) {
-                break;
-            }
+                // Decode token to text
+                char buf[128];
+                int n = llama_token_to_piece(vocab, new_token, buf, sizeof(buf), 0, false);
+                if (n > 0) {
+                    engine->results[t].append(buf, n);
+                }
+                n_generated[t]++;
+                n_total++;
 
-            // Decode token to text
-            char buf[128];
-            int n = llama_token_to_piece(vocab, new_token, buf, sizeof(buf), 0, false);
-            if (n > 0) {
-                result.append(buf, n);
+                if (n_generated[t] < TRANSLATION_MAX_TOKENS) {
+                    next_targets[batch.n_tokens] = t;
+                    step_rows[batch.n_tokens] = batch.n_tokens;
+                    batch_add(batch, new_token, next_pos[t]++, (llama_seq_id)t, true);
+                }
             }
+            n_rows = batch.n_tokens;
+            memcpy(step_targets, next_targets, sizeof(size_t) * n_rows);
+        }
+        trace_end("decode_loop", "mt", span, req.trace_id);
 
-            // Prepare next batch with new token
-            batch = llama_batch_get_one(&new_token, 1);
-            if (llama_decode(engine->ctx, batch) != 0) {
-                std::cerr << "[Translation] [ERROR] Decode step failed at token " << n_generated << std::endl;
-                break;
+        // Chat models tend to open the reply with a space or a newline
+        if (engine->decoder_only) {
+            for (size_t t = 0; t < req.num_targets; t++) {
+                engine->results[t].erase(0, engine->results[t].find_first_not_of(" \n"));
             }
+        }
 
-            n_generated++;
+        // A target that ended its reply keeps the sentence as context; one
+        // cut short has cells that no longer match a whole turn
+        if (engine->context_sentences > 0 && !req.warm_up) {
+            for (size_t t = 0; t < req.num_targets; t++) {
+                if (failed || !finished[t]) {
+                    context_forget(engine, t);
+                    continue;
+                }
+                const target_context &context = engine->contexts[t];
+                const int n_tokens = engine->decoder_only
+                    ? next_pos[t] - context.end
+                    : -llama_tokenize(vocab, req.text.c_str(), req.text.size(), nullptr, 0, false, false) +
+                          n_generated[t];
+                context_add(engine, t, req.text, engine->results[t], n_tokens);
+            }
         }
 
         auto end_time = std::chrono::steady_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
 
-        std::cerr << "[Translation] [COMPLETE] Generated " << n_generated << " tokens in "
-                  << duration.count() << "ms" << std::endl;
-        std::cerr << "[Translation] [RESULT] " << result << std::endl;
-
-        // Invoke callback with result and request-specific user_data
-        if (engine->callback) {
-            std::cerr << "[Translation] [CALLBACK] Invoking callback..." << std::endl;
-            engine->callback(result.c_str(), req.user_data);
-            std::cerr << "[Translation] [CALLBACK] Callback completed" << std::endl;
+        LOG_INFO("[Translation] [COMPLETE] Generated %d tokens for %zu target(s) in %d steps, %lldms\n",
+                n_total, req.num_targets, n_steps, (long long)duration.count());
+        for (size_t t = 0; t < req.num_targets; t++) {
+            LOG_DEBUG("[Translation] [RESULT] %s: %s\n", req.target_langs[t].c_str(), engine->results[t].c_str());
         }
+
+        // Invoke callback with results and request-specific user_data
+        deliver(engine, req, nullptr);
+    }
+
+    LOG_DEBUG("[Translation] [WORKER] Thread exiting\n");
+}
+
+// Format messages with the model's chat template; false if llama.cpp
+// doesn't support the template
+static bool apply_chat_template(const char *tmpl, const llama_chat_message *messages, size_t n_messages,
+                                bool add_ass, std::string &out) {
+    std::vector<char> buf(4096);
+    int32_t len = llama_chat_apply_template(tmpl, messages, n_messages, add_ass, buf.data(), (int32_t)buf.size());
+    if (len > (int32_t)buf.size()) {
+        buf.resize(len);
+        len = llama_chat_apply_template(tmpl, messages, n_messages, add_ass, buf.data(), (int32_t)buf.size());
+    }
+    if (len < 0) {
+        return false;
+    }
+    out.assign(buf.data(), len);
+    return true;
+}
+
+// With context on: find the template text that closes a reply and opens the
+// next user turn, so earlier sentences stay in the cache as chat history
+static void load_chat_separator(translation_engine_t *engine, const char *tmpl) {
+    const llama_chat_message messages[] = {
+        { "system", TRANSLATION_SYSTEM_PROMPT },
+        { "user", TRANSLATION_TEXT_MARKER },
+        { "assistant", TRANSLATION_REPLY_MARKER },
+        { "user", TRANSLATION_TEXT_MARKER },
+    };
+    std::string formatted;
+    size_t reply = std::string::npos;
+    size_t next = std::string::npos;
+    if (apply_chat_template(tmpl, messages, 4, false, formatted)) {
+        reply = formatted.find(TRANSLATION_REPLY_MARKER);
+    }
+    if (reply != std::string::npos) {
+        reply += strlen(TRANSLATION_REPLY_MARKER);
+        next = formatted.find(TRANSLATION_TEXT_MARKER, reply);
+    }
+    int n_tokens = 0;
+    if (next != std::string::npos) {
+        const std::string separator = formatted.substr(reply, next - reply);
+        engine->chat_separator.resize(64);
+        n_tokens = llama_tokenize(llama_model_get_vocab(engine->model), separator.c_str(), separator.size(),
+                                  engine->chat_separator.data(), (int32_t)engine->chat_separator.size(),
+                                  false, true);
+    }
+    if (n_tokens <= 0) {
+        LOG_WARN("[Translation] Chat template has no multi-turn form, context disabled\n");
+        engine->context_sentences = 0;
+        engine->chat_separator.clear();
+        return;
+    }
+    engine->chat_separator.resize(n_tokens);
+}
+
+// Decoder-only models: split the chat template around the user's text and
+// decode the part before it (system prompt, start of the user turn) into
+// TRANSLATION_PREFIX_SEQ, where it stays for every request
+static bool load_chat_prompt(translation_engine_t *engine) {
+    const char *tmpl = llama_model_chat_template(engine->model, nullptr);
+    if (!tmpl) {
+        LOG_ERROR("[Translation] Decoder-only model without a chat template in its metadata\n");
+        return false;
     }
 
-    std::cerr << "[Translation] [WORKER] Thread exiting" << std::endl;
+    const llama_chat_message messages[] = {
+        { "system", TRANSLATION_SYSTEM_PROMPT },
+        { "user", TRANSLATION_TEXT_MARKER },
+    };
+    std::string formatted;
+    if (!apply_chat_template(tmpl, messages, 2, true, formatted)) {
+        LOG_ERROR("[Translation] Chat template not supported by llama.cpp\n");
+        return false;
+    }
+
+    const size_t marker = formatted.find(TRANSLATION_TEXT_MARKER);
+    if (marker == std::string::npos) {
+        LOG_ERROR("[Translation] Chat template dropped the user message\n");
+        return false;
+    }
+    const std::string prefix = formatted.substr(0, marker);
+    engine->chat_suffix = formatted.substr(marker + strlen(TRANSLATION_TEXT_MARKER));
+
+    llama_batch &batch = engine->batch;
+    const int n_tokens = llama_tokenize(llama_model_get_vocab(engine->model), prefix.c_str(), prefix.size(),
+                                        batch.token, TRANSLATION_N_CTX, true, true);
+    if (n_tokens <= 0) {
+        LOG_ERROR("[Translation] Prompt prefix longer than %d tokens\n", TRANSLATION_N_CTX);
+        return false;
+    }
+    batch.n_tokens = 0;
+    for (int i = 0; i < n_tokens; i++) {
+        batch_add(batch, batch.token[i], i, TRANSLATION_PREFIX_SEQ, false);
+    }
+    if (llama_decode(engine->ctx, batch) != 0) {
+        LOG_ERROR("[Translation] Failed to decode the prompt prefix\n");
+        return false;
+    }
+    engine->n_prefix = n_tokens;
+
+    if (engine->context_sentences > 0) {
+        load_chat_separator(engine, tmpl);
+    }
+    return true;
 }
 
 extern "C" {
@@ -240,14 +875,37 @@ translation_engine_t* translation_init(
     translation_callback_t callback,
     void *user_data
 ) {
+    return translation_init_with_params(model_path, nullptr, callback, user_data);
+}
+
+translation_params_t translation_default_params(void) {
+    translation_params_t params;
+    params.memory = model_memory_default_params();
+    params.context_sentences = 0;
+    params.context_tokens = 256;
+    return params;
+}
+
+translation_engine_t* translation_init_with_params(
+    const char *model_path,
+    const translation_params_t *params,
+    translation_callback_t callback,
+    void *user_data
+) {
+    translation_params_t defaults = translation_default_params();
+    if (!params) params = &defaults;
+    const model_memory_params_t *memory = &params->memory;
+
     if (!model_path || !callback) {
-        std::cerr << "[Translation] Invalid parameters" << std::endl;
+        LOG_ERROR("[Translation] Invalid parameters\n");
         return nullptr;
     }
 
     translation_engine_t *engine = new translation_engine_t();
     engine->callback = callback;
     engine->user_data = user_data;
+    engine->context_sentences = std::max(0, std::min(params->context_sentences, TRANSLATION_MAX_CONTEXT));
+    engine->context_tokens = std::max(0, params->context_tokens);
 
     // Initialize llama backend
     llama_backend_init();
@@ -255,34 +913,81 @@ translation_engine_t* translation_init(
     // Load model
     llama_model_params model_params = llama_model_default_params();
     model_params.n_gpu_layers = 99;  // Use GPU if available
+    model_params.use_mmap = memory->mmap;    // llama.cpp prefetches the mapping itself
+    model_params.use_mlock = memory->mlock;
 
     engine->model = llama_model_load_from_file(model_path, model_params);
     if (!engine->model) {
-        std::cerr << "[Translation] Failed to load model: " << model_path << std::endl;
+        LOG_ERROR("[Translation] Failed to load model: %s\n", model_path);
         delete engine;
         return nullptr;
     }
 
+    // T5-style models have an encoder; anything else is prompted as a chat model
+    engine->decoder_only = !llama_model_has_encoder(engine->model);
+    char arch[64] = "unknown";
+    llama_model_meta_val_str(engine->model, "general.architecture", arch, sizeof(arch));
+
     // Create context
     llama_context_params ctx_params = llama_context_default_params();
-    ctx_params.n_ctx = 512;  // Context size for translation
-    ctx_params.n_batch = 512;
-    ctx_params.n_ubatch = 512;
-    ctx_params.n_threads = 4;  // CPU threads
-    ctx_params.n_threads_batch = 4;
+    ctx_params.n_batch = TRANSLATION_N_CTX;
+    ctx_params.n_ubatch = TRANSLATION_N_CTX;  // The encoder takes every prompt in one ubatch
+    if (engine->decoder_only) {
+        // One unified cache, so a target's copy of the prefix shares its
+        // cells: the prefix, every target's user turns (one batch), replies
+        // and context
+        const int context_tokens = engine->context_sentences > 0 ? engine->context_tokens : 0;
+        ctx_params.n_ctx = 2 * TRANSLATION_N_CTX + TRANSLATION_MAX_TARGETS * (TRANSLATION_MAX_TOKENS + context_tokens);
+        ctx_params.n_seq_max = TRANSLATION_MAX_TARGETS + 1;
+        ctx_params.kv_unified = true;
+    } else {
+        ctx_params.n_ctx = TRANSLATION_N_CTX * TRANSLATION_MAX_TARGETS;  // One decoder sequence per target
+        ctx_params.n_seq_max = TRANSLATION_MAX_TARGETS;
+    }
+    engine->n_threads = cpu_budget_total();  // Scaled down per call while Whisper is busy
+    ctx_params.n_threads = engine->n_threads;
+    ctx_params.n_threads_batch = engine->n_threads;
 
     engine->ctx = llama_init_from_model(engine->model, ctx_params);
     if (!engine->ctx) {
-        std::cerr << "[Translation] Failed to create context" << std::endl;
+        LOG_ERROR("[Translation] Failed to create context\n");
+        llama_model_free(engine->model);
+        delete engine;
+        return nullptr;
+    }
+
+    engine->batch = llama_batch_init(TRANSLATION_N_CTX, 0, 1);
+    engine->can_shift = llama_memory_can_shift(llama_get_memory(engine->ctx));
+
+    if (engine->decoder_only && !load_chat_prompt(engine)) {
+        llama_batch_free(engine->batch);
+        llama_free(engine->ctx);
         llama_model_free(engine->model);
         delete engine;
         return nullptr;
     }
 
+    // Weights (mapped or read) and the context's buffers are in place now
+    if (memory->huge_pages != MODEL_HUGE_PAGES_OFF &&
+        !model_memory_apply(memory, TRANSLATION_WEIGHTS_MIN_BYTES)) {
+        LOG_WARN("[Translation] %s\n", model_memory_get_error());
+    }
+
     // Start worker thread
     engine->worker_thread = std::thread(translation_worker, engine);
 
-    std::cerr << "[Translation] Engine initialized with model: " << model_path << std::endl;
+    if (engine->decoder_only) {
+        LOG_INFO("[Translation] Engine initialized with model: %s (%s, decoder-only chat, %d-token prefix resident)\n",
+                model_path, arch, engine->n_prefix);
+    } else {
+        LOG_INFO("[Translation] Engine initialized with model: %s (%s, encoder-decoder)\n", model_path, arch);
+    }
+    if (engine->context_sentences > 0) {
+        LOG_INFO("[Translation] Context: last %d sentence(s), up to %d tokens per target (%s)\n",
+                engine->context_sentences, engine->context_tokens,
+                engine->decoder_only ? (engine->can_shift ? "kept in cache" : "kept in cache, no shifting")
+                                     : "re-encoded");
+    }
 
     return engine;
 }
@@ -291,22 +996,24 @@ bool translation_translate(
     translation_engine_t *engine,
     const char *text,
     const char *source_lang,
-    const char *target_lang,
+    const char *const *target_langs,
+    size_t num_targets,
     void *user_data
 ) {
-    if (!engine || !text || !source_lang || !target_lang) {
+    if (!engine || !text || !source_lang || !target_langs ||
+        num_targets == 0 || num_targets > TRANSLATION_MAX_TARGETS) {
         return false;
     }
-
-    translation_request req;
-    req.text = text;
-    req.source_lang = source_lang;
-    req.target_lang = target_lang;
-    req.user_data = user_data;
+    for (size_t t = 0; t < num_targets; t++) {
+        if (!target_langs[t]) return false;
+    }
 
     {
         std::lock_guard<std::mutex> lock(engine->queue_mutex);
-        engine->request_queue.push(req);
+        if (!push_request(engine, text, source_lang, target_langs, num_targets, user_data, false)) {
+            LOG_WARN("[Translation] Queue full, dropping request\n");
+            return false;
+        }
     }
 
     engine->queue_cv.notify_one();
@@ -314,6 +1021,29 @@ bool translation_translate(
     return true;
 }
 
+bool translation_warm_up(translation_engine_t *engine) {
+    if (!engine) {
+        return false;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    const char *target = "fr";
+    std::unique_lock<std::mutex> lock(engine->queue_mutex);
+    if (!push_request(engine, "Hello, how are you?", "en", &target, 1, nullptr, true)) {
+        return false;
+    }
+    engine->warming = true;
+    engine->queue_cv.notify_one();
+    engine->warm_up_cv.wait(lock, [engine] { return !engine->warming || engine->shutdown; });
+    const bool done = !engine->warming;
+    lock.unlock();
+
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time);
+    LOG_INFO("[Translation] Warm-up: %lldms\n", (long long)duration.count());
+    return done;
+}
+
 bool translation_is_ready(translation_engine_t *engine) {
     return engine && engine->model && engine->ctx;
 }
@@ -327,6 +1057,7 @@ void translation_cleanup(translation_engine_t *engine) {
         engine->shutdown = true;
     }
     engine->queue_cv.notify_one();
+    engine->warm_up_cv.notify_all();
 
     // Wait for worker thread
     if (engine->worker_thread.joinable()) {
@@ -334,6 +1065,9 @@ void translation_cleanup(translation_engine_t *engine) {
     }
 
     // Free llama.cpp resources
+    if (engine->batch.token) {
+        llama_batch_free(engine->batch);
+    }
     if (engine->ctx) {
         llama_free(engine->ctx);
     }
@@ -345,7 +1079,7 @@ void translation_cleanup(translation_engine_t *engine) {
 
     delete engine;
 
-    std::cerr << "[Translation] Engine cleaned up" << std::endl;
+    LOG_INFO("[Translation] Engine cleaned up\n");
 }
 
 }  // extern "C"
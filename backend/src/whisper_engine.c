@@ -169,43 +169,557 @@
 //     return engine->detected_language;
 // }
 #include "whisper_engine.h"
+#include "whisper_mel.h"
+#include "cpu_budget.h"
+#include "logger.h"
+#include "trace.h"
+#include "metrics.h"
 #include "whisper.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <time.h>
 
 /* Platform-specific threading includes */
 #ifdef _WIN32
     #include <windows.h>
     typedef CRITICAL_SECTION pthread_mutex_t;
+    typedef CONDITION_VARIABLE pthread_cond_t;
+    typedef HANDLE pthread_t;
     #define pthread_mutex_init(m, attr) InitializeCriticalSection(m)
     #define pthread_mutex_lock(m) EnterCriticalSection(m)
     #define pthread_mutex_unlock(m) LeaveCriticalSection(m)
     #define pthread_mutex_destroy(m) DeleteCriticalSection(m)
+    #define pthread_cond_init(c, attr) InitializeConditionVariable(c)
+    #define pthread_cond_wait(c, m) SleepConditionVariableCS(c, m, INFINITE)
+    #define pthread_cond_signal(c) WakeConditionVariable(c)
+    #define pthread_cond_broadcast(c) WakeAllConditionVariable(c)
+    #define pthread_cond_destroy(c) ((void)(c))
+    #define pthread_create(t, attr, fn, arg) \
+        ((*(t) = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)(fn), (arg), 0, NULL)) == NULL)
+    #define pthread_join(t, ret) (WaitForSingleObject((t), INFINITE), CloseHandle(t))
 #else
     #include <pthread.h>
+    #include <unistd.h>
 #endif
 
-struct whisper_engine {
+/* Largest transcription delivered per chunk */
+#define WHISPER_MAX_TEXT 4096
+
+/* Results a stream may hold while waiting for an earlier chunk to finish */
+#define WHISPER_REORDER_WINDOW 16
+
+/* Shortest audio past the last chunk that whisper_engine_drain decodes */
+#define WHISPER_DRAIN_MIN_MS 200
+
+/* Completed chunk waiting for in-order delivery */
+typedef struct {
+    bool done;
+    uint64_t trace_id;            /* Chunk id for trace spans */
+    whisper_timing_t timing;      /* delivered_ns is set when the callback runs */
+    char text[WHISPER_MAX_TEXT];  /* Empty when there was no speech or the chunk was dropped */
+} whisper_result_t;
+
+struct whisper_stream {
+    void *user_data;
+    size_t queued;                /* Chunks waiting in the engine queue */
+    size_t running;               /* Chunks being decoded right now */
+    unsigned long next_seq;       /* Sequence number of the next submitted chunk */
+    unsigned long deliver_seq;    /* Sequence number of the next result to deliver */
+    bool delivering;              /* A pool thread is running callbacks for this stream */
+    bool flush;                   /* Dropped chunks left results for a pool thread to deliver */
+    whisper_result_t results[WHISPER_REORDER_WINDOW];
+
+    /* Chunking and incremental log-mel for whisper_engine_stream_push() */
+    float *audio;                 /* Chunk being filled, engine->chunk_capacity */
+    size_t audio_len;
+    unsigned long audio_start;    /* Stream position of audio[0], in samples */
+    uint64_t audio_end_ns;        /* Capture time of the last sample in audio */
+    unsigned long next_frame;     /* Next mel frame to compute; frame f is centered on sample f * hop */
+    float *mel_ring;              /* ring_frames x n_mel log10 frames */
+    unsigned long ring_frames;
+    whisper_mel_t *mel;
+    double mel_ms;                /* Feature extraction spent on the chunk being filled */
+};
+
+/* Weight of the newest chunk in the rolling real-time factor */
+#define WHISPER_RTF_SMOOTHING 0.2
+
+/* Language identification (see identify_language / update_language_estimate) */
+#define WHISPER_LID_MAX_LANGUAGES 128
+#define WHISPER_LID_DECAY 0.8f          /* Weight kept by older evidence per pass */
+#define WHISPER_LID_MIN_PASSES 3        /* Passes before a language can be pinned */
+#define WHISPER_LID_PIN_RATIO 4.0f      /* Leader over runner-up needed to pin */
+#define WHISPER_LID_UNPIN_RATIO 2.0f
+#define WHISPER_LID_RECHECK_S 10        /* Pass interval once pinned */
+
+/* Smallest mapping model_memory_apply treats as weights */
+#define WHISPER_WEIGHTS_MIN_BYTES ((size_t)16 << 20)
+
+/* Longest transcript a split-stage chunk decodes (half the text context, as whisper_full) */
+#define WHISPER_DECODE_MAX_TOKENS 224
+
+/* Room for whisper.cpp's non-speech tokens, with and without a leading space */
+#define WHISPER_MAX_NON_SPEECH 128
+
+/* Pipeline stages a chunk holds in its lane (see stage_enter) */
+#define WHISPER_STAGE_ENCODER 1
+#define WHISPER_STAGE_DECODER 2
+#define WHISPER_STAGE_HYSTERESIS 0.75   /* Encoder threads the ideal split must move by */
+
+/* Jobs allocated up front per stream, enough for a full backlog */
+#define WHISPER_JOBS_PER_STREAM (WHISPER_MAX_PENDING_CHUNKS + 2)
+
+/* A chunk waiting for a pool state; recycled through engine->free_jobs with its buffers */
+typedef struct whisper_job {
+    whisper_stream_t *stream;
+    unsigned long seq;
+    float *samples;               /* Raw chunk unless has_mel */
+    size_t samples_cap;
+    size_t num_samples;
+    float *mel;                   /* Frame-major log10 mel, chunk_frame_count() frames */
+    size_t mel_cap;
+    bool has_mel;                 /* mel holds the precomputed frames */
+    double mel_ms;                /* Feature extraction already spent on this chunk */
+    double audio_ms;              /* New audio the chunk covers (excluding the overlap) */
+    uint64_t trace_id;            /* Ties the chunk's spans together, across threads */
+    uint64_t trace_queued;        /* trace_begin() when queued, 0 when not tracing */
+    whisper_timing_t timing;      /* Capture and stage times, filled in as the chunk advances */
+    struct whisper_job *next;
+} whisper_job_t;
+
+/* A loaded model and one decoder state per pool worker */
+typedef struct {
+    char path[512];
     struct whisper_context *ctx;
+    struct whisper_state *states[WHISPER_MAX_POOL_SIZE];
+    int n_audio_ctx;
+    bool multilingual;
+    char language[8];             /* Pinned language token, empty = engine setting */
+    whisper_token eot;
+    whisper_token blank;          /* " ", -1 if not a single token */
+    whisper_token non_speech[WHISPER_MAX_NON_SPEECH]; /* Suppressed with suppress_nst */
+    int n_non_speech;
+    int primed_ctx[WHISPER_MAX_POOL_SIZE]; /* audio_ctx whisper_full last set on each state, -1 = none */
+    int running;                  /* Chunks decoding on this model right now */
+} whisper_model_t;
+
+/* A pool worker: decodes with state[index] of whichever model is active */
+typedef struct {
+    whisper_engine_t *engine;
+    int index;
+    pthread_t thread;
+    bool started;
+    bool warm_up;                 /* Run a silent chunk before the next job (engine->lock) */
+    whisper_mel_t *mel;           /* Features for chunks queued as raw samples */
+    float *frames;                /* Scratch: frame-major log10 mel */
+    size_t frames_cap;
+    float *mel_input;             /* Scratch: normalized mel handed to the state */
+    size_t mel_input_cap;
+    int mel_input_len;            /* Frames in mel_input for the current chunk */
+    float lid_probs[WHISPER_LID_MAX_LANGUAGES];
+    whisper_token decoded[WHISPER_DECODE_MAX_TOKENS];  /* decode_greedy scratch */
+    int cpu_wanted;               /* Threads asked of the CPU budget for the stages held */
+} whisper_worker_t;
+
+/* A pipeline lane: two workers alternate, one encoding while the other decodes */
+typedef struct {
+    pthread_mutex_t encoder;
+    pthread_mutex_t decoder;
+} whisper_lane_t;
+
+struct whisper_engine {
+    /* Resident models; new chunks go to the active one */
+    whisper_model_t *models[WHISPER_MAX_MODELS];
+    whisper_model_t *active;
     struct whisper_context_params cparams;
+    model_memory_params_t memory;
     struct whisper_full_params wparams;
     transcription_callback_t callback;
     void *user_data;
     pthread_mutex_t lock;
     char detected_language[8];  /* Store detected language code */
     time_t last_detection_time; /* Time of last language detection */
+    float lid_scores[WHISPER_LID_MAX_LANGUAGES]; /* Decayed, confidence-weighted language probabilities */
+    int lid_languages;          /* Languages the models know */
+    int lid_passes;             /* Identification passes folded into lid_scores */
+    int lid_leader;             /* Most likely language id, -1 = no evidence yet */
+    int lid_pinned;             /* Language id chunks decode with, -1 = not confident yet */
+    int n_mel;                  /* Mel bins the model expects */
+    int audio_ctx_granularity;
+    int audio_ctx_guard_ms;
+    size_t chunk_samples;       /* Chunking for whisper_engine_stream_push() */
+    size_t overlap_samples;
+    size_t chunk_capacity;      /* Stream buffers hold chunks up to this length */
+    int beam_size;              /* Current decoding settings (see set_decoding) */
+    bool temperature_fallback;
+    float temperature_inc;      /* whisper.cpp's default fallback step */
+    whisper_engine_stats_t stats;
+    metrics_histogram_t *latency_metric; /* Capture to transcript */
+
+    /* Encoder/decoder pipelining: workers i and i + n_lanes share lane i */
+    bool pipeline;
+    whisper_lane_t lanes[WHISPER_MAX_POOL_SIZE / 2];
+    int n_lanes;
+    int lane_threads;           /* Split between the stages (see balance_stages) */
+    int encoder_threads;
+    double encode_work;         /* Smoothed ms x threads per chunk */
+    double decode_work;
+
+    /* Streams (the default stream backs whisper_engine_process) */
+    whisper_stream_t *streams[WHISPER_MAX_STREAMS];
+    whisper_stream_t *default_stream;
+
+    /* State pool: each worker pulls the next queued chunk from any stream */
+    whisper_worker_t workers[WHISPER_MAX_POOL_SIZE];
+    int pool_size;
+    pthread_cond_t queue_cv;
+    pthread_cond_t done_cv;
+    whisper_job_t *queue_head;
+    whisper_job_t *queue_tail;
+    whisper_job_t *free_jobs;   /* Idle jobs, so steady-state chunking does not allocate */
+    int warming;                /* Workers still warming up (see whisper_engine_warm_up) */
+    bool flush_pending;         /* Some stream has flush set (see enqueue_chunk) */
+    bool shutdown;
 };
 
 static char last_error[256] = {0};
 
+static void* worker_thread(void *arg);
+static void free_job(whisper_job_t *job);
+static void release_job(whisper_engine_t *engine, whisper_job_t *job);
+static void reserve_jobs(whisper_engine_t *engine, int count);
+static void free_stream(whisper_stream_t *stream);
+
+/* Duration of num_samples at WHISPER_SAMPLE_RATE, in ns */
+static uint64_t samples_to_ns(size_t num_samples) {
+    return (uint64_t)num_samples * 1000000000ull / WHISPER_SAMPLE_RATE;
+}
+
+static double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#endif
+}
+
+/* Split the CPU budget between concurrent states and threads per state.
+ * Whisper's kernels stop scaling at around 4 threads, so beyond that it pays
+ * to run more states instead of giving one state more threads. */
+static void tune_pool(const whisper_engine_params_t *params, int *pool_size, int *threads_per_state) {
+    const int cores = cpu_budget_total();
+    int pool = params->pool_size;
+    int threads = params->threads_per_state;
+
+    if (pool <= 0 && threads <= 0) {
+        pool = cores / 4;
+    } else if (pool <= 0) {
+        pool = cores / threads;
+    }
+    if (pool < 1) pool = 1;
+    if (pool > WHISPER_MAX_POOL_SIZE) pool = WHISPER_MAX_POOL_SIZE;
+
+    if (threads <= 0) {
+        threads = cores / pool;
+    }
+    if (threads < 1) threads = 1;
+
+    *pool_size = pool;
+    *threads_per_state = threads;
+    LOG_INFO("[Whisper] State pool: %d x %d threads (%d cores)\n", pool, threads, cores);
+}
+
+whisper_engine_params_t whisper_engine_default_params(void) {
+    whisper_engine_params_t params;
+    params.pool_size = 0;
+    params.threads_per_state = 0;
+    params.chunk_ms = WHISPER_CHUNK_MS_DEFAULT;
+    params.overlap_ms = WHISPER_OVERLAP_MS_DEFAULT;
+    params.audio_ctx_granularity = WHISPER_AUDIO_CTX_GRANULARITY_DEFAULT;
+    params.audio_ctx_guard_ms = WHISPER_AUDIO_CTX_GUARD_MS_DEFAULT;
+    params.beam_size = 1;
+    params.pipeline = false;
+    params.memory = model_memory_default_params();
+    return params;
+}
+
+int whisper_engine_audio_ctx_for(size_t num_samples, int granularity, int guard_ms, int n_audio_ctx) {
+    if (granularity <= 0 || n_audio_ctx <= 0) {
+        return 0;
+    }
+    if (guard_ms < 0) guard_ms = 0;
+
+    const size_t samples_per_pos = (size_t)WHISPER_SAMPLE_RATE * WHISPER_AUDIO_CTX_MS / 1000;
+    size_t positions = (num_samples + samples_per_pos - 1) / samples_per_pos;
+    positions += (size_t)(guard_ms + WHISPER_AUDIO_CTX_MS - 1) / WHISPER_AUDIO_CTX_MS;
+    positions = (positions + granularity - 1) / granularity * granularity;
+
+    /* Close enough to the full window that shrinking buys nothing */
+    if (positions >= (size_t)n_audio_ctx) {
+        return 0;
+    }
+    return (int)positions;
+}
+
+/* Chunk and overlap lengths in samples, on the mel hop grid so that every
+ * chunk starts on a frame boundary; the overlap must cover one FFT window */
+static void tune_chunking(const whisper_engine_params_t *params, size_t *chunk_samples, size_t *overlap_samples) {
+    int chunk_ms = params->chunk_ms > 0 ? params->chunk_ms : WHISPER_CHUNK_MS_DEFAULT;
+    if (chunk_ms > WHISPER_MAX_CHUNK_MS) chunk_ms = WHISPER_MAX_CHUNK_MS;
+    int overlap_ms = params->overlap_ms >= 0 ? params->overlap_ms : WHISPER_OVERLAP_MS_DEFAULT;
+
+    size_t chunk = (size_t)chunk_ms * WHISPER_SAMPLE_RATE / 1000 / WHISPER_MEL_HOP * WHISPER_MEL_HOP;
+    size_t overlap = (size_t)overlap_ms * WHISPER_SAMPLE_RATE / 1000 / WHISPER_MEL_HOP * WHISPER_MEL_HOP;
+    if (chunk < 2 * WHISPER_MEL_N_FFT) chunk = 2 * WHISPER_MEL_N_FFT;
+    if (overlap < WHISPER_MEL_N_FFT) overlap = WHISPER_MEL_N_FFT;
+    if (overlap > chunk - WHISPER_MEL_HOP) overlap = chunk - WHISPER_MEL_HOP;
+
+    *chunk_samples = chunk;
+    *overlap_samples = overlap;
+}
+
+static void stop_workers(whisper_engine_t *engine) {
+    pthread_mutex_lock(&engine->lock);
+    engine->shutdown = true;
+    pthread_cond_broadcast(&engine->queue_cv);
+    pthread_cond_broadcast(&engine->done_cv);
+    pthread_mutex_unlock(&engine->lock);
+
+    for (int i = 0; i < engine->pool_size; i++) {
+        whisper_worker_t *worker = &engine->workers[i];
+        if (worker->started) {
+            pthread_join(worker->thread, NULL);
+            worker->started = false;
+        }
+        whisper_mel_destroy(worker->mel);
+        worker->mel = NULL;
+        free(worker->frames);
+        worker->frames = NULL;
+        free(worker->mel_input);
+        worker->mel_input = NULL;
+    }
+}
+
+static void destroy_lanes(whisper_engine_t *engine) {
+    for (int i = 0; i < engine->n_lanes; i++) {
+        pthread_mutex_destroy(&engine->lanes[i].encoder);
+        pthread_mutex_destroy(&engine->lanes[i].decoder);
+    }
+    engine->n_lanes = 0;
+}
+
+static void free_model(whisper_model_t *model) {
+    if (!model) return;
+    for (int i = 0; i < WHISPER_MAX_POOL_SIZE; i++) {
+        if (model->states[i]) {
+            whisper_free_state(model->states[i]);
+        }
+    }
+    if (model->ctx) {
+        whisper_free(model->ctx);
+    }
+    free(model);
+}
+
+/* whisper_model_loader over a mapped file; whisper.cpp closes it when done */
+static size_t mapped_read(void *ctx, void *output, size_t read_size) {
+    return model_file_read((model_file_t *)ctx, output, read_size);
+}
+
+static bool mapped_eof(void *ctx) {
+    return model_file_eof((const model_file_t *)ctx);
+}
+
+static void mapped_close(void *ctx) {
+    model_file_close((model_file_t *)ctx);
+}
+
+/* Map the file so the kernel reads ahead of the parser; plain reads if mapping fails */
+static struct whisper_context* open_model(whisper_engine_t *engine, const char *path) {
+    model_file_t *file = engine->memory.mmap ? model_file_open(path) : NULL;
+    if (!file) {
+        if (engine->memory.mmap) {
+            LOG_WARN("[Whisper] %s, reading instead\n", model_memory_get_error());
+        }
+        return whisper_init_from_file_with_params_no_state(path, engine->cparams);
+    }
+
+    struct whisper_model_loader loader = { file, mapped_read, mapped_eof, mapped_close };
+    return whisper_init_with_params_no_state(&loader, engine->cparams);
+}
+
+/* Symbols whisper.cpp treats as non-speech (suppress_nst) */
+static const char *non_speech_symbols[] = {
+    "\"", "#", "(", ")", "*", "+", "/", ":", ";", "<", "=", ">", "@", "[", "\\", "]", "^",
+    "_", "`", "{", "|", "}", "~", "「", "」", "『", "』", "<<", ">>", "<<<", ">>>", "--",
+    "---", "-(", "-[", "('", "(\"", "((", "))", "(((", ")))", "[[", "]]", "{{", "}}",
+    "♪♪", "♪♪♪", "♩", "♪", "♫", "♬", "♭", "♮", "♯",
+};
+
+/* The vocabulary token spelling text exactly, or -1 */
+static whisper_token single_token(struct whisper_context *ctx, const char *text) {
+    whisper_token tokens[16];
+    return whisper_tokenize(ctx, text, tokens, 16) == 1 ? tokens[0] : -1;
+}
+
+static void add_non_speech(whisper_model_t *model, const char *text) {
+    whisper_token token = single_token(model->ctx, text);
+    if (token >= 0 && model->n_non_speech < WHISPER_MAX_NON_SPEECH) {
+        model->non_speech[model->n_non_speech++] = token;
+    }
+}
+
+/* Tokens decode_greedy suppresses the way whisper_full's logit filters do */
+static void find_suppressed_tokens(whisper_model_t *model) {
+    model->blank = single_token(model->ctx, " ");
+
+    char text[16];
+    model->n_non_speech = 0;
+    for (size_t i = 0; i < sizeof(non_speech_symbols) / sizeof(non_speech_symbols[0]); i++) {
+        add_non_speech(model, non_speech_symbols[i]);
+        snprintf(text, sizeof(text), " %s", non_speech_symbols[i]);
+        add_non_speech(model, text);
+    }
+
+    /* Hyphens and apostrophes stay allowed inside words */
+    add_non_speech(model, " -");
+    add_non_speech(model, " '");
+}
+
+/* Load weights and one state per pool worker (slow; called without the lock) */
+static whisper_model_t* load_model(whisper_engine_t *engine, const char *path) {
+    whisper_model_t *model = calloc(1, sizeof(whisper_model_t));
+    if (!model) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+    snprintf(model->path, sizeof(model->path), "%s", path);
+
+    LOG_INFO("[Whisper] Loading model: %s\n", path);
+    model->ctx = open_model(engine, path);
+    if (!model->ctx) {
+        snprintf(last_error, sizeof(last_error), "Failed to load model: %s", path);
+        free_model(model);
+        return NULL;
+    }
+    model->n_audio_ctx = whisper_model_n_audio_ctx(model->ctx);
+    model->multilingual = whisper_is_multilingual(model->ctx) != 0;
+    model->eot = whisper_token_eot(model->ctx);
+    find_suppressed_tokens(model);
+    for (int i = 0; i < WHISPER_MAX_POOL_SIZE; i++) {
+        model->primed_ctx[i] = -1;
+    }
+    if (!model->multilingual) {
+        snprintf(model->language, sizeof(model->language), "en");
+    }
+
+    for (int i = 0; i < engine->pool_size; i++) {
+        model->states[i] = whisper_init_state(model->ctx);
+        if (!model->states[i]) {
+            snprintf(last_error, sizeof(last_error), "Failed to create Whisper state %d", i);
+            free_model(model);
+            return NULL;
+        }
+    }
+
+    /* Weights and state buffers are allocated now */
+    if ((engine->memory.huge_pages != MODEL_HUGE_PAGES_OFF || engine->memory.mlock) &&
+        !model_memory_apply(&engine->memory, WHISPER_WEIGHTS_MIN_BYTES)) {
+        LOG_ERROR("[Whisper] %s\n", model_memory_get_error());
+    }
+
+    return model;
+}
+
+/* Resident model by path (engine->lock held) */
+static int find_model(whisper_engine_t *engine, const char *path) {
+    for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+        if (engine->models[i] && strcmp(engine->models[i]->path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Resident multilingual model to detect the language with while a pinned
+ * model is active (engine->lock held) */
+static whisper_model_t* find_detector(whisper_engine_t *engine) {
+    for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+        whisper_model_t *model = engine->models[i];
+        if (model && model->multilingual && model->language[0] == '\0') {
+            return model;
+        }
+    }
+    return NULL;
+}
+
+/* Publish a detected language (engine->lock held) */
+static void record_detection(whisper_engine_t *engine, const char *language, time_t when) {
+    strncpy(engine->detected_language, language, sizeof(engine->detected_language) - 1);
+    engine->detected_language[sizeof(engine->detected_language) - 1] = '\0';
+    engine->last_detection_time = when;
+    engine->stats.detections++;
+}
+
+/* Beam search when beam_size > 1, otherwise greedy. Temperature fallback
+ * re-decodes low-confidence segments at rising temperatures, which can
+ * multiply the decoder cost of a difficult chunk. There is no speculative
+ * mode with a draft model: whisper_decode_with_state only returns the
+ * logits of a batch's last token, so a drafted run can't be verified in
+ * one decoder call. */
+static void set_decoding(whisper_engine_t *engine, int beam_size, bool temperature_fallback) {
+    struct whisper_full_params *wparams = &engine->wparams;
+
+    if (beam_size > 1) {
+        wparams->strategy = WHISPER_SAMPLING_BEAM_SEARCH;
+        wparams->beam_search.beam_size = beam_size;
+    } else {
+        wparams->strategy = WHISPER_SAMPLING_GREEDY;
+        beam_size = 1;
+    }
+    wparams->temperature_inc = temperature_fallback ? engine->temperature_inc : 0.0f;
+
+    engine->beam_size = beam_size;
+    engine->temperature_fallback = temperature_fallback;
+}
+
+/* Account a finished chunk (engine->lock held) */
+static void update_stats(whisper_engine_t *engine, const whisper_job_t *job, double mel_ms, double inference_ms) {
+    whisper_engine_stats_t *stats = &engine->stats;
+
+    stats->chunks++;
+    stats->mel_ms += job->mel_ms + mel_ms;
+    stats->inference_ms += inference_ms;
+    stats->audio_ms += job->audio_ms;
+
+    if (job->audio_ms > 0.0) {
+        double rtf = inference_ms / job->audio_ms;
+        stats->rtf = stats->chunks == 1 ? rtf : stats->rtf + WHISPER_RTF_SMOOTHING * (rtf - stats->rtf);
+    }
+}
+
 whisper_engine_t* whisper_engine_init(const char *model_path, const char *language, transcription_callback_t callback, void *user_data) {
+    return whisper_engine_init_with_params(model_path, language, NULL, callback, user_data);
+}
+
+whisper_engine_t* whisper_engine_init_with_params(const char *model_path, const char *language,
+                                                  const whisper_engine_params_t *params,
+                                                  transcription_callback_t callback, void *user_data) {
     if (!model_path || !callback) {
         snprintf(last_error, sizeof(last_error), "Invalid parameters");
         return NULL;
     }
 
+    whisper_engine_params_t defaults = whisper_engine_default_params();
+    if (!params) params = &defaults;
+
     whisper_engine_t *engine = calloc(1, sizeof(whisper_engine_t));
     if (!engine) {
         snprintf(last_error, sizeof(last_error), "Memory allocation failed");
@@ -215,15 +729,38 @@ whisper_engine_t* whisper_engine_init(const char *model_path, const char *langua
     /* Initialize context parameters */
     engine->cparams = whisper_context_default_params();
     engine->cparams.use_gpu = true;  /* Try to use GPU if available */
+    engine->memory = params->memory;
+    engine->latency_metric = metrics_histogram("capture_to_transcript_ms",
+                                               "Last sample of a chunk captured to its transcript delivered");
+
+    int threads_per_state = 4;
+    tune_pool(params, &engine->pool_size, &threads_per_state);
+
+    /* Pipelining: each lane gets two workers (and states) sharing its threads */
+    if (params->pipeline) {
+        engine->pipeline = true;
+        engine->n_lanes = engine->pool_size < WHISPER_MAX_POOL_SIZE / 2 ? engine->pool_size : WHISPER_MAX_POOL_SIZE / 2;
+        engine->pool_size = 2 * engine->n_lanes;
+        engine->lane_threads = threads_per_state;
+        engine->encoder_threads = threads_per_state > 1 ? (threads_per_state + 1) / 2 : 1;
+        for (int i = 0; i < engine->n_lanes; i++) {
+            pthread_mutex_init(&engine->lanes[i].encoder, NULL);
+            pthread_mutex_init(&engine->lanes[i].decoder, NULL);
+        }
+        LOG_INFO("[Whisper] Pipeline: %d lanes, encoder %d + decoder %d threads\n", engine->n_lanes,
+                engine->encoder_threads, threads_per_state - engine->encoder_threads > 0 ?
+                threads_per_state - engine->encoder_threads : 1);
+    }
 
-    /* Load model */
-    fprintf(stderr, "[Whisper] Loading model: %s\n", model_path);
-    engine->ctx = whisper_init_from_file_with_params(model_path, engine->cparams);
-    if (!engine->ctx) {
-        snprintf(last_error, sizeof(last_error), "Failed to load model: %s", model_path);
+    /* Load model with one state per pool worker */
+    whisper_model_t *model = load_model(engine, model_path);
+    if (!model) {
+        destroy_lanes(engine);
         free(engine);
         return NULL;
     }
+    engine->models[0] = model;
+    engine->active = model;
 
     /* Initialize whisper parameters */
     engine->wparams = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
@@ -235,117 +772,1461 @@ whisper_engine_t* whisper_engine_init(const char *model_path, const char *langua
     /* Set language (NULL = auto-detect) */
     if (language && strlen(language) > 0) {
         engine->wparams.language = language;
-        fprintf(stderr, "[Whisper] Language set to: %s\n", language);
+        LOG_INFO("[Whisper] Language set to: %s\n", language);
     } else {
         engine->wparams.language = NULL;  /* Auto-detect */
-        fprintf(stderr, "[Whisper] Language: auto-detect\n");
+        LOG_INFO("[Whisper] Language: auto-detect\n");
     }
 
-    engine->wparams.n_threads = 4;
+    engine->wparams.n_threads = threads_per_state;
+    engine->n_mel = whisper_model_n_mels(model->ctx);
+    engine->audio_ctx_granularity = params->audio_ctx_granularity;
+    engine->audio_ctx_guard_ms = params->audio_ctx_guard_ms;
+    if (engine->audio_ctx_granularity > 0) {
+        LOG_INFO("[Whisper] Encoder context: segment + %d ms, in steps of %d\n",
+                engine->audio_ctx_guard_ms, engine->audio_ctx_granularity);
+    }
+    tune_chunking(params, &engine->chunk_samples, &engine->overlap_samples);
+    engine->chunk_capacity = 2 * engine->chunk_samples;
+    if (engine->chunk_capacity > (size_t)WHISPER_MAX_CHUNK_MS * WHISPER_SAMPLE_RATE / 1000) {
+        engine->chunk_capacity = (size_t)WHISPER_MAX_CHUNK_MS * WHISPER_SAMPLE_RATE / 1000;
+    }
     engine->wparams.no_context = true;
     engine->wparams.single_segment = false;
+    engine->wparams.no_timestamps = true;  /* Segment times are never read; split-stage chunks decode without them too */
+    engine->temperature_inc = engine->wparams.temperature_inc;
+    set_decoding(engine, params->beam_size, true);
 
     engine->callback = callback;
     engine->user_data = user_data;
     pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->queue_cv, NULL);
+    pthread_cond_init(&engine->done_cv, NULL);
 
     /* Initialize language detection */
     memset(engine->detected_language, 0, sizeof(engine->detected_language));
     engine->last_detection_time = 0;
+    engine->lid_languages = whisper_lang_max_id() + 1;
+    if (engine->lid_languages > WHISPER_LID_MAX_LANGUAGES) {
+        engine->lid_languages = WHISPER_LID_MAX_LANGUAGES;
+    }
+    engine->lid_leader = -1;
+    engine->lid_pinned = -1;
 
-    fprintf(stderr, "[Whisper] Initialized successfully\n");
+    /* Start the pool workers */
+    for (int i = 0; i < engine->pool_size; i++) {
+        whisper_worker_t *worker = &engine->workers[i];
+        worker->engine = engine;
+        worker->index = i;
+        worker->mel = whisper_mel_create(engine->n_mel);
+        if (!worker->mel) {
+            snprintf(last_error, sizeof(last_error), "Unsupported mel bin count: %d", engine->n_mel);
+        } else if (pthread_create(&worker->thread, NULL, worker_thread, worker) != 0) {
+            snprintf(last_error, sizeof(last_error), "Failed to create Whisper worker %d", i);
+        } else {
+            worker->started = true;
+            continue;
+        }
+
+        stop_workers(engine);
+        pthread_cond_destroy(&engine->done_cv);
+        pthread_cond_destroy(&engine->queue_cv);
+        pthread_mutex_destroy(&engine->lock);
+        destroy_lanes(engine);
+        free_model(model);
+        free(engine);
+        return NULL;
+    }
+
+    LOG_INFO("[Whisper] Initialized successfully\n");
     return engine;
 }
 
-bool whisper_engine_process(whisper_engine_t *engine, const float *samples, size_t num_samples) {
-    if (!engine || !samples || num_samples == 0) {
+static void free_stream(whisper_stream_t *stream) {
+    whisper_mel_destroy(stream->mel);
+    free(stream->mel_ring);
+    free(stream->audio);
+    free(stream);
+}
+
+whisper_stream_t* whisper_engine_stream_create(whisper_engine_t *engine, void *user_data) {
+    if (!engine) {
         snprintf(last_error, sizeof(last_error), "Invalid parameters");
-        return false;
+        return NULL;
+    }
+
+    whisper_stream_t *stream = calloc(1, sizeof(whisper_stream_t));
+    if (!stream) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return NULL;
+    }
+    stream->user_data = user_data;
+
+    /* Chunk buffer plus a ring of log-mel frames long enough for one chunk */
+    stream->ring_frames = engine->chunk_capacity / WHISPER_MEL_HOP + 4;
+    stream->audio = malloc(engine->chunk_capacity * sizeof(float));
+    stream->mel_ring = malloc(stream->ring_frames * (size_t)engine->n_mel * sizeof(float));
+    stream->mel = whisper_mel_create(engine->n_mel);
+    if (!stream->audio || !stream->mel_ring || !stream->mel) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        free_stream(stream);
+        return NULL;
     }
 
     pthread_mutex_lock(&engine->lock);
+    int slot = -1;
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (!engine->streams[i]) {
+            engine->streams[i] = stream;
+            slot = i;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
 
-    /* Check if we should detect language (every 20 seconds) */
-    time_t current_time = time(NULL);
-    bool should_detect = (current_time - engine->last_detection_time >= 20);
+    if (slot < 0) {
+        snprintf(last_error, sizeof(last_error), "Too many streams (max %d)", WHISPER_MAX_STREAMS);
+        free_stream(stream);
+        return NULL;
+    }
 
-    /* Run inference */
-    if (whisper_full(engine->ctx, engine->wparams, samples, (int)num_samples) != 0) {
-        pthread_mutex_unlock(&engine->lock);
-        snprintf(last_error, sizeof(last_error), "Whisper inference failed");
+    reserve_jobs(engine, WHISPER_JOBS_PER_STREAM);
+    return stream;
+}
+
+/* Frames a chunk needs: those whisper.cpp computes from the clip itself plus
+ * the ones whose window straddles its end */
+static int chunk_frame_count(size_t num_samples) {
+    return (int)((num_samples + WHISPER_MEL_N_FFT / 2 + WHISPER_MEL_HOP - 1) / WHISPER_MEL_HOP);
+}
+
+/* Make sure a scratch buffer holds count floats */
+static bool reserve_floats(float **buf, size_t *cap, size_t count) {
+    if (*cap >= count) return true;
+    float *grown = realloc(*buf, count * sizeof(float));
+    if (!grown) return false;
+    *buf = grown;
+    *cap = count;
+    return true;
+}
+
+/* Normalize the chunk's log-mel and load it into the worker's state, padded
+ * with silence the way whisper_pcm_to_mel() pads the clip. Only the frames
+ * the encoder reads (2 per position of audio_ctx) are padded. */
+static bool load_chunk_mel(whisper_engine_t *engine, whisper_worker_t *worker, whisper_model_t *model,
+                           whisper_job_t *job, int audio_ctx) {
+    const int n_mel = engine->n_mel;
+    const int n_frames = chunk_frame_count(job->num_samples);
+    int n_len = (int)((job->num_samples + (size_t)WHISPER_SAMPLE_RATE * 30) / WHISPER_MEL_HOP);
+    if (audio_ctx > 0 && 2 * audio_ctx < n_len) {
+        n_len = 2 * audio_ctx > n_frames ? 2 * audio_ctx : n_frames;
+    }
+    const float *frames = job->has_mel ? job->mel : NULL;
+
+    if (!frames) {
+        if (!reserve_floats(&worker->frames, &worker->frames_cap, (size_t)n_frames * n_mel)) {
+            snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+            return false;
+        }
+        for (int i = 0; i < n_frames; i++) {
+            whisper_mel_frame(worker->mel, job->samples, (long)job->num_samples,
+                              (long)i * WHISPER_MEL_HOP, true, worker->frames + (size_t)i * n_mel);
+        }
+        frames = worker->frames;
+    }
+
+    if (!reserve_floats(&worker->mel_input, &worker->mel_input_cap, (size_t)n_len * n_mel)) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        return false;
+    }
+    whisper_mel_normalize(frames, n_frames, n_mel, n_len, worker->mel_input);
+    worker->mel_input_len = n_len;
+
+    if (whisper_set_mel_with_state(model->ctx, model->states[worker->index], worker->mel_input, n_len, n_mel) != 0) {
+        snprintf(last_error, sizeof(last_error), "Failed to set mel spectrogram");
+        return false;
+    }
+    return true;
+}
+
+/* Language probabilities for the chunk just decoded on state: one decoder
+ * step from SOT against the encoder output whisper_full left behind, so no
+ * second encoder pass (whisper_lang_auto_detect re-encodes) */
+static bool identify_language(whisper_engine_t *engine, whisper_model_t *model, struct whisper_state *state,
+                              int n_threads, float *probs) {
+    const whisper_token sot = whisper_token_sot(model->ctx);
+    if (whisper_decode_with_state(model->ctx, state, &sot, 1, 0, n_threads) != 0) {
+        return false;
+    }
+
+    const float *logits = whisper_get_logits_from_state(state);
+    float max_logit = -1e30f;
+    for (int i = 0; i < engine->lid_languages; i++) {
+        probs[i] = logits[whisper_token_lang(model->ctx, i)];
+        if (probs[i] > max_logit) max_logit = probs[i];
+    }
+
+    float sum = 0.0f;
+    for (int i = 0; i < engine->lid_languages; i++) {
+        probs[i] = expf(probs[i] - max_logit);
+        sum += probs[i];
+    }
+    for (int i = 0; i < engine->lid_languages; i++) {
+        probs[i] /= sum;
+    }
+    return true;
+}
+
+/* Language probabilities for the worker's mel_input on the detector model
+ * (a pinned model can't tell languages apart): encoder pass plus one step */
+static bool identify_language_with(whisper_engine_t *engine, whisper_worker_t *worker, whisper_model_t *detector,
+                                   int n_threads, float *probs) {
+    struct whisper_state *state = detector->states[worker->index];
+    if (whisper_set_mel_with_state(detector->ctx, state, worker->mel_input, worker->mel_input_len,
+                                   engine->n_mel) != 0) {
         return false;
     }
+    return whisper_lang_auto_detect_with_state(detector->ctx, state, 0, n_threads, probs) >= 0;
+}
+
+/* Fold one pass into the running estimate, weighted by how sure the pass
+ * was, and pin or release the decoding language (engine->lock held) */
+static void update_language_estimate(whisper_engine_t *engine, const float *probs, time_t when) {
+    float confidence = 0.0f;
+    for (int i = 0; i < engine->lid_languages; i++) {
+        if (probs[i] > confidence) confidence = probs[i];
+    }
+
+    int best = 0;
+    float total = 0.0f;
+    for (int i = 0; i < engine->lid_languages; i++) {
+        engine->lid_scores[i] = WHISPER_LID_DECAY * engine->lid_scores[i] + confidence * probs[i];
+        total += engine->lid_scores[i];
+        if (engine->lid_scores[i] > engine->lid_scores[best]) best = i;
+    }
+    float runner_up = 0.0f;
+    for (int i = 0; i < engine->lid_languages; i++) {
+        if (i != best && engine->lid_scores[i] > runner_up) runner_up = engine->lid_scores[i];
+    }
+    engine->lid_passes++;
+    engine->lid_leader = best;
+    engine->last_detection_time = when;
+
+    const float lead = engine->lid_scores[best];
+    const float share = total > 0.0f ? lead / total : 0.0f;
+    const int pinned = engine->lid_pinned;
+
+    if (pinned >= 0 && (best != pinned || lead < WHISPER_LID_UNPIN_RATIO * runner_up)) {
+        engine->lid_pinned = -1;
+        LOG_INFO("[Whisper] Language uncertain (%s %.0f%%), identifying every chunk\n",
+                whisper_lang_str(best), share * 100.0f);
+    } else if (pinned < 0 && engine->lid_passes >= WHISPER_LID_MIN_PASSES && lead >= WHISPER_LID_PIN_RATIO * runner_up) {
+        engine->lid_pinned = best;
+        LOG_INFO("[Whisper] Language pinned: %s (%.0f%%)\n", whisper_lang_str(best), share * 100.0f);
+    }
+
+    if (engine->lid_pinned >= 0) {
+        record_detection(engine, whisper_lang_str(engine->lid_pinned), when);
+    }
+}
 
-    /* Detect language if it's time */
-    if (should_detect && engine->wparams.language == NULL) {
-        int lang_id = whisper_full_lang_id(engine->ctx);
-        const char* lang_str = whisper_lang_str(lang_id);
-        if (lang_str && strlen(lang_str) > 0) {
-            strncpy(engine->detected_language, lang_str, sizeof(engine->detected_language) - 1);
-            engine->detected_language[sizeof(engine->detected_language) - 1] = '\0';
-            engine->last_detection_time = current_time;
-            fprintf(stderr, "[Whisper] Detected language: %s\n", engine->detected_language);
+/* Greedy choice after whisper_full's logit filters: a blank or end-of-text
+ * first token (suppress_blank), non-speech tokens (suppress_nst), and every
+ * special and timestamp token, which are all numbered above end-of-text */
+static whisper_token greedy_token(const whisper_model_t *model, const struct whisper_full_params *wparams,
+                                  float *logits, bool initial) {
+    if (initial && wparams->suppress_blank) {
+        if (model->blank >= 0) logits[model->blank] = -INFINITY;
+        logits[model->eot] = -INFINITY;
+    }
+    if (wparams->suppress_nst) {
+        for (int i = 0; i < model->n_non_speech; i++) {
+            logits[model->non_speech[i]] = -INFINITY;
         }
     }
 
-    /* Get transcription results */
-    const int n_segments = whisper_full_n_segments(engine->ctx);
-    if (n_segments > 0) {
-        /* Build complete transcription */
-        char transcription[4096] = {0};
-        size_t offset = 0;
+    whisper_token best = 0;
+    for (whisper_token t = 1; t <= model->eot; t++) {
+        if (logits[t] > logits[best]) best = t;
+    }
+    return best;
+}
 
-        for (int i = 0; i < n_segments; i++) {
-            const char *text = whisper_full_get_segment_text(engine->ctx, i);
-            if (text) {
-                size_t len = strlen(text);
-                if (offset + len + 1 < sizeof(transcription)) {
-                    memcpy(transcription + offset, text, len);
-                    offset += len;
-                }
-            }
+/* SOT [language transcribe] no-timestamps */
+static int decoder_prompt(const whisper_model_t *model, const char *language, whisper_token *prompt) {
+    int n = 0;
+    prompt[n++] = whisper_token_sot(model->ctx);
+    if (model->multilingual) {
+        prompt[n++] = whisper_token_lang(model->ctx, whisper_lang_id(language));
+        prompt[n++] = whisper_token_transcribe(model->ctx);
+    }
+    prompt[n++] = whisper_token_not(model->ctx);
+    return n;
+}
+
+/* Run the encoder on the worker's state, at the audio_ctx whisper_full last primed it with */
+static bool encode_chunk(whisper_worker_t *worker, whisper_model_t *model, int n_threads) {
+    if (whisper_encode_with_state(model->ctx, model->states[worker->index], 0, n_threads) != 0) {
+        snprintf(last_error, sizeof(last_error), "Whisper encoder failed");
+        return false;
+    }
+    return true;
+}
+
+/* Greedy decode of the chunk already encoded on the worker's state: whisper_full's
+ * greedy loop and logit filters minus temperature fallback, so with fallback off
+ * both give the same text. whisper_decode only returns the logits of a batch's
+ * last token, so every call ends on the token whose logits we need. */
+static bool decode_greedy(whisper_worker_t *worker, whisper_model_t *model, const struct whisper_full_params *wparams,
+                          int n_threads, char *text, size_t text_size) {
+    struct whisper_state *state = model->states[worker->index];
+    const whisper_token eot = model->eot;
+    whisper_token *out = worker->decoded;
+
+    whisper_token prompt[4];
+    const int n_prompt = decoder_prompt(model, wparams->language, prompt);
+
+    /* Only the prompt's last row matters, so it gets a call of its own */
+    if (whisper_decode_with_state(model->ctx, state, prompt, n_prompt - 1, 0, n_threads) != 0 ||
+        whisper_decode_with_state(model->ctx, state, prompt + n_prompt - 1, 1, n_prompt - 1, n_threads) != 0) {
+        snprintf(last_error, sizeof(last_error), "Whisper decoder failed");
+        return false;
+    }
+    whisper_token next = greedy_token(model, wparams, whisper_get_logits_from_state(state), true);
+
+    int n_out = 0;
+    while (next != eot && n_out < WHISPER_DECODE_MAX_TOKENS) {
+        if (whisper_decode_with_state(model->ctx, state, &next, 1, n_prompt + n_out, n_threads) != 0) {
+            snprintf(last_error, sizeof(last_error), "Whisper decoder failed");
+            return false;
         }
+        out[n_out++] = next;
+        next = greedy_token(model, wparams, whisper_get_logits_from_state(state), false);
+    }
 
-        transcription[offset] = '\0';
+    size_t offset = 0;
+    for (int i = 0; i < n_out && offset + 1 < text_size; i++) {
+        const char *piece = whisper_token_to_str(model->ctx, out[i]);
+        size_t len = piece ? strlen(piece) : 0;
+        if (offset + len + 1 >= text_size) break;
+        memcpy(text + offset, piece, len);
+        offset += len;
+    }
+    text[offset] = '\0';
+    return true;
+}
 
-        /* Trim leading/trailing whitespace */
-        char *start = transcription;
-        while (*start == ' ' || *start == '\t' || *start == '\n') start++;
+/* Take the worker's lane for the given stages (pipeline mode) and return the
+ * threads to run them with, as granted by the CPU budget */
+static int stage_enter(whisper_engine_t *engine, whisper_worker_t *worker, int stages, int n_threads) {
+    if (engine->pipeline) {
+        whisper_lane_t *lane = &engine->lanes[worker->index % engine->n_lanes];
+        if (stages & WHISPER_STAGE_ENCODER) pthread_mutex_lock(&lane->encoder);
+        if (stages & WHISPER_STAGE_DECODER) pthread_mutex_lock(&lane->decoder);
 
-        if (*start != '\0') {
+        if (stages == (WHISPER_STAGE_ENCODER | WHISPER_STAGE_DECODER)) {
+            n_threads = engine->lane_threads;
+        } else {
+            pthread_mutex_lock(&engine->lock);
+            const int encoder_threads = engine->encoder_threads;
             pthread_mutex_unlock(&engine->lock);
-            engine->callback(start, engine->user_data);
-            return true;
+            if (stages == WHISPER_STAGE_ENCODER) n_threads = encoder_threads;
+            else n_threads = engine->lane_threads > encoder_threads ? engine->lane_threads - encoder_threads : 1;
         }
     }
 
-    pthread_mutex_unlock(&engine->lock);
-    return true;  /* No error, just no speech detected */
+    worker->cpu_wanted = n_threads;
+    return cpu_budget_acquire(CPU_BUDGET_ASR, n_threads);
 }
 
-void whisper_engine_cleanup(whisper_engine_t *engine) {
-    if (!engine) return;
+static void stage_leave(whisper_engine_t *engine, whisper_worker_t *worker, int stages) {
+    if (stages == 0) return;
 
-    pthread_mutex_lock(&engine->lock);
+    cpu_budget_release(CPU_BUDGET_ASR, worker->cpu_wanted);
+    if (!engine->pipeline) return;
 
-    if (engine->ctx) {
-        whisper_free(engine->ctx);
+    whisper_lane_t *lane = &engine->lanes[worker->index % engine->n_lanes];
+    if (stages & WHISPER_STAGE_DECODER) pthread_mutex_unlock(&lane->decoder);
+    if (stages & WHISPER_STAGE_ENCODER) pthread_mutex_unlock(&lane->encoder);
+}
+
+/* Give each stage threads in proportion to its work (ms x threads), so
+ * neither waits on the other (engine->lock held) */
+static void balance_stages(whisper_engine_t *engine, double encode_ms, int encode_threads,
+                           double decode_ms, int decode_threads) {
+    const double encode_work = encode_ms * encode_threads;
+    const double decode_work = decode_ms * decode_threads;
+    if (engine->stats.pipelined == 0) {
+        engine->encode_work = encode_work;
+        engine->decode_work = decode_work;
+    } else {
+        engine->encode_work += WHISPER_RTF_SMOOTHING * (encode_work - engine->encode_work);
+        engine->decode_work += WHISPER_RTF_SMOOTHING * (decode_work - engine->decode_work);
     }
+    engine->stats.pipelined++;
+    engine->stats.encode_ms += encode_ms;
+    engine->stats.decode_ms += decode_ms;
 
-    pthread_mutex_unlock(&engine->lock);
-    pthread_mutex_destroy(&engine->lock);
+    if (engine->lane_threads < 2 || engine->encode_work + engine->decode_work <= 0.0) return;
 
-    free(engine);
-    fprintf(stderr, "[Whisper] Cleanup complete\n");
-}
+    /* Hysteresis keeps the split from flapping between neighbours */
+    double ideal = engine->lane_threads * engine->encode_work / (engine->encode_work + engine->decode_work);
+    if (fabs(ideal - engine->encoder_threads) < WHISPER_STAGE_HYSTERESIS) return;
 
-const char* whisper_engine_get_error(void) {
-    return last_error;
+    int threads = (int)(ideal + 0.5);
+    if (threads < 1) threads = 1;
+    if (threads > engine->lane_threads - 1) threads = engine->lane_threads - 1;
+    if (threads != engine->encoder_threads) {
+        engine->encoder_threads = threads;
+        LOG_INFO("[Whisper] Pipeline threads: encoder %d, decoder %d\n",
+                threads, engine->lane_threads - threads);
+    }
 }
 
-const char* whisper_engine_get_detected_language(whisper_engine_t *engine) {
-    if (!engine || engine->detected_language[0] == '\0') {
-        return NULL;
+/* Run one chunk through Whisper on the worker's state of model; text receives the trimmed transcription.
+ * Greedy chunks in a known language can run the encoder and the decoder as
+ * separate stages: in pipeline mode, the two workers of a lane then overlap
+ * one chunk's decoder with the next chunk's encoder. Anything else (beam
+ * search, the first auto-detect chunk, a state not yet primed for this
+ * audio_ctx) runs whisper_full holding both stages. */
+static bool run_chunk(whisper_engine_t *engine, whisper_worker_t *worker, whisper_model_t *model,
+                      whisper_job_t *job, char *text, size_t text_size) {
+    struct whisper_state *state = model->states[worker->index];
+    text[0] = '\0';
+
+    /* Encode only as much of the 30 s window as the chunk needs */
+    const int audio_ctx = whisper_engine_audio_ctx_for(job->num_samples, engine->audio_ctx_granularity,
+                                                       engine->audio_ctx_guard_ms, model->n_audio_ctx);
+
+    /* Features first, timed apart from the model */
+    double t_start = now_ms();
+    uint64_t span = trace_begin();
+    bool loaded = load_chunk_mel(engine, worker, model, job, audio_ctx);
+    trace_end("mel", "asr", span, job->trace_id);
+    double t_mel = now_ms();
+    if (!loaded) {
+        return false;
+    }
+
+    /* Check if we should detect language (every 20 seconds); decoding
+     * settings can change at runtime, so take a snapshot */
+    time_t current_time = time(NULL);
+    pthread_mutex_lock(&engine->lock);
+    struct whisper_full_params wparams = engine->wparams;
+    const bool auto_language = wparams.language == NULL;
+    bool should_detect = false;
+    whisper_model_t *detector = NULL;
+
+    if (model->language[0] != '\0') {
+        /* Pinned models (English-only, per-language fine-tunes) decode with their
+         * own language; a resident multilingual model keeps watching for a change */
+        if (auto_language && (engine->lid_pinned < 0 ||
+                              current_time - engine->last_detection_time >= WHISPER_LID_RECHECK_S)) {
+            detector = find_detector(engine);
+            if (detector) detector->running++;
+        }
+        wparams.language = model->language;
+    } else if (auto_language) {
+        /* Decode with the best estimate so whisper_full skips its own detection
+         * (an extra encoder pass); only the very first chunk runs it */
+        if (engine->lid_pinned >= 0) {
+            wparams.language = whisper_lang_str(engine->lid_pinned);
+            should_detect = current_time - engine->last_detection_time >= WHISPER_LID_RECHECK_S;
+        } else {
+            if (engine->lid_leader >= 0) {
+                wparams.language = whisper_lang_str(engine->lid_leader);
+            }
+            should_detect = true;
+        }
+    }
+
+    /* Pipelining splits the stages for greedy decoding in a known language; the
+     * encoder only honours audio_ctx once whisper_full has set it on a state */
+    const bool split = engine->pipeline && engine->beam_size == 1 && wparams.language != NULL &&
+                       model->primed_ctx[worker->index] == audio_ctx;
+    pthread_mutex_unlock(&engine->lock);
+
+    /* Run inference on the mel already in the state, limited to the chunk's own frames */
+    wparams.duration_ms = whisper_mel_frames_for(job->num_samples) * WHISPER_MEL_HOP * 1000 / WHISPER_SAMPLE_RATE;
+    wparams.audio_ctx = audio_ctx;
+    int rc = 0;
+    int held = 0;
+    int n_threads;
+    double busy_ms;
+
+    if (split) {
+        n_threads = stage_enter(engine, worker, WHISPER_STAGE_ENCODER, wparams.n_threads);
+        const int encode_threads = n_threads;
+        double t_encode = now_ms();
+        span = trace_begin();
+        if (!encode_chunk(worker, model, n_threads)) rc = -1;
+        trace_end("whisper_encode", "asr", span, job->trace_id);
+        double encode_ms = now_ms() - t_encode;
+        stage_leave(engine, worker, WHISPER_STAGE_ENCODER);
+
+        double decode_ms = 0.0;
+        if (rc == 0) {
+            n_threads = stage_enter(engine, worker, WHISPER_STAGE_DECODER, wparams.n_threads);
+            held = WHISPER_STAGE_DECODER;
+            double t_decode = now_ms();
+            span = trace_begin();
+            if (!decode_greedy(worker, model, &wparams, n_threads, text, text_size)) rc = -1;
+            trace_end("whisper_decode", "asr", span, job->trace_id);
+            decode_ms = now_ms() - t_decode;
+
+            if (engine->pipeline) {
+                pthread_mutex_lock(&engine->lock);
+                balance_stages(engine, encode_ms, encode_threads, decode_ms, n_threads);
+                pthread_mutex_unlock(&engine->lock);
+            }
+        }
+
+        /* A lane's throughput is set by its slower stage */
+        busy_ms = engine->pipeline ? (encode_ms > decode_ms ? encode_ms : decode_ms) : encode_ms + decode_ms;
+    } else {
+        n_threads = stage_enter(engine, worker, WHISPER_STAGE_ENCODER | WHISPER_STAGE_DECODER, wparams.n_threads);
+        held = WHISPER_STAGE_ENCODER | WHISPER_STAGE_DECODER;
+        wparams.n_threads = n_threads;
+        double t_full = now_ms();
+        span = trace_begin();
+        rc = whisper_full_with_state(model->ctx, state, wparams, NULL, 0);
+        trace_end("whisper_full", "asr", span, job->trace_id);
+        if (rc == 0) {
+            model->primed_ctx[worker->index] = audio_ctx;
+        } else {
+            snprintf(last_error, sizeof(last_error), "Whisper inference failed");
+        }
+
+        busy_ms = now_ms() - t_full;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    update_stats(engine, job, t_mel - t_start, busy_ms);
+    pthread_mutex_unlock(&engine->lock);
+
+    /* Language identification pass (leaves the decoded segments in place);
+     * it runs the decoder, so it stays in the decoder stage */
+    bool identified = false;
+    span = trace_begin();
+    if (rc == 0 && should_detect) {
+        identified = identify_language(engine, model, state, n_threads, worker->lid_probs);
+    } else if (rc == 0 && detector) {
+        identified = identify_language_with(engine, worker, detector, n_threads, worker->lid_probs);
+    }
+    if (identified) trace_end("language_id", "asr", span, job->trace_id);
+    stage_leave(engine, worker, held);
+
+    pthread_mutex_lock(&engine->lock);
+    if (identified) {
+        update_language_estimate(engine, worker->lid_probs, current_time);
+    }
+    if (detector && --detector->running == 0) {
+        pthread_cond_broadcast(&engine->done_cv);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (rc != 0) {
+        return false;
+    }
+    if (split) {
+        /* decode_greedy wrote the text; trim it like the segments below */
+        size_t skip = strspn(text, " \t\n");
+        memmove(text, text + skip, strlen(text + skip) + 1);
+        return true;
+    }
+
+    /* Get transcription results */
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    if (n_segments > 0) {
+        /* Build complete transcription */
+        char transcription[WHISPER_MAX_TEXT] = {0};
+        size_t offset = 0;
+
+        for (int i = 0; i < n_segments; i++) {
+            const char *segment = whisper_full_get_segment_text_from_state(state, i);
+            if (segment) {
+                size_t len = strlen(segment);
+                if (offset + len + 1 < sizeof(transcription)) {
+                    memcpy(transcription + offset, segment, len);
+                    offset += len;
+                }
+            }
+        }
+
+        transcription[offset] = '\0';
+
+        /* Trim leading/trailing whitespace */
+        char *start = transcription;
+        while (*start == ' ' || *start == '\t' || *start == '\n') start++;
+
+        snprintf(text, text_size, "%s", start);
+    }
+
+    return true;  /* No error, possibly no speech detected */
+}
+
+/* Deliver completed results in order (engine->lock held; released around callbacks) */
+static void deliver_results(whisper_engine_t *engine, whisper_stream_t *stream) {
+    if (stream->delivering) return;  /* The thread already delivering will pick ours up */
+    stream->delivering = true;
+
+    while (stream->deliver_seq != stream->next_seq) {
+        whisper_result_t *result = &stream->results[stream->deliver_seq % WHISPER_REORDER_WINDOW];
+        if (!result->done) break;
+
+        if (result->text[0] != '\0') {
+            result->timing.delivered_ns = trace_now_ns();
+            metrics_observe(engine->latency_metric,
+                            (double)(result->timing.delivered_ns - result->timing.audio_end_ns) / 1e6);
+            pthread_mutex_unlock(&engine->lock);
+            /* Translation and IPC pick the chunk id up from the thread's context */
+            const uint64_t span = trace_begin();
+            trace_set_context(result->trace_id);
+            engine->callback(result->text, &result->timing, stream->user_data);
+            trace_set_context(0);
+            trace_end("transcription_callback", "asr", span, result->trace_id);
+            pthread_mutex_lock(&engine->lock);
+        }
+
+        result->done = false;
+        stream->deliver_seq++;
+    }
+
+    stream->delivering = false;
+    pthread_cond_broadcast(&engine->done_cv);
+}
+
+/* Deliver for the streams enqueue_chunk dropped chunks from (engine->lock held) */
+static void flush_dropped(whisper_engine_t *engine) {
+    engine->flush_pending = false;
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        whisper_stream_t *stream = engine->streams[i];
+        if (stream && stream->flush) {
+            stream->flush = false;
+            deliver_results(engine, stream);
+        }
+    }
+}
+
+/* Run a silent chunk of the current length through the worker's state, so
+ * the first real chunk doesn't pay for first-touch allocations. This also
+ * primes the state for that chunk's audio_ctx. */
+static void warm_up_state(whisper_engine_t *engine, whisper_worker_t *worker, whisper_model_t *model) {
+    pthread_mutex_lock(&engine->lock);
+    struct whisper_full_params wparams = engine->wparams;
+    const size_t num_samples = engine->chunk_samples;
+    pthread_mutex_unlock(&engine->lock);
+
+    whisper_job_t *job = calloc(1, sizeof(whisper_job_t));
+    float *silence = calloc(num_samples, sizeof(float));
+    if (!job || !silence) {
+        free(job);
+        free(silence);
+        return;
+    }
+    job->samples = silence;
+    job->num_samples = num_samples;
+
+    const int audio_ctx = whisper_engine_audio_ctx_for(num_samples, engine->audio_ctx_granularity,
+                                                       engine->audio_ctx_guard_ms, model->n_audio_ctx);
+    if (load_chunk_mel(engine, worker, model, job, audio_ctx)) {
+        /* A fixed language keeps whisper_full from running its own detection */
+        if (model->language[0] != '\0') wparams.language = model->language;
+        else if (!wparams.language) wparams.language = "en";
+        wparams.duration_ms = whisper_mel_frames_for(num_samples) * WHISPER_MEL_HOP * 1000 / WHISPER_SAMPLE_RATE;
+        wparams.audio_ctx = audio_ctx;
+        wparams.n_threads = stage_enter(engine, worker, WHISPER_STAGE_ENCODER | WHISPER_STAGE_DECODER,
+                                        wparams.n_threads);
+
+        if (whisper_full_with_state(model->ctx, model->states[worker->index], wparams, NULL, 0) == 0) {
+            model->primed_ctx[worker->index] = audio_ctx;
+        }
+
+        stage_leave(engine, worker, WHISPER_STAGE_ENCODER | WHISPER_STAGE_DECODER);
+    }
+
+    free_job(job);
+}
+
+static void* worker_thread(void *arg) {
+    whisper_worker_t *worker = (whisper_worker_t*)arg;
+    whisper_engine_t *engine = worker->engine;
+    char *text = malloc(WHISPER_MAX_TEXT);
+    if (!text) return NULL;
+
+    char name[32];
+    snprintf(name, sizeof(name), "whisper:%d", worker->index);
+    trace_thread_name(name);
+
+    pthread_mutex_lock(&engine->lock);
+    while (true) {
+        while (!engine->queue_head && !worker->warm_up && !engine->flush_pending && !engine->shutdown) {
+            pthread_cond_wait(&engine->queue_cv, &engine->lock);
+        }
+        if (engine->shutdown) break;
+
+        if (engine->flush_pending) {
+            flush_dropped(engine);
+            continue;
+        }
+
+        if (worker->warm_up) {
+            whisper_model_t *model = engine->active;
+            model->running++;
+            pthread_mutex_unlock(&engine->lock);
+
+            warm_up_state(engine, worker, model);
+
+            pthread_mutex_lock(&engine->lock);
+            if (--model->running == 0) {
+                pthread_cond_broadcast(&engine->done_cv);
+            }
+            worker->warm_up = false;
+            engine->warming--;
+            pthread_cond_broadcast(&engine->done_cv);
+            continue;
+        }
+
+        whisper_job_t *job = engine->queue_head;
+        engine->queue_head = job->next;
+        if (!engine->queue_head) engine->queue_tail = NULL;
+        whisper_stream_t *stream = job->stream;
+        stream->queued--;
+        stream->running++;
+
+        /* Bind the chunk to the model active now; it stays resident until we finish */
+        whisper_model_t *model = engine->active;
+        model->running++;
+        pthread_mutex_unlock(&engine->lock);
+
+        trace_end("queue_wait", "asr", job->trace_queued, job->trace_id);
+        const uint64_t span = trace_begin();
+        job->timing.started_ns = trace_now_ns();
+        if (!run_chunk(engine, worker, model, job, text, WHISPER_MAX_TEXT)) {
+            LOG_ERROR("[Whisper] %s\n", last_error);
+        }
+        job->timing.done_ns = trace_now_ns();
+        trace_end("chunk", "asr", span, job->trace_id);
+
+        pthread_mutex_lock(&engine->lock);
+        if (--model->running == 0) {
+            pthread_cond_broadcast(&engine->done_cv);
+        }
+        whisper_result_t *result = &stream->results[job->seq % WHISPER_REORDER_WINDOW];
+        snprintf(result->text, sizeof(result->text), "%s", text);
+        result->trace_id = job->trace_id;
+        result->timing = job->timing;
+        result->done = true;
+        stream->running--;
+        deliver_results(engine, stream);
+
+        job->next = engine->free_jobs;
+        engine->free_jobs = job;
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    free(text);
+    return NULL;
+}
+
+/* Unlink the oldest queued job for stream and mark its result slot empty (engine->lock held) */
+static whisper_job_t* dequeue_stream_job(whisper_engine_t *engine, whisper_stream_t *stream) {
+    whisper_job_t *prev = NULL;
+    for (whisper_job_t *job = engine->queue_head; job; prev = job, job = job->next) {
+        if (job->stream != stream) continue;
+
+        if (prev) prev->next = job->next;
+        else engine->queue_head = job->next;
+        if (engine->queue_tail == job) engine->queue_tail = prev;
+        stream->queued--;
+
+        whisper_result_t *result = &stream->results[job->seq % WHISPER_REORDER_WINDOW];
+        result->text[0] = '\0';
+        result->done = true;
+        trace_instant("chunk_dropped", "asr", job->trace_id);
+        return job;
+    }
+    return NULL;
+}
+
+/* Assign the next sequence number and queue a chunk (engine->lock held) */
+static bool enqueue_chunk(whisper_engine_t *engine, whisper_stream_t *stream, whisper_job_t *job,
+                          whisper_job_t **dropped) {
+    *dropped = NULL;
+
+    /* Inference is falling behind: drop this stream's oldest queued chunk.
+     * Its empty result may let later ones out, but callbacks block and this
+     * is the capture thread, so a pool thread delivers them */
+    if (stream->queued >= WHISPER_MAX_PENDING_CHUNKS) {
+        *dropped = dequeue_stream_job(engine, stream);
+        if (*dropped) {
+            engine->stats.dropped++;
+            stream->flush = true;
+            engine->flush_pending = true;
+            pthread_cond_signal(&engine->queue_cv);
+        }
+    }
+
+    /* Results can't be reordered past the window; refuse the chunk */
+    if (stream->next_seq - stream->deliver_seq >= WHISPER_REORDER_WINDOW) {
+        snprintf(last_error, sizeof(last_error), "Inference backlog full");
+        engine->stats.dropped++;
+        return false;
+    }
+
+    job->stream = stream;
+    job->seq = stream->next_seq++;
+    job->trace_queued = trace_begin();
+    job->timing.queued_ns = trace_now_ns();
+    stream->results[job->seq % WHISPER_REORDER_WINDOW].done = false;
+
+    if (engine->queue_tail) engine->queue_tail->next = job;
+    else engine->queue_head = job;
+    engine->queue_tail = job;
+    stream->queued++;
+
+    pthread_cond_signal(&engine->queue_cv);
+    return true;
+}
+
+/* Take an idle job whose buffers hold num_samples samples or mel_floats
+ * mel values; only a job pool still growing, or a longer chunk than any
+ * before, allocates */
+static whisper_job_t* acquire_job(whisper_engine_t *engine, size_t num_samples, size_t mel_floats) {
+    pthread_mutex_lock(&engine->lock);
+    whisper_job_t *job = engine->free_jobs;
+    if (job) engine->free_jobs = job->next;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!job) {
+        job = calloc(1, sizeof(whisper_job_t));
+        if (!job) {
+            snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+            return NULL;
+        }
+    }
+
+    if (!reserve_floats(&job->samples, &job->samples_cap, num_samples) ||
+        !reserve_floats(&job->mel, &job->mel_cap, mel_floats)) {
+        snprintf(last_error, sizeof(last_error), "Memory allocation failed");
+        release_job(engine, job);
+        return NULL;
+    }
+
+    job->stream = NULL;
+    job->seq = 0;
+    job->num_samples = 0;
+    job->has_mel = false;
+    job->mel_ms = 0.0;
+    job->audio_ms = 0.0;
+    job->trace_id = trace_new_id();
+    job->trace_queued = 0;
+    memset(&job->timing, 0, sizeof(job->timing));
+    job->next = NULL;
+    return job;
+}
+
+static void release_job(whisper_engine_t *engine, whisper_job_t *job) {
+    if (!job) return;
+    pthread_mutex_lock(&engine->lock);
+    job->next = engine->free_jobs;
+    engine->free_jobs = job;
+    pthread_mutex_unlock(&engine->lock);
+}
+
+/* Add count idle jobs sized for the longest chunk */
+static void reserve_jobs(whisper_engine_t *engine, int count) {
+    const size_t mel_floats = (size_t)chunk_frame_count(engine->chunk_capacity) * (size_t)engine->n_mel;
+    for (int i = 0; i < count; i++) {
+        whisper_job_t *job = calloc(1, sizeof(whisper_job_t));
+        if (!job) return;
+        if (!reserve_floats(&job->mel, &job->mel_cap, mel_floats)) {
+            free(job);
+            return;
+        }
+        release_job(engine, job);
+    }
+}
+
+static whisper_job_t* create_job(whisper_engine_t *engine, const float *samples, size_t num_samples) {
+    whisper_job_t *job = acquire_job(engine, num_samples, 0);
+    if (!job) return NULL;
+
+    memcpy(job->samples, samples, num_samples * sizeof(float));
+    job->num_samples = num_samples;
+    job->audio_ms = (double)num_samples * 1000.0 / WHISPER_SAMPLE_RATE;
+
+    /* Submitted audio carries no capture time; take it as just captured */
+    job->timing.audio_end_ns = trace_now_ns();
+    job->timing.audio_start_ns = job->timing.audio_end_ns - samples_to_ns(num_samples);
+    return job;
+}
+
+static void free_job(whisper_job_t *job) {
+    if (!job) return;
+    free(job->samples);
+    free(job->mel);
+    free(job);
+}
+
+/* Queue a job, or free it if the stream's backlog is full */
+static bool queue_job(whisper_engine_t *engine, whisper_stream_t *stream, whisper_job_t *job) {
+    whisper_job_t *dropped = NULL;
+    pthread_mutex_lock(&engine->lock);
+    bool queued = enqueue_chunk(engine, stream, job, &dropped);
+    pthread_mutex_unlock(&engine->lock);
+
+    if (dropped) {
+        LOG_WARN("[Whisper] Inference backlog, dropped a queued chunk\n");
+        release_job(engine, dropped);
+    }
+    if (!queued) {
+        release_job(engine, job);
+        return false;
+    }
+
+    return true;
+}
+
+bool whisper_engine_submit(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples) {
+    if (!engine || !stream || !samples || num_samples == 0) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    whisper_job_t *job = create_job(engine, samples, num_samples);
+    if (!job) return false;
+
+    return queue_job(engine, stream, job);
+}
+
+/* Compute every mel frame whose window lies inside the buffered audio */
+static void update_mel_ring(whisper_engine_t *engine, whisper_stream_t *stream) {
+    const unsigned long end = stream->audio_start + stream->audio_len;
+    const size_t n_mel = (size_t)engine->n_mel;
+
+    while (stream->next_frame * WHISPER_MEL_HOP + WHISPER_MEL_N_FFT / 2 <= end) {
+        long center = (long)(stream->next_frame * WHISPER_MEL_HOP - stream->audio_start);
+        float *out = stream->mel_ring + (stream->next_frame % stream->ring_frames) * n_mel;
+        whisper_mel_frame(stream->mel, stream->audio, (long)stream->audio_len, center,
+                          stream->audio_start == 0, out);
+        stream->next_frame++;
+    }
+}
+
+/* Package the full chunk buffer as a job, reusing the frames already in the ring */
+static whisper_job_t* cut_chunk(whisper_engine_t *engine, whisper_stream_t *stream) {
+    const size_t n_mel = (size_t)engine->n_mel;
+    const int n_org = whisper_mel_frames_for(stream->audio_len);
+    const int n_frames = chunk_frame_count(stream->audio_len);
+    const unsigned long first = stream->audio_start / WHISPER_MEL_HOP;
+
+    whisper_job_t *job = acquire_job(engine, 0, (size_t)n_frames * n_mel);
+    if (!job) return NULL;
+    float *mel = job->mel;
+
+    double t_start = now_ms();
+    for (int i = 0; i < n_org; i++) {
+        memcpy(mel + (size_t)i * n_mel, stream->mel_ring + ((first + i) % stream->ring_frames) * n_mel,
+               n_mel * sizeof(float));
+    }
+
+    /* Frames straddling the end see zeros past it, as whisper.cpp pads the clip */
+    for (int i = n_org; i < n_frames; i++) {
+        whisper_mel_frame(stream->mel, stream->audio, (long)stream->audio_len, (long)i * WHISPER_MEL_HOP,
+                          stream->audio_start == 0, mel + (size_t)i * n_mel);
+    }
+
+    job->has_mel = true;
+    job->num_samples = stream->audio_len;
+    job->mel_ms = stream->mel_ms + (now_ms() - t_start);
+    stream->mel_ms = 0.0;
+    return job;
+}
+
+/* Queue the buffered audio as a chunk, then keep all but its first advance
+ * samples; their frames stay in the ring for the next chunk */
+static bool push_chunk(whisper_engine_t *engine, whisper_stream_t *stream, size_t advance) {
+    const uint64_t span = trace_begin();
+    uint64_t chunk_id = 0;
+    bool ok = true;
+    whisper_job_t *job = cut_chunk(engine, stream);
+    if (job) {
+        job->audio_ms = (double)advance * 1000.0 / WHISPER_SAMPLE_RATE;
+        job->timing.audio_end_ns = stream->audio_end_ns;
+        job->timing.audio_start_ns = stream->audio_end_ns - samples_to_ns(advance);
+        chunk_id = job->trace_id;
+    }
+    if (!job || !queue_job(engine, stream, job)) {
+        ok = false;
+    }
+    trace_end("chunk_cut", "asr", span, chunk_id);
+
+    const size_t keep = stream->audio_len - advance;
+    memmove(stream->audio, stream->audio + advance, keep * sizeof(float));
+    stream->audio_start += advance;
+    stream->audio_len = keep;
+    return ok;
+}
+
+bool whisper_engine_stream_push(whisper_engine_t *engine, whisper_stream_t *stream, const float *samples, size_t num_samples,
+                                uint64_t capture_ns) {
+    if (!engine || !stream || !samples) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    /* Chunking can be changed at runtime (whisper_engine_set_chunking) */
+    pthread_mutex_lock(&engine->lock);
+    const size_t chunk_samples = engine->chunk_samples;
+    const size_t overlap_samples = engine->overlap_samples;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (capture_ns == 0) capture_ns = trace_now_ns();
+
+    bool ok = true;
+    while (true) {
+        if (stream->audio_len >= chunk_samples) {
+            /* Keep the overlap for the next chunk */
+            if (!push_chunk(engine, stream, stream->audio_len - overlap_samples)) {
+                ok = false;
+            }
+            continue;
+        }
+        if (num_samples == 0) break;
+
+        size_t room = chunk_samples - stream->audio_len;
+        size_t n = num_samples < room ? num_samples : room;
+
+        memcpy(stream->audio + stream->audio_len, samples, n * sizeof(float));
+        stream->audio_len += n;
+        samples += n;
+        num_samples -= n;
+        stream->audio_end_ns = capture_ns - samples_to_ns(num_samples);
+
+        double t_start = now_ms();
+        update_mel_ring(engine, stream);
+        stream->mel_ms += now_ms() - t_start;
+    }
+
+    return ok;
+}
+
+bool whisper_engine_process(whisper_engine_t *engine, const float *samples, size_t num_samples) {
+    if (!engine || !samples || num_samples == 0) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    /* The default stream is created on first use */
+    if (!engine->default_stream) {
+        engine->default_stream = whisper_engine_stream_create(engine, engine->user_data);
+        if (!engine->default_stream) {
+            return false;
+        }
+    }
+
+    whisper_job_t *job = create_job(engine, samples, num_samples);
+    if (!job) return false;
+
+    /* Queue on the pool and wait until our result has been delivered */
+    whisper_stream_t *stream = engine->default_stream;
+    whisper_job_t *dropped = NULL;
+    pthread_mutex_lock(&engine->lock);
+    bool queued = enqueue_chunk(engine, stream, job, &dropped);
+    if (queued) {
+        unsigned long seq = job->seq;
+        while (stream->deliver_seq <= seq && !engine->shutdown) {
+            pthread_cond_wait(&engine->done_cv, &engine->lock);
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    release_job(engine, dropped);
+    if (!queued) {
+        release_job(engine, job);
+        return false;
+    }
+
+    return true;
+}
+
+/* Remove stream from the engine and free it once no chunk is running on it */
+static void destroy_stream(whisper_engine_t *engine, whisper_stream_t *stream) {
+    pthread_mutex_lock(&engine->lock);
+
+    whisper_job_t *job;
+    while ((job = dequeue_stream_job(engine, stream)) != NULL) {
+        job->next = engine->free_jobs;
+        engine->free_jobs = job;
+    }
+    while ((stream->running > 0 || stream->delivering) && !engine->shutdown) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i] == stream) engine->streams[i] = NULL;
+    }
+    if (engine->default_stream == stream) engine->default_stream = NULL;
+
+    pthread_mutex_unlock(&engine->lock);
+    free_stream(stream);
+}
+
+void whisper_engine_stream_destroy(whisper_engine_t *engine, whisper_stream_t *stream) {
+    if (!engine || !stream) return;
+    destroy_stream(engine, stream);
+}
+
+/* Nothing queued, running or waiting for delivery (engine->lock held) */
+static bool drained(const whisper_engine_t *engine) {
+    if (engine->queue_head || engine->flush_pending) return false;
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        const whisper_stream_t *stream = engine->streams[i];
+        if (stream && (stream->running > 0 || stream->delivering || stream->deliver_seq != stream->next_seq)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void whisper_engine_drain(whisper_engine_t *engine) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    const size_t overlap_samples = engine->overlap_samples;
+    whisper_stream_t *streams[WHISPER_MAX_STREAMS];
+    memcpy(streams, engine->streams, sizeof(streams));
+    pthread_mutex_unlock(&engine->lock);
+
+    /* After the first chunk the buffer starts with overlap already decoded */
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        whisper_stream_t *stream = streams[i];
+        if (!stream) continue;
+        size_t kept = stream->audio_start > 0 ? overlap_samples : 0;
+        if (kept > stream->audio_len) kept = stream->audio_len;
+        const size_t tail = stream->audio_len - kept;
+        if ((double)tail * 1000.0 / WHISPER_SAMPLE_RATE >= WHISPER_DRAIN_MIN_MS) {
+            push_chunk(engine, stream, tail);
+        }
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    while (!drained(engine) && !engine->shutdown) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_cleanup(whisper_engine_t *engine) {
+    if (!engine) return;
+
+    /* Stop the pool; chunks still queued (no whisper_engine_drain) are discarded */
+    stop_workers(engine);
+
+    if (engine->stats.chunks > 0) {
+        LOG_INFO("[Whisper] %lu chunks: features %.1f ms/chunk, inference %.1f ms/chunk\n",
+                engine->stats.chunks, engine->stats.mel_ms / engine->stats.chunks,
+                engine->stats.inference_ms / engine->stats.chunks);
+    }
+    if (engine->stats.pipelined > 0) {
+        LOG_INFO("[Whisper] Pipelined: %lu chunks, encoder %.1f ms/chunk, decoder %.1f ms/chunk\n",
+                engine->stats.pipelined, engine->stats.encode_ms / engine->stats.pipelined,
+                engine->stats.decode_ms / engine->stats.pipelined);
+    }
+
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i]) {
+            destroy_stream(engine, engine->streams[i]);
+        }
+    }
+
+    for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+        free_model(engine->models[i]);
+        engine->models[i] = NULL;
+    }
+
+    while (engine->free_jobs) {
+        whisper_job_t *job = engine->free_jobs;
+        engine->free_jobs = job->next;
+        free_job(job);
+    }
+
+    pthread_cond_destroy(&engine->done_cv);
+    pthread_cond_destroy(&engine->queue_cv);
+    pthread_mutex_destroy(&engine->lock);
+    destroy_lanes(engine);
+
+    free(engine);
+    LOG_INFO("[Whisper] Cleanup complete\n");
+}
+
+bool whisper_engine_warm_up(whisper_engine_t *engine) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    /* Every worker warms its own state, in parallel */
+    double t_start = now_ms();
+    pthread_mutex_lock(&engine->lock);
+    for (int i = 0; i < engine->pool_size; i++) {
+        engine->workers[i].warm_up = true;
+    }
+    engine->warming = engine->pool_size;
+    pthread_cond_broadcast(&engine->queue_cv);
+    while (engine->warming > 0 && !engine->shutdown) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+    const bool done = engine->warming == 0;
+    pthread_mutex_unlock(&engine->lock);
+
+    if (!done) {
+        snprintf(last_error, sizeof(last_error), "Engine shut down during warm-up");
+        return false;
+    }
+    LOG_INFO("[Whisper] Warm-up: %d states in %.0f ms\n", engine->pool_size, now_ms() - t_start);
+    return true;
+}
+
+void whisper_engine_get_stats(whisper_engine_t *engine, whisper_engine_stats_t *stats) {
+    if (!stats) return;
+    memset(stats, 0, sizeof(*stats));
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    *stats = engine->stats;
+    for (whisper_job_t *job = engine->queue_head; job; job = job->next) {
+        stats->queued++;
+    }
+    for (int i = 0; i < WHISPER_MAX_STREAMS; i++) {
+        if (engine->streams[i]) stats->streams++;
+    }
+    stats->pool_size = engine->pipeline ? engine->n_lanes : engine->pool_size;
+    if (engine->pipeline) {
+        stats->encoder_threads = engine->encoder_threads;
+        stats->decoder_threads = engine->lane_threads - engine->encoder_threads > 0 ?
+                                 engine->lane_threads - engine->encoder_threads : 1;
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    /* One stream's real-time factor spread over the pool: above 1.0 the
+     * states can't keep up with the audio arriving on all streams */
+    if (stats->pool_size > 0) {
+        stats->load = stats->rtf * (double)(stats->streams > 0 ? stats->streams : 1) / stats->pool_size;
+    }
+}
+
+bool whisper_engine_load_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    bool resident = find_model(engine, model_path) >= 0;
+    pthread_mutex_unlock(&engine->lock);
+    if (resident) return true;
+
+    /* Load outside the lock: chunks keep decoding on the active model */
+    whisper_model_t *model = load_model(engine, model_path);
+    if (!model) return false;
+
+    if (whisper_model_n_mels(model->ctx) != engine->n_mel) {
+        snprintf(last_error, sizeof(last_error), "Model %s uses %d mel bins, engine uses %d",
+                 model_path, whisper_model_n_mels(model->ctx), engine->n_mel);
+        free_model(model);
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int slot = -1;
+    if (find_model(engine, model_path) < 0) {
+        for (int i = 0; i < WHISPER_MAX_MODELS; i++) {
+            if (!engine->models[i]) {
+                engine->models[i] = model;
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) {
+            snprintf(last_error, sizeof(last_error), "Too many resident models (max %d)", WHISPER_MAX_MODELS);
+        }
+    } else {
+        slot = WHISPER_MAX_MODELS;  /* Loaded concurrently by another caller */
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (slot < 0 || slot == WHISPER_MAX_MODELS) {
+        free_model(model);
+    }
+    return slot >= 0;
+}
+
+bool whisper_engine_use_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int slot = find_model(engine, model_path);
+    if (slot >= 0) {
+        engine->active = engine->models[slot];
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (slot < 0) {
+        snprintf(last_error, sizeof(last_error), "Model not loaded: %s", model_path);
+        return false;
+    }
+    LOG_INFO("[Whisper] Active model: %s\n", model_path);
+    return true;
+}
+
+bool whisper_engine_unload_model(whisper_engine_t *engine, const char *model_path) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int slot = find_model(engine, model_path);
+    whisper_model_t *model = slot >= 0 ? engine->models[slot] : NULL;
+    if (!model || model == engine->active) {
+        pthread_mutex_unlock(&engine->lock);
+        snprintf(last_error, sizeof(last_error), model ? "Model is active: %s" : "Model not loaded: %s",
+                 model_path);
+        return false;
+    }
+
+    /* No new chunk can pick it up; wait for the ones still decoding on it */
+    engine->models[slot] = NULL;
+    while (model->running > 0) {
+        pthread_cond_wait(&engine->done_cv, &engine->lock);
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    free_model(model);
+    LOG_INFO("[Whisper] Unloaded model: %s\n", model_path);
+    return true;
+}
+
+bool whisper_engine_set_model_language(whisper_engine_t *engine, const char *model_path, const char *language) {
+    if (!engine || !model_path) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    int slot = find_model(engine, model_path);
+    if (slot >= 0) {
+        whisper_model_t *model = engine->models[slot];
+        if (model->multilingual) {
+            snprintf(model->language, sizeof(model->language), "%s", language ? language : "");
+        } else if (language && strcmp(language, "en") != 0) {
+            slot = -2;
+        }
+    }
+    pthread_mutex_unlock(&engine->lock);
+
+    if (slot == -2) {
+        snprintf(last_error, sizeof(last_error), "English-only model can't be pinned to %s: %s", language, model_path);
+        return false;
+    }
+    if (slot < 0) {
+        snprintf(last_error, sizeof(last_error), "Model not loaded: %s", model_path);
+        return false;
+    }
+    return true;
+}
+
+bool whisper_engine_model_is_multilingual(whisper_engine_t *engine, const char *model_path) {
+    if (!engine) return false;
+
+    pthread_mutex_lock(&engine->lock);
+    whisper_model_t *model = engine->active;
+    if (model_path) {
+        int slot = find_model(engine, model_path);
+        model = slot >= 0 ? engine->models[slot] : NULL;
+    }
+    bool multilingual = model && model->multilingual && model->language[0] == '\0';
+    pthread_mutex_unlock(&engine->lock);
+    return multilingual;
+}
+
+void whisper_engine_get_model(whisper_engine_t *engine, char *model_path, size_t size) {
+    if (!model_path || size == 0) return;
+    model_path[0] = '\0';
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    snprintf(model_path, size, "%s", engine->active->path);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_set_decoding(whisper_engine_t *engine, int beam_size, bool temperature_fallback) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    set_decoding(engine, beam_size, temperature_fallback);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+void whisper_engine_get_decoding(whisper_engine_t *engine, int *beam_size, bool *temperature_fallback) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    if (beam_size) *beam_size = engine->beam_size;
+    if (temperature_fallback) *temperature_fallback = engine->temperature_fallback;
+    pthread_mutex_unlock(&engine->lock);
+}
+
+bool whisper_engine_set_chunking(whisper_engine_t *engine, int chunk_ms, int overlap_ms) {
+    if (!engine) {
+        snprintf(last_error, sizeof(last_error), "Invalid parameters");
+        return false;
+    }
+
+    whisper_engine_params_t params = whisper_engine_default_params();
+    params.chunk_ms = chunk_ms;
+    params.overlap_ms = overlap_ms;
+
+    size_t chunk_samples, overlap_samples;
+    tune_chunking(&params, &chunk_samples, &overlap_samples);
+    if (chunk_samples > engine->chunk_capacity) {
+        snprintf(last_error, sizeof(last_error), "Chunk length %d ms exceeds the stream buffers", chunk_ms);
+        return false;
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    engine->chunk_samples = chunk_samples;
+    engine->overlap_samples = overlap_samples;
+    pthread_mutex_unlock(&engine->lock);
+    return true;
+}
+
+void whisper_engine_get_chunking(whisper_engine_t *engine, int *chunk_ms, int *overlap_ms) {
+    if (!engine) return;
+
+    pthread_mutex_lock(&engine->lock);
+    if (chunk_ms) *chunk_ms = (int)(engine->chunk_samples * 1000 / WHISPER_SAMPLE_RATE);
+    if (overlap_ms) *overlap_ms = (int)(engine->overlap_samples * 1000 / WHISPER_SAMPLE_RATE);
+    pthread_mutex_unlock(&engine->lock);
+}
+
+int whisper_engine_get_max_chunk_ms(whisper_engine_t *engine) {
+    if (!engine) return 0;
+    return (int)(engine->chunk_capacity * 1000 / WHISPER_SAMPLE_RATE);
+}
+
+const char* whisper_engine_get_error(void) {
+    return last_error;
+}
+
+const char* whisper_engine_get_detected_language(whisper_engine_t *engine) {
+    if (!engine || engine->detected_language[0] == '\0') {
+        return NULL;
     }
     return engine->detected_language;
-}
\ No newline at end of file
+}
@@ -0,0 +1,213 @@
+#include "whisper_mel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MEL_PI 3.14159265358979323846
+#define MEL_SAMPLE_RATE 16000
+#define MEL_N_BINS (WHISPER_MEL_N_FFT / 2 + 1)
+
+/* log10 floor and dynamic range used by whisper.cpp */
+#define MEL_LOG_FLOOR 1e-10
+#define MEL_DYNAMIC_RANGE 8.0f
+
+struct whisper_mel {
+    int n_mel;
+    float window[WHISPER_MEL_N_FFT];        /* Periodic Hann */
+    float cos_table[WHISPER_MEL_N_FFT];
+    float sin_table[WHISPER_MEL_N_FFT];
+    float *filters;                         /* n_mel x MEL_N_BINS */
+    float frame[WHISPER_MEL_N_FFT];
+    float fft_out[2 * WHISPER_MEL_N_FFT];
+    float fft_tmp[2 * WHISPER_MEL_N_FFT];
+    float power[MEL_N_BINS];
+};
+
+/* =================================================================
+ * FFT (same radix-2 / odd-length DFT split as whisper.cpp)
+ * ================================================================= */
+
+/* Complex FFT of a real sequence in[0], in[stride], ... of length n, which
+ * divides WHISPER_MEL_N_FFT. out and tmp hold 2n floats each. */
+static void fft_real(const whisper_mel_t *mel, const float *in, int n, int stride,
+                     float *out, float *tmp) {
+    const int step = WHISPER_MEL_N_FFT / n;
+
+    if (n % 2 == 1) {
+        for (int k = 0; k < n; k++) {
+            float re = 0.0f;
+            float im = 0.0f;
+            for (int j = 0; j < n; j++) {
+                int idx = (k * j * step) % WHISPER_MEL_N_FFT;
+                re += in[j * stride] * mel->cos_table[idx];
+                im -= in[j * stride] * mel->sin_table[idx];
+            }
+            out[2 * k] = re;
+            out[2 * k + 1] = im;
+        }
+        return;
+    }
+
+    const int half = n / 2;
+    fft_real(mel, in, half, stride * 2, out, tmp);
+    fft_real(mel, in + stride, half, stride * 2, out + n, tmp);
+
+    for (int k = 0; k < half; k++) {
+        float c = mel->cos_table[k * step];
+        float s = mel->sin_table[k * step];
+        float ore = out[n + 2 * k];
+        float oim = out[n + 2 * k + 1];
+        float tre = c * ore + s * oim;
+        float tim = c * oim - s * ore;
+
+        tmp[2 * k] = out[2 * k] + tre;
+        tmp[2 * k + 1] = out[2 * k + 1] + tim;
+        tmp[2 * (k + half)] = out[2 * k] - tre;
+        tmp[2 * (k + half) + 1] = out[2 * k + 1] - tim;
+    }
+    memcpy(out, tmp, 2 * (size_t)n * sizeof(float));
+}
+
+/* =================================================================
+ * Slaney mel filterbank (librosa.filters.mel, as shipped in Whisper models)
+ * ================================================================= */
+
+static double hz_to_mel(double hz) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double logstep = log(6.4) / 27.0;
+    if (hz < min_log_hz) return hz / f_sp;
+    return min_log_hz / f_sp + log(hz / min_log_hz) / logstep;
+}
+
+static double mel_to_hz(double m) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = log(6.4) / 27.0;
+    if (m < min_log_mel) return m * f_sp;
+    return min_log_hz * exp(logstep * (m - min_log_mel));
+}
+
+static int build_filters(whisper_mel_t *mel) {
+    const int n_mel = mel->n_mel;
+    double *mel_f = malloc((size_t)(n_mel + 2) * sizeof(double));
+    if (!mel_f) return -1;
+
+    const double mel_max = hz_to_mel(MEL_SAMPLE_RATE / 2.0);
+    for (int i = 0; i < n_mel + 2; i++) {
+        mel_f[i] = mel_to_hz(mel_max * i / (n_mel + 1));
+    }
+
+    for (int i = 0; i < n_mel; i++) {
+        const double enorm = 2.0 / (mel_f[i + 2] - mel_f[i]);
+        for (int k = 0; k < MEL_N_BINS; k++) {
+            double f = (double)k * MEL_SAMPLE_RATE / WHISPER_MEL_N_FFT;
+            double lower = (f - mel_f[i]) / (mel_f[i + 1] - mel_f[i]);
+            double upper = (mel_f[i + 2] - f) / (mel_f[i + 2] - mel_f[i + 1]);
+            double w = lower < upper ? lower : upper;
+            mel->filters[i * MEL_N_BINS + k] = w > 0.0 ? (float)(w * enorm) : 0.0f;
+        }
+    }
+
+    free(mel_f);
+    return 0;
+}
+
+/* =================================================================
+ * Public API
+ * ================================================================= */
+
+whisper_mel_t* whisper_mel_create(int n_mel) {
+    if (n_mel <= 0 || n_mel > WHISPER_MEL_MAX_BINS) {
+        return NULL;
+    }
+
+    whisper_mel_t *mel = calloc(1, sizeof(whisper_mel_t));
+    if (!mel) return NULL;
+
+    mel->n_mel = n_mel;
+    mel->filters = malloc((size_t)n_mel * MEL_N_BINS * sizeof(float));
+    if (!mel->filters || build_filters(mel) != 0) {
+        whisper_mel_destroy(mel);
+        return NULL;
+    }
+
+    for (int i = 0; i < WHISPER_MEL_N_FFT; i++) {
+        double a = 2.0 * MEL_PI * i / WHISPER_MEL_N_FFT;
+        mel->window[i] = (float)(0.5 * (1.0 - cos(a)));
+        mel->cos_table[i] = (float)cos(a);
+        mel->sin_table[i] = (float)sin(a);
+    }
+
+    return mel;
+}
+
+int whisper_mel_n_mel(const whisper_mel_t *mel) {
+    return mel ? mel->n_mel : 0;
+}
+
+void whisper_mel_frame(whisper_mel_t *mel, const float *samples, long num_samples,
+                       long center, bool reflect_start, float *out) {
+    if (!mel || !out) return;
+
+    const long start = center - WHISPER_MEL_N_FFT / 2;
+    for (int i = 0; i < WHISPER_MEL_N_FFT; i++) {
+        long idx = start + i;
+        if (idx < 0 && reflect_start) idx = -idx;
+
+        float s = (samples && idx >= 0 && idx < num_samples) ? samples[idx] : 0.0f;
+        mel->frame[i] = s * mel->window[i];
+    }
+
+    fft_real(mel, mel->frame, WHISPER_MEL_N_FFT, 1, mel->fft_out, mel->fft_tmp);
+
+    for (int k = 0; k < MEL_N_BINS; k++) {
+        float re = mel->fft_out[2 * k];
+        float im = mel->fft_out[2 * k + 1];
+        mel->power[k] = re * re + im * im;
+    }
+
+    for (int i = 0; i < mel->n_mel; i++) {
+        const float *f = mel->filters + (size_t)i * MEL_N_BINS;
+        double sum = 0.0;
+        for (int k = 0; k < MEL_N_BINS; k++) {
+            sum += (double)f[k] * mel->power[k];
+        }
+        out[i] = (float)log10(sum > MEL_LOG_FLOOR ? sum : MEL_LOG_FLOOR);
+    }
+}
+
+int whisper_mel_frames_for(size_t num_samples) {
+    if (num_samples < WHISPER_MEL_N_FFT / 2) return 0;
+    return 1 + (int)((num_samples + WHISPER_MEL_N_FFT / 2 - WHISPER_MEL_N_FFT) / WHISPER_MEL_HOP);
+}
+
+void whisper_mel_normalize(const float *frames, int n_frames, int n_mel, int n_len, float *out) {
+    if (!frames || !out || n_mel <= 0 || n_len < n_frames) return;
+
+    const float silence = (float)log10(MEL_LOG_FLOOR);
+    float mmax = n_len > n_frames ? silence : -1e20f;
+    for (int i = 0; i < n_frames * n_mel; i++) {
+        if (frames[i] > mmax) mmax = frames[i];
+    }
+    const float floor_value = mmax - MEL_DYNAMIC_RANGE;
+
+    for (int j = 0; j < n_mel; j++) {
+        float *row = out + (size_t)j * n_len;
+        for (int i = 0; i < n_frames; i++) {
+            float v = frames[(size_t)i * n_mel + j];
+            row[i] = ((v < floor_value ? floor_value : v) + 4.0f) / 4.0f;
+        }
+        const float pad = ((silence < floor_value ? floor_value : silence) + 4.0f) / 4.0f;
+        for (int i = n_frames; i < n_len; i++) {
+            row[i] = pad;
+        }
+    }
+}
+
+void whisper_mel_destroy(whisper_mel_t *mel) {
+    if (!mel) return;
+    free(mel->filters);
+    free(mel);
+}
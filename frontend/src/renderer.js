@@ -57,7 +57,7 @@ let currentSettings = {
 
 // Caption history state
 const MAX_CAPTION_HISTORY = 4; // Maximum number of caption bubbles to show
-let captionHistory = []; // Array of caption objects {original, translation}
+let captionHistory = []; // Array of caption objects {original, translation, source, id}, newest first
 
 // Translation cache
 const translationCache = new Map();
@@ -111,9 +111,9 @@ function cacheTranslation(text, targetLang, translation) {
 }
 
 // Caption history functions
-function addCaptionToBubbleHistory(text, translation = null) {
+function addCaptionToBubbleHistory(text, translation = null, source = null, id = null) {
     // Add new caption to the beginning of the array
-    captionHistory.unshift({ original: text, translation: translation });
+    captionHistory.unshift({ original: text, translation: translation, source: source, id: id });
 
     // Remove oldest if exceeding limit
     if (captionHistory.length > MAX_CAPTION_HISTORY) {
@@ -221,6 +221,7 @@ function createCaptionBubble(caption, index) {
         translationTextDiv.textContent = caption.translation || 'Translating...';
         translationTextDiv.className = 'subtitle-text translation-caption-text';
         translationTextDiv.style.color = '#4ade80';
+        translationTextDiv.style.whiteSpace = 'pre-line'; // one line per target language
 
         translationRow.appendChild(translationLabel);
         translationRow.appendChild(translationTextDiv);
@@ -254,20 +255,30 @@ function updateCaptionBubble(bubble, caption, index) {
     }
 }
 
-function updateCaptionTranslation(originalText, translation) {
-    // Find the caption in history and update its translation
-    const caption = captionHistory.find(c => c.original === originalText);
+function updateCaptionTranslation(data, translation) {
+    // Find the captions the translation covers and update them. The backend
+    // translates whole sentences, which can span several captions: it sends
+    // the range of transcription ids a sentence came from, and the sentence
+    // goes with the newest caption of the range
+    const captions = data.fragments
+        ? captionHistory.filter(c => c.source === (data.source || null) &&
+            c.id >= data.fragments[0] && c.id <= data.fragments[1])
+        : captionHistory.filter(c => c.original === data.original);
+    const caption = captions[0];
     if (caption) {
-        caption.translation = translation;
+        // A caption can end one sentence and hold all of the next
+        caption.translation = caption.translation && data.fragments && data.fragments[0] === caption.id
+            ? `${caption.translation}\n${translation}`
+            : translation;
         renderCaptionBubbles();
     }
 }
 
-// Update subtitle display
-function showSubtitle(text) {
+// Update subtitle display; source and id name the transcription for its translation
+function showSubtitle(text, source = null, id = null) {
     if (currentSettings.captionHistory) {
         // Multi-bubble mode
-        addCaptionToBubbleHistory(text);
+        addCaptionToBubbleHistory(text, null, source, id);
         subtitleBox.classList.add('hidden');
     } else {
         // Single bubble mode (legacy)
@@ -483,24 +494,31 @@ ipcRenderer.on('transcription', (event, data) => {
         return;
     }
 
-    showSubtitle(data.text);
+    showSubtitle(data.text, data.source || null, data.id || null);
 });
 
 // Handle translation from backend (T5 model)
 ipcRenderer.on('translation', (event, data) => {
-    console.log('[Renderer] Translation:', data.original, '→', data.text);
+    console.log('[Renderer] Translation:', data.original, '→', data.translations || data.text);
+
+    // Several targets arrive in one message: show one "FR: ..." line per language
+    const targets = data.translations ? Object.keys(data.translations) : [];
+    const text = targets.length > 1
+        ? targets.map(lang => `${lang.toUpperCase()}: ${data.translations[lang]}`).join('\n')
+        : data.text;
 
     if (currentSettings.captionHistory) {
         // Update translation in caption history
-        updateCaptionTranslation(data.original, data.text);
+        updateCaptionTranslation(data, text);
     } else {
         // Update translation display in single bubble mode
         if (translationRow.style.display === 'flex') {
-            translationText.textContent = data.text;
+            translationText.textContent = text;
+            translationText.style.whiteSpace = targets.length > 1 ? 'pre-line' : '';
 
             // Cache the translation
             if (currentSettings.targetLang) {
-                cacheTranslation(data.original, currentSettings.targetLang, data.text);
+                cacheTranslation(data.original, currentSettings.targetLang, text);
             }
         }
     }